@@ -0,0 +1,58 @@
+#include "arena.h"
+
+#include <algorithm> // std::max
+#include <cassert>   // assert
+#include <cstdint>   // std::uintptr_t
+
+/*!
+ * \brief Reserva `size_` bytes alinhados em `align_`.
+ * No caso comum, só avança o deslocamento dentro do bloco atual; um novo bloco
+ * (com pelo menos o dobro do tamanho do atual) só é criado se o pedido não cabe.
+ */
+void * Arena::allocate( std::size_t size_, std::size_t align_ )
+{
+    assert( align_ != 0 and ( align_ & ( align_ - 1 ) ) == 0 );
+
+    if ( not m_blocks.empty() )
+    {
+        Block & blk = m_blocks.back();
+        const auto base = reinterpret_cast< std::uintptr_t >( blk.data.get() );
+        const std::size_t offset = ( ( base + m_offset + align_ - 1 ) & ~( align_ - 1 ) ) - base;
+        if ( offset + size_ <= blk.size )
+        {
+            m_offset = offset + size_;
+            return blk.data.get() + offset;
+        }
+    }
+
+    // Não coube: um bloco novo (a memória do `new[]` já vem alinhada para qualquer tipo fundamental).
+    add_block( std::max( size_, m_blocks.empty() ? MIN_BLOCK_SIZE : 2 * m_blocks.back().size ) );
+    m_offset = size_;
+    return m_blocks.back().data.get();
+}
+
+/*!
+ * \brief Descarta tudo o que foi reservado.
+ * Se a última expressão precisou de vários blocos, eles viram um único bloco
+ * com o tamanho total, para que a próxima expressão do mesmo tamanho caiba em
+ * um bloco só.
+ */
+void Arena::reset( void )
+{
+    m_offset = 0;
+    if ( m_blocks.size() > 1 )
+    {
+        const std::size_t total = m_capacity;
+        m_blocks.clear();
+        m_capacity = 0;
+        add_block( total );
+    }
+}
+
+/// Acrescenta um bloco de `size_` bytes.
+void Arena::add_block( std::size_t size_ )
+{
+    m_blocks.push_back( Block{ std::unique_ptr< std::byte[] >( new std::byte[ size_ ] ), size_ } );
+    m_capacity += size_;
+    ++m_block_allocations;
+}
@@ -0,0 +1,83 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <cstddef>     // std::size_t, std::byte
+#include <memory>      // std::unique_ptr
+#include <type_traits> // std::is_trivially_destructible_v
+#include <vector>      // std::vector
+
+/*!
+ * Alocador por arena (*bump allocator*).
+ *
+ * A memória é entregue em sequência, a partir de blocos grandes, e nunca é
+ * liberada individualmente: `reset()` descarta tudo de uma vez, no início de
+ * cada expressão. Se uma expressão precisou de mais de um bloco, os blocos
+ * são trocados por um único bloco com a soma dos tamanhos; assim, depois das
+ * primeiras expressões, a arena tem um só bloco, do tamanho da maior
+ * expressão vista, e não chama mais o alocador global.
+ *
+ * Só serve para tipos trivialmente destrutíveis (os destrutores nunca são chamados).
+ * Cada thread deve usar a sua própria arena.
+ */
+class Arena
+{
+    public:
+        /// Cria a arena; o primeiro bloco só é alocado no primeiro uso.
+        Arena() = default;
+        ~Arena() = default;
+        /// Desligar cópia e atribuição (mover não invalida a memória já entregue).
+        Arena( const Arena & ) = delete;
+        Arena & operator=( const Arena & ) = delete;
+        Arena( Arena && ) = default;
+        Arena & operator=( Arena && ) = default;
+
+        /// Reserva `size_` bytes alinhados em `align_` (uma potência de dois até `alignof( std::max_align_t )`).
+        void * allocate( std::size_t size_, std::size_t align_ );
+
+        /// Reserva espaço (não inicializado) para `n_` objetos do tipo `T`.
+        template < typename T >
+        T * allocate( std::size_t n_ )
+        {
+            static_assert( std::is_trivially_destructible_v< T >, "A arena nunca chama destrutores." );
+            return static_cast< T * >( allocate( n_ * sizeof( T ), alignof( T ) ) );
+        }
+
+        /// Descarta tudo o que foi reservado, mantendo (e juntando) os blocos.
+        void reset( void );
+
+        /// Posição da arena, para `rewind()`.
+        struct Mark
+        {
+            std::size_t blocks; //<! Quantidade de blocos.
+            std::size_t offset; //<! Primeiro byte livre do bloco atual.
+        };
+        /// Posição atual.
+        Mark mark( void ) const { return Mark{ m_blocks.size(), m_offset }; }
+        /// Descarta o que foi reservado depois de `mark_` (nada, se um bloco novo foi criado desde então).
+        void rewind( Mark mark_ ) { if ( mark_.blocks == m_blocks.size() ) m_offset = mark_.offset; }
+
+        /// Total de bytes dos blocos da arena.
+        std::size_t capacity( void ) const { return m_capacity; }
+        /// Quantas vezes a arena chamou o alocador global.
+        std::size_t block_allocations( void ) const { return m_block_allocations; }
+
+    private:
+        /// Um bloco de memória da arena.
+        struct Block
+        {
+            std::unique_ptr< std::byte[] > data; //<! Memória do bloco.
+            std::size_t size;                    //<! Tamanho do bloco, em bytes.
+        };
+
+        static const std::size_t MIN_BLOCK_SIZE = 1 << 12; //<! Tamanho do primeiro bloco.
+
+        std::vector< Block > m_blocks;        //<! Blocos em uso; o último é o atual.
+        std::size_t m_offset = 0;             //<! Primeiro byte livre do bloco atual.
+        std::size_t m_capacity = 0;           //<! Soma dos tamanhos dos blocos.
+        std::size_t m_block_allocations = 0;  //<! Chamadas ao alocador global.
+
+        /// Acrescenta um bloco de pelo menos `size_` bytes.
+        void add_block( std::size_t size_ );
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _BARES_H_
+#define _BARES_H_
+
+#include <algorithm>   // std::copy_n
+#include <cstddef>     // std::size_t
+#include <string_view> // std::string_view
+
+#include "parser.h"
+#include "evaluator.h"
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Avaliação de expressões em tempo de compilação.
+ *
+ * O parser e o evaluator são `constexpr`: `bares::evaluate()` analisa e avalia
+ * uma expressão com o mesmo código do pipeline (`Parser::parse()` seguido de
+ * `Evaluator::evaluate()`), tanto em tempo de execução quanto em `constexpr`.
+ * Em `constexpr` o índice estrutural não é construído (as classes dos
+ * caracteres vêm do lexer do parser) e as pilhas do evaluator não usam a
+ * arena; as regras da gramática e da aritmética são as mesmas.
+ *
+ * `bares::eval< "5 * 10 + 10" >()` faz tudo em tempo de compilação e vale o
+ * resultado da expressão. Uma expressão mal formada (ou com um literal fora
+ * dos limites da política numérica) não compila, e o diagnóstico mostra a
+ * instância `bares::parser_error< código, coluna >`, com o `ParserResult` da
+ * expressão; uma divisão por zero ou um overflow mostra
+ * `bares::evaluator_error< código >`.
+ */
+namespace bares
+{
+    /// Expressão literal usada como argumento de template (`bares::eval< "1 + 2" >()`).
+    template < std::size_t N >
+    struct Literal
+    {
+        char text[ N ]; //<! Caracteres da expressão, com o '\0' final.
+
+        constexpr Literal( const char ( &text_ )[ N ] ) { std::copy_n( text_, N, text ); }
+        /// A expressão, sem o '\0' final.
+        constexpr std::string_view view( void ) const { return std::string_view( text, N - 1 ); }
+    };
+
+    /*!
+     * \brief Analisa e avalia uma expressão, em tempo de compilação ou de execução.
+     * Usa contextos próprios (alocados a cada chamada): para muitas linhas em
+     * tempo de execução, prefira o `LineEvaluator`.
+     * \param expr_ A expressão.
+     * \return O resultado do parsing, o da avaliação e o valor da expressão.
+     */
+    constexpr LineResult evaluate( std::string_view expr_ )
+    {
+        Parser parser;
+        Parser::Context parser_ctx;
+        Evaluator evaluator;
+        Evaluator::Context eval_ctx;
+
+        LineResult result;
+        result.parser_result = parser.parse( expr_, parser_ctx );
+        if ( result.parser_result.type != Parser::ParserResult::PARSER_OK )
+            return result;
+        result.eval_result = evaluator.evaluate( parser_ctx.token_list, eval_ctx );
+        result.value = eval_ctx.final_result;
+        return result;
+    }
+
+    /// Erro de parsing em `eval()`: a instância, no diagnóstico do compilador, mostra o código do erro e a coluna.
+    template < Parser::ParserResult::code_t Error, std::size_t Column >
+    constexpr void parser_error( void )
+    {
+        static_assert( Error == Parser::ParserResult::PARSER_OK,
+                "bares::eval: expressão mal formada (o erro e a coluna estão na instância de bares::parser_error)" );
+    }
+
+    /// Erro de avaliação em `eval()`: a instância, no diagnóstico do compilador, mostra o código do erro.
+    template < Evaluator::EvaluatorResult::code_t Error >
+    constexpr void evaluator_error( void )
+    {
+        static_assert( Error == Evaluator::EvaluatorResult::EVALUATOR_OK,
+                "bares::eval: divisão por zero ou overflow (o erro está na instância de bares::evaluator_error)" );
+    }
+
+    /*!
+     * \brief Avalia a expressão `Expr` em tempo de compilação.
+     * Erros de parsing e de avaliação são erros de compilação (veja `parser_error` e `evaluator_error`).
+     * \return O valor da expressão.
+     */
+    template < Literal Expr >
+    consteval Evaluator::result_t eval( void )
+    {
+        constexpr LineResult result = evaluate( Expr.view() );
+        parser_error< result.parser_result.type, result.parser_result.at_col >();
+        evaluator_error< result.eval_result.type >();
+        return result.value;
+    }
+}
+
+#endif
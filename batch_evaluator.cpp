@@ -0,0 +1,156 @@
+#include "batch_evaluator.h"
+#include "stats.h"
+
+/*!
+ * \brief Avalia um lote: agrupa as linhas pela forma e avalia cada grupo de uma vez.
+ *
+ * Erros de parsing vão direto para o resultado da linha. As demais linhas
+ * entram no grupo da sua forma pósfixa (ou, se são longas demais, são
+ * avaliadas na hora). Para não converter cada linha para pósfixa, as linhas
+ * curtas (até `MAX_INFIX` tokens) são reconhecidas pela forma infixa: só a
+ * primeira linha de cada forma infixa do lote é convertida, e as demais vão
+ * direto para o mesmo grupo. Os literais aparecem na mesma ordem nas duas
+ * formas (a conversão só move operadores), então são copiados da lista
+ * infixa. Depois que o lote inteiro foi lido, cada grupo é avaliado e os
+ * resultados são escritos nas posições das suas linhas.
+ */
+void BatchEvaluator::evaluate( std::span< const std::string_view > lines_, std::span< LineResult > results_ )
+{
+    assert( results_.size() == lines_.size() );
+
+    m_infix_index.clear();
+    m_index.clear();
+    m_n_groups = 0;
+    m_batched = 0;
+
+    for ( std::size_t i( 0 ); i < lines_.size(); ++i )
+    {
+        LineResult & result = results_[ i ];
+        result = LineResult();
+        result.parser_result = m_parser.parse( lines_[ i ], m_parser_ctx );
+        if ( result.parser_result.type != Parser::ParserResult::PARSER_OK )
+            continue;
+
+        StageTimer timer( Stats::CONVERT );
+        const auto & tokens = m_parser_ctx.token_list;
+        std::size_t g;
+        if ( tokens.size() <= MAX_INFIX )
+        {
+            // Assinatura infixa: 4 bits por token (o símbolo, ou 15 para um literal).
+            std::uint64_t shape = 0;
+            for ( const auto & tk : tokens )
+                shape = shape << 4 | ( tk.type == Token::OPERAND ? 15u : static_cast< unsigned >( tk.symbol ) );
+            auto [ it, inserted ] = m_infix_index.try_emplace( shape, 0 );
+            if ( inserted )
+            {
+                convert();
+                it->second = group();
+            }
+            g = it->second;
+        }
+        else
+        {
+            convert();
+            if ( m_eval_ctx.postfix_expr.size() > MAX_SHAPE )
+            {
+                // Longa demais para ter assinatura: avaliada como no pipeline.
+                m_evaluator.optimize_postfix( m_eval_ctx );
+                result.value = m_evaluator.evaluate_postfix( m_eval_ctx.postfix_expr, m_eval_ctx );
+                result.eval_result = m_eval_ctx.curr_status;
+                continue;
+            }
+            g = group();
+        }
+
+        Group & group = m_groups[ g ];
+        group.lines.push_back( i );
+        std::size_t k = 0;
+        for ( const auto & tk : tokens )
+            if ( tk.type == Token::OPERAND ) group.columns[ k++ ].push_back( tk.value );
+    }
+
+    StageTimer timer( Stats::EVALUATE );
+    for ( std::size_t g( 0 ); g < m_n_groups; ++g )
+        run( m_groups[ g ], results_ );
+}
+
+/// Converte a lista de tokens da linha atual para pósfixa, no contexto do evaluator.
+void BatchEvaluator::convert( void )
+{
+    const auto & tokens = m_parser_ctx.token_list;
+    m_eval_ctx.curr_status = Evaluator::EvaluatorResult();
+    m_eval_ctx.prepare( tokens.size() );
+    m_evaluator.infix_to_postfix( tokens, m_eval_ctx );
+}
+
+/*!
+ * \brief Encontra (ou cria) o grupo da forma da expressão pósfixa do contexto.
+ * A assinatura tem 3 bits por token pósfixo: o símbolo de cada operador (de 1
+ * a 6) ou 7 para um literal. Como nenhum token vale 0, formas de tamanhos
+ * diferentes nunca têm a mesma assinatura. O programa de um grupo novo é
+ * gerado aqui, com o k-ésimo literal trocado pela variável k.
+ * \return A posição do grupo em `m_groups`.
+ */
+std::size_t BatchEvaluator::group( void )
+{
+    const auto & postfix = m_eval_ctx.postfix_expr;
+    assert( postfix.size() <= MAX_SHAPE );
+    std::uint64_t shape = 0;
+    for ( const auto & tk : postfix )
+        shape = shape << 3 | ( tk.type == Token::OPERAND ? 7u : static_cast< unsigned >( tk.symbol ) );
+
+    auto [ it, inserted ] = m_index.try_emplace( shape, m_n_groups );
+    if ( not inserted ) return it->second;
+
+    if ( m_n_groups == m_groups.size() ) m_groups.emplace_back();
+    Group & group = m_groups[ m_n_groups++ ];
+    group.lines.clear();
+    group.program.clear();
+    value_type k = 0;
+    for ( const auto & tk : postfix )
+    {
+        if ( tk.type == Token::OPERAND ) group.program.emit( Token( Token::VARIABLE, Token::NONE, k++ ) );
+        else group.program.emit( tk );
+    }
+    group.program.finish();
+    group.columns.resize( static_cast< std::size_t >( k ) );
+    for ( auto & col : group.columns ) col.clear();
+    return it->second;
+}
+
+/*!
+ * \brief Avalia as linhas de um grupo e escreve os resultados nas posições delas.
+ * Grupos grandes vão para o `ColumnEvaluator`; grupos com menos de
+ * `MIN_GROUP` linhas executam o programa uma linha por vez.
+ */
+void BatchEvaluator::run( Group & group_, std::span< LineResult > results_ )
+{
+    const std::size_t rows = group_.lines.size();
+    m_values.resize( rows );
+    m_status.resize( rows );
+
+    if ( rows >= MIN_GROUP )
+    {
+        m_spans.assign( group_.columns.begin(), group_.columns.end() );
+        m_columns.evaluate( group_.program, m_spans, m_values, m_status );
+        m_batched += rows;
+    }
+    else
+    {
+        m_stack.resize( group_.program.max_depth() );
+        m_row.resize( group_.columns.size() );
+        for ( std::size_t r( 0 ); r < rows; ++r )
+        {
+            for ( std::size_t k( 0 ); k < m_row.size(); ++k ) m_row[ k ] = group_.columns[ k ][ r ];
+            m_values[ r ] = 0;
+            m_status[ r ] = group_.program.run( m_values[ r ], m_stack, m_row ).type;
+        }
+    }
+
+    for ( std::size_t r( 0 ); r < rows; ++r )
+    {
+        LineResult & result = results_[ group_.lines[ r ] ];
+        result.eval_result = Evaluator::EvaluatorResult( m_status[ r ] );
+        result.value = m_values[ r ];
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef _BATCH_EVALUATOR_H_
+#define _BATCH_EVALUATOR_H_
+
+#include <cstddef>       // std::size_t
+#include <span>          // std::span
+#include <cstdint>       // std::uint64_t
+#include <string_view>   // std::string_view
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "parser.h"
+#include "evaluator.h"
+#include "program.h"
+#include "column_evaluator.h"
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Avaliador de lotes de linhas, que agrupa as expressões pela forma.
+ *
+ * Muitas linhas da entrada têm a mesma forma: a mesma sequência de operadores
+ * na expressão pósfixa, só com literais diferentes (`2 * 3 + 4` e `7 * 1 + 9`
+ * são ambas `# # * # +`). Cada linha é analisada separadamente, e a forma
+ * pósfixa (`Evaluator::infix_to_postfix()`), resumida numa assinatura de 64
+ * bits, escolhe o seu grupo. Linhas curtas com a mesma forma infixa (os
+ * mesmos tokens, a menos dos literais) têm a mesma forma pósfixa, então só a
+ * primeira de cada forma infixa do lote é convertida. Cada grupo tem um
+ * programa em que o k-ésimo literal é a variável k, e os literais de cada
+ * linha formam as colunas do grupo. No fim do lote, cada grupo é avaliado
+ * pelo `ColumnEvaluator`, com uma linha por lane (16 lanes por registro AVX2
+ * com operandos de 16 bits), e os resultados voltam para a posição de cada
+ * linha na entrada.
+ *
+ * Os resultados são os mesmos do pipeline (`LineEvaluator`), com o primeiro
+ * erro de cada linha (`DIVISION_BY_ZERO` ou `RESULT_OVERFLOW`). A expressão
+ * pósfixa não é otimizada (`optimize_postfix()`): com literais, ela viraria
+ * uma constante e a forma se perderia; a otimização não muda nem o valor
+ * nem o primeiro erro.
+ *
+ * Linhas com mais de `MAX_SHAPE` tokens pósfixos raramente se repetem e são
+ * avaliadas direto pelo `Evaluator`; grupos com menos de `MIN_GROUP` linhas
+ * não enchem os blocos do `ColumnEvaluator` e são executados uma linha por
+ * vez (`Program::run()`).
+ *
+ * Os contextos, os grupos e as colunas são reaproveitados de um lote para o
+ * outro. Cada thread deve ter o seu próprio `BatchEvaluator`.
+ */
+class BatchEvaluator
+{
+    public:
+        typedef Token::value_type value_type;
+        typedef Evaluator::result_t result_t;
+        typedef Evaluator::EvaluatorResult::code_t code_t;
+
+        static const std::size_t MAX_SHAPE = 21; //<! Tokens pósfixos da maior linha agrupada (3 bits cada na assinatura).
+        static const std::size_t MAX_INFIX = 16; //<! Tokens infixos da maior linha reconhecida sem conversão (4 bits cada).
+        static const std::size_t MIN_GROUP = 64; //<! Linhas do menor grupo avaliado em colunas.
+
+        /*!
+         * Avalia um lote de linhas.
+         * \param lines_ As expressões (sem o '\n').
+         * \param results_ Recebe o resultado de cada linha, na ordem de `lines_` (com o tamanho dela).
+         */
+        void evaluate( std::span< const std::string_view > lines_, std::span< LineResult > results_ );
+
+        /// Linhas do último lote avaliadas em colunas (em grupos com pelo menos `MIN_GROUP` linhas).
+        std::size_t batched( void ) const { return m_batched; }
+        /// Formas distintas no último lote.
+        std::size_t shapes( void ) const { return m_n_groups; }
+
+        /// Constutor default.
+        BatchEvaluator() = default;
+        ~BatchEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        BatchEvaluator( const BatchEvaluator & ) = delete;
+        BatchEvaluator & operator=( const BatchEvaluator & ) = delete;
+
+    private:
+        /// Linhas com a mesma forma.
+        struct Group
+        {
+            Program program;                               //<! Programa da forma: o literal k é a variável k.
+            std::vector< std::vector< value_type > > columns; //<! Literais: `columns[ k ][ r ]` é o k-ésimo literal da linha r do grupo.
+            std::vector< std::size_t > lines;              //<! Posição de cada linha do grupo no lote.
+        };
+
+        Parser m_parser;                  //<! Parser (sem estado próprio).
+        Evaluator m_evaluator;            //<! Evaluator (sem estado próprio).
+        Parser::Context m_parser_ctx;     //<! Contexto do parser, reaproveitado entre as linhas.
+        Evaluator::Context m_eval_ctx;    //<! Contexto do evaluator, reaproveitado entre as linhas.
+        ColumnEvaluator m_columns;        //<! Avaliador dos grupos.
+
+        std::unordered_map< std::uint64_t, std::size_t > m_index;       //<! Grupo de cada forma pósfixa (pela assinatura) do lote.
+        std::unordered_map< std::uint64_t, std::size_t > m_infix_index; //<! Grupo de cada forma infixa curta do lote.
+        std::vector< Group > m_groups;    //<! Grupos (os primeiros `m_n_groups` são os do lote).
+        std::size_t m_n_groups = 0;       //<! Grupos em uso no lote.
+        std::size_t m_batched = 0;        //<! Linhas avaliadas em colunas no último lote.
+
+        std::vector< std::span< const value_type > > m_spans; //<! Colunas do grupo avaliado.
+        std::vector< result_t > m_values; //<! Valor de cada linha do grupo avaliado.
+        std::vector< code_t > m_status;   //<! Erro de cada linha do grupo avaliado.
+        std::vector< result_t > m_stack;  //<! Pilha de `Program::run()` (grupos pequenos).
+        std::vector< value_type > m_row;  //<! Literais de uma linha (grupos pequenos).
+
+        /// Converte a linha atual para pósfixa.
+        void convert( void );
+        /// Grupo da forma da expressão pósfixa do contexto (criado se preciso).
+        std::size_t group( void );
+        /// Avalia um grupo e espalha os resultados.
+        void run( Group &, std::span< LineResult > results_ );
+};
+
+#endif
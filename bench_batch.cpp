@@ -0,0 +1,145 @@
+/*!
+ * Benchmark do `BatchEvaluator`.
+ *
+ * Gera `LINES` linhas com poucas formas (as de `shapes`, com literais
+ * aleatórios, alguns zeros, -1 e extremos, para que apareçam divisões por
+ * zero e overflows) e algumas linhas mal formadas, e as avalia de duas
+ * maneiras:
+ *  - `line`: `LineEvaluator` (pipeline), uma linha por vez;
+ *  - `batch`: `BatchEvaluator`, em lotes de `BATCH` linhas.
+ * Cada medida é a mais rápida de `REPS` execuções. As colunas `line` e
+ * `batch` medem a linha inteira (parsing, conversão e avaliação); `eval` e
+ * `batch eval` descontam o parsing, que é o mesmo nos dois, e mostram a
+ * parte que os lotes substituem. Os resultados de cada linha são conferidos
+ * entre os dois. Se algum divergir, ou se os lotes não forem mais rápidos
+ * que o pipeline, o programa termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp fused_evaluator.cpp program.cpp table_parser.cpp line_evaluator.cpp column_evaluator.cpp batch_evaluator.cpp bench_batch.cpp -o bench_batch
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "line_evaluator.h"
+#include "batch_evaluator.h"
+#include "bench_common.h"
+
+/// Linhas geradas.
+const std::size_t LINES = 1000000;
+/// Linhas por lote.
+const std::size_t BATCH = 64 * 1024;
+/// Repetições de cada medida (vale a mais rápida).
+const int REPS = 5;
+
+/// Tempo por linha, em ns, da execução mais rápida de `f_` em `REPS` repetições.
+template < typename F >
+double best_ns( F f_ )
+{
+    double best = 0;
+    for ( int r( 0 ); r < REPS; ++r )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f_();
+        const double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / LINES;
+        if ( r == 0 or ns < best ) best = ns;
+    }
+    return best;
+}
+
+int main()
+{
+    // Cada `#` vira um literal.
+    const std::vector< std::string > shapes = {
+        "# * # + #",
+        "# / # - # % #",
+        "(# + #) * (# - #)",
+        "# - # * # / #",
+        "# ^ # + #",
+        "#",
+    };
+
+    std::mt19937 gen( 42 );
+    auto literal = [&]() -> std::string
+    {
+        const auto r = gen() % 64;
+        if ( r == 0 ) return "0";
+        if ( r == 1 ) return "-1";
+        if ( r == 2 ) return std::to_string( Numeric::max );
+        return std::to_string( static_cast< int >( gen() % 201 ) - 100 );
+    };
+    std::vector< std::string > text( LINES );
+    for ( auto & line : text )
+    {
+        for ( char c : shapes[ gen() % shapes.size() ] )
+        {
+            if ( c == '#' ) line += literal();
+            else line += c;
+        }
+        if ( gen() % 100 == 0 ) line += " +"; // Mal formada.
+    }
+    std::vector< std::string_view > lines( text.begin(), text.end() );
+
+    // Uma linha por vez (pipeline).
+    LineEvaluator pipeline;
+    std::vector< LineResult > expected( LINES );
+    const double line_ns = best_ns( [&]{
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+            expected[ i ] = pipeline.evaluate( lines[ i ] );
+    } );
+
+    // Só o parsing, para separar a parte que os lotes substituem.
+    Parser parser;
+    Parser::Context parser_ctx;
+    const double parse_ns = best_ns( [&]{
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+            parser.parse( lines[ i ], parser_ctx );
+    } );
+
+    // Em lotes.
+    BatchEvaluator batcher;
+    std::vector< LineResult > results( LINES );
+    std::size_t batched = 0;
+    const double batch_ns = best_ns( [&]{
+        batched = 0;
+        for ( std::size_t i( 0 ); i < LINES; i += BATCH )
+        {
+            const std::size_t n = std::min( BATCH, LINES - i );
+            batcher.evaluate( std::span( lines ).subspan( i, n ), std::span( results ).subspan( i, n ) );
+            batched += batcher.batched();
+        }
+    } );
+
+    bool ok = true;
+    for ( std::size_t i( 0 ); i < LINES; ++i )
+        ok = ok and same( expected[ i ], results[ i ] );
+
+    std::cout << std::setw( 12 ) << "lines" << std::setw( 12 ) << "batched"
+              << std::setw( 14 ) << "line (ns)" << std::setw( 14 ) << "batch (ns)"
+              << std::setw( 14 ) << "eval (ns)" << std::setw( 14 ) << "batch eval" << "\n";
+    std::cout << std::setw( 12 ) << LINES << std::setw( 12 ) << batched
+              << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << line_ns << std::setw( 14 ) << batch_ns
+              << std::setw( 14 ) << line_ns - parse_ns << std::setw( 14 ) << batch_ns - parse_ns << "\n";
+
+    if ( not ok )
+    {
+        std::cout << ">>> FALHOU: o resultado em lotes difere do pipeline.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << ">>> Ganho dos lotes: " << std::setprecision( 2 ) << line_ns / batch_ns << "x na linha inteira, "
+              << ( line_ns - parse_ns ) / ( batch_ns - parse_ns ) << "x sem o parsing\n";
+    if ( batch_ns >= line_ns )
+    {
+        std::cout << ">>> FALHOU: os lotes deveriam ser mais rápidos que o pipeline.\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << ">>> OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*!
+ * Benchmark do `ResultCache`.
+ *
+ * Primeiro confere o exemplo da chave: `12 +  3` e `12+3` têm a mesma forma
+ * canônica, então a segunda linha é um acerto.
+ *
+ * Depois gera `SHAPES` sequências de tokens aleatórias (números, nomes,
+ * operadores, sinais, parênteses e símbolos inválidos, de modo que apareçam
+ * todos os erros de parsing) e `LINES` linhas, cada uma com uma dessas
+ * sequências e ws aleatórios entre os tokens (às vezes nenhum). Cada linha é
+ * avaliada com o cache e sem ele; o resultado, a coluna do erro e o valor
+ * precisam ser os mesmos. Cada medida é a mais rápida de `REPS` execuções.
+ * Se algum resultado divergir, ou se o cache não for mais rápido que a
+ * avaliação sem ele com pelo menos `MIN_HIT_RATE` de acertos, o programa
+ * termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp fused_evaluator.cpp program.cpp table_parser.cpp line_evaluator.cpp result_cache.cpp bench_cache.cpp -o bench_cache
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "line_evaluator.h"
+#include "result_cache.h"
+#include "bench_common.h"
+
+/// Sequências de tokens distintas.
+const std::size_t SHAPES = 2000;
+/// Linhas geradas.
+const std::size_t LINES = 200000;
+/// Entradas do cache.
+const std::size_t CAPACITY = 4096;
+/// Repetições de cada medida (vale a mais rápida).
+const int REPS = 5;
+/// Taxa de acertos a partir da qual o cache precisa ser mais rápido.
+const double MIN_HIT_RATE = 0.9;
+
+/// Tempo por linha, em ns, da execução mais rápida de `f_` em `REPS` repetições.
+template < typename F >
+double best_ns( F f_ )
+{
+    double best = 0;
+    for ( int r( 0 ); r < REPS; ++r )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f_();
+        const double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / LINES;
+        if ( r == 0 or ns < best ) best = ns;
+    }
+    return best;
+}
+
+int main()
+{
+    LineEvaluator evaluator;
+
+    // O exemplo da chave: os ws entre tokens que não se juntam não contam.
+    {
+        ResultCache cache( 16 );
+        LineResult result;
+        for ( std::string_view line : { "12 +  3", "12+3" } )
+        {
+            if ( cache.lookup( line, result ) ) continue;
+            cache.insert( evaluator.evaluate( line ) );
+        }
+        if ( cache.stats().hits != 1 or cache.stats().misses != 1 )
+        {
+            std::cout << ">>> FALHOU: \"12 +  3\" e \"12+3\" deveriam ter a mesma chave ("
+                      << cache.stats().hits << " acerto(s), " << cache.stats().misses << " falta(s)).\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::mt19937 gen( 7 );
+    const std::vector< std::string > pieces = {
+        "1", "12", "0", "32767", "99999", "x", "ab1", "_",
+        "+", "-", "*", "/", "%", "^", "(", ")", "#", "-1", "--",
+    };
+    std::vector< std::vector< std::string > > shapes( SHAPES );
+    for ( auto & shape : shapes )
+    {
+        const std::size_t n = 1 + gen() % 9;
+        for ( std::size_t k( 0 ); k < n; ++k )
+        {
+            // Na maioria das vezes, uma expressão bem formada: operando, operador, operando...
+            if ( gen() % 8 == 0 ) shape.push_back( pieces[ gen() % pieces.size() ] );
+            else if ( k % 2 == 0 ) shape.push_back( pieces[ gen() % 5 ] );
+            else shape.push_back( pieces[ 8 + gen() % 6 ] );
+        }
+    }
+    auto ws = [&]() -> std::string
+    {
+        const auto r = gen() % 4;
+        if ( r == 0 ) return "";
+        if ( r == 1 ) return " ";
+        if ( r == 2 ) return "\t ";
+        return "   ";
+    };
+    std::vector< std::string > lines( LINES );
+    for ( auto & line : lines )
+    {
+        const auto & shape = shapes[ gen() % SHAPES ];
+        line = ws();
+        for ( const auto & token : shape )
+            line += token + ws();
+    }
+
+    // Sem cache.
+    std::vector< LineResult > expected( LINES );
+    const double plain_ns = best_ns( [&]{
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+            expected[ i ] = evaluator.evaluate( lines[ i ] );
+    } );
+
+    // Com cache (um cache novo a cada repetição).
+    std::vector< LineResult > results( LINES );
+    ResultCache::Stats stats;
+    const double cached_ns = best_ns( [&]{
+        ResultCache cache( CAPACITY );
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+        {
+            if ( cache.lookup( lines[ i ], results[ i ] ) ) continue;
+            results[ i ] = evaluator.evaluate( lines[ i ] );
+            cache.insert( results[ i ] );
+        }
+        stats = cache.stats();
+    } );
+
+    for ( std::size_t i( 0 ); i < LINES; ++i )
+    {
+        if ( same( expected[ i ], results[ i ] ) ) continue;
+        std::cout << ">>> FALHOU: o cache muda o resultado de \"" << lines[ i ] << "\"\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::setw( 12 ) << "lines" << std::setw( 12 ) << "hits" << std::setw( 12 ) << "misses"
+              << std::setw( 14 ) << "plain (ns)" << std::setw( 14 ) << "cached (ns)" << "\n";
+    std::cout << std::setw( 12 ) << LINES << std::setw( 12 ) << stats.hits << std::setw( 12 ) << stats.misses
+              << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << plain_ns << std::setw( 14 ) << cached_ns << "\n";
+    if ( double( stats.hits ) / LINES >= MIN_HIT_RATE and cached_ns >= plain_ns )
+    {
+        std::cout << ">>> FALHOU: com " << stats.hits * 100 / LINES << "% de acertos, o cache deveria ser mais rápido que a avaliação.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << ">>> OK: mesmos resultados e colunas, com e sem cache.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/*!
+ * Benchmark do `ColumnEvaluator`.
+ *
+ * Compila algumas fórmulas (com variáveis) e as avalia sobre `ROWS` linhas de
+ * valores aleatórios (com uma fração de zeros e de valores extremos, para que
+ * apareçam divisões por zero e overflows), de duas maneiras:
+ *  - `row`: `Program::run()` uma vez por linha, com os valores da linha;
+ *  - `column`: `ColumnEvaluator::evaluate()` sobre as colunas inteiras.
+ * Os resultados (e os erros) de cada linha são conferidos entre os dois.
+ * Se algum divergir, ou se o avaliador colunar não for pelo menos
+ * `MIN_SPEEDUP` vezes mais rápido na média das fórmulas vetorizadas (as sem
+ * `^`, que é sempre escalar), o programa termina com `EXIT_FAILURE`. O ganho
+ * esperado depende da largura: com 16 bits cabem 16 linhas num registro AVX2,
+ * com 32 bits, 8; com 64 e 128 bits tudo é escalar e só os resultados são
+ * conferidos.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp program.cpp column_evaluator.cpp bench_columns.cpp -o bench_columns
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <span>      // std::span
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cmath>     // std::log, std::exp
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "parser.h"
+#include "evaluator.h"
+#include "program.h"
+#include "column_evaluator.h"
+
+/// Ganho mínimo (média geométrica das fórmulas sem `^`) do avaliador colunar sobre `Program::run()` por linha (zero: sem mínimo).
+const double MIN_SPEEDUP = sizeof( Token::value_type ) == 2 ? 4.0
+                         : sizeof( Token::value_type ) == 4 ? 2.5 : 0.0;
+/// Linhas de cada coluna.
+const std::size_t ROWS = 1000000;
+
+typedef Token::value_type value_type;
+typedef Evaluator::EvaluatorResult::code_t code_t;
+
+int main()
+{
+    const std::vector< std::string > formulas = {
+        "price * qty - discount",
+        "(a * 3 + b) - (c - 7) * a",
+        "(a * 3 + b) / (c - 7) % 100",
+        "x ^ 2 + y",
+    };
+
+    Parser parser;
+    Parser::Context parser_ctx;
+    parser_ctx.variables = true;
+    Evaluator evaluator;
+    Evaluator::Context eval_ctx;
+    Program prog;
+    ColumnEvaluator columns;
+    std::mt19937 gen( 42 );
+    bool ok = true;
+    double log_speedup = 0;
+    std::size_t n_vectorized = 0;
+
+    std::cout << std::setw( 30 ) << "formula" << std::setw( 12 ) << "errors"
+              << std::setw( 14 ) << "row (ns)" << std::setw( 14 ) << "column (ns)" << std::setw( 10 ) << "speedup" << "\n";
+
+    for ( const auto & f : formulas )
+    {
+        if ( parser.parse( f, parser_ctx ).type != Parser::ParserResult::PARSER_OK )
+        {
+            std::cout << ">>> FALHOU: fórmula mal formada: " << f << "\n";
+            return EXIT_FAILURE;
+        }
+        evaluator.compile( parser_ctx.token_list, eval_ctx, prog );
+
+        // Valores pequenos, com alguns zeros, -1 e extremos.
+        const std::size_t n_vars = parser_ctx.variable_names.size();
+        std::vector< std::vector< value_type > > data( n_vars, std::vector< value_type >( ROWS ) );
+        for ( auto & col : data )
+            for ( auto & v : col )
+            {
+                const auto r = gen() % 64;
+                v = r == 0 ? 0 : r == 1 ? -1 : r == 2 ? Numeric::max : r == 3 ? Numeric::min
+                  : static_cast< value_type >( static_cast< int >( gen() % 201 ) - 100 );
+            }
+        std::vector< std::span< const value_type > > spans( data.begin(), data.end() );
+
+        // Uma linha por vez.
+        std::vector< value_type > row_values( ROWS ), row( n_vars ), stack( prog.max_depth() );
+        std::vector< code_t > row_status( ROWS );
+        auto start = std::chrono::steady_clock::now();
+        for ( std::size_t r( 0 ); r < ROWS; ++r )
+        {
+            for ( std::size_t v( 0 ); v < n_vars; ++v ) row[ v ] = data[ v ][ r ];
+            value_type out = 0;
+            row_status[ r ] = prog.run( out, stack, row ).type;
+            row_values[ r ] = row_status[ r ] == Evaluator::EvaluatorResult::EVALUATOR_OK ? out : 0;
+        }
+        const double row_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / ROWS;
+
+        // Todas as linhas de uma vez.
+        std::vector< value_type > values( ROWS );
+        std::vector< code_t > status( ROWS );
+        start = std::chrono::steady_clock::now();
+        const auto errors = columns.evaluate( prog, spans, values, status );
+        const double column_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / ROWS;
+
+        ok = ok and values == row_values and status == row_status;
+        if ( f.find( '^' ) == std::string::npos )
+        {
+            log_speedup += std::log( row_ns / column_ns );
+            ++n_vectorized;
+        }
+        std::cout << std::setw( 30 ) << f << std::setw( 12 ) << errors
+                  << std::setw( 14 ) << std::fixed << std::setprecision( 2 ) << row_ns
+                  << std::setw( 14 ) << column_ns << std::setw( 9 ) << std::setprecision( 1 ) << row_ns / column_ns << "x\n";
+    }
+
+    if ( not ok )
+    {
+        std::cout << ">>> FALHOU: o avaliador colunar difere de Program::run().\n";
+        return EXIT_FAILURE;
+    }
+
+    const double speedup = std::exp( log_speedup / n_vectorized );
+    std::cout << ">>> Ganho médio do avaliador colunar (sem ^): " << std::setprecision( 1 ) << speedup << "x\n";
+    if ( speedup < MIN_SPEEDUP )
+    {
+        std::cout << ">>> FALHOU: o avaliador colunar deveria ser pelo menos " << MIN_SPEEDUP << "x mais rápido.\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << ">>> OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,21 @@
+#ifndef _BENCH_COMMON_H_
+#define _BENCH_COMMON_H_
+
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Funções comuns aos benchmarks que conferem um avaliador com o pipeline
+ * (`bench_batch`, `bench_cache` e `bench_incremental`).
+ */
+
+/// Mesmo resultado (e, com erro de parsing, mesma coluna; sem erros, mesmo valor)?
+inline bool same( const LineResult & a_, const LineResult & b_ )
+{
+    if ( a_.parser_result.type != b_.parser_result.type ) return false;
+    if ( a_.parser_result.type != Parser::ParserResult::PARSER_OK )
+        return a_.parser_result.at_col == b_.parser_result.at_col;
+    if ( a_.eval_result.type != b_.eval_result.type ) return false;
+    return a_.eval_result.type != Evaluator::EvaluatorResult::EVALUATOR_OK or a_.value == b_.value;
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*!
+ * Benchmark das edições do `IncrementalEvaluator`.
+ *
+ * Para expressões com 1k, 10k e 100k termos (somas de produtos, com alguns
+ * parênteses), aplica edições e mede o custo médio de cada uma, comparado com
+ * avaliar a expressão inteira de novo (`LineEvaluator` no modo pipeline).
+ * As posições seguem um cursor que anda alguns termos para um lado ou para o
+ * outro a cada edição, como numa sessão de edição. São dois tipos de edição:
+ *  - `digit`: troca um dígito de um número;
+ *  - `term`: insere um termo novo (`" - 7 * 3"`) depois de um número e, na
+ *    edição seguinte, o remove.
+ * A coluna `random` repete `digit` em posições aleatórias da expressão
+ * inteira, onde o custo é dominado pelas faltas de cache no caminho da raiz.
+ * Depois de cada rodada, o resultado e o texto são conferidos com o pipeline.
+ * Como cada edição só percorre o caminho até a raiz, o custo deve crescer
+ * como log n; se o custo por edição da maior expressão passar de
+ * `MAX_GROWTH` vezes o da menor, ou se algum resultado divergir, o programa
+ * termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp fused_evaluator.cpp program.cpp table_parser.cpp line_evaluator.cpp incremental_evaluator.cpp bench_incremental.cpp -o bench_incremental
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "incremental_evaluator.h"
+#include "line_evaluator.h"
+#include "bench_common.h"
+
+/// Crescimento máximo tolerado no custo por edição (log n, mais cache e TLB).
+const double MAX_GROWTH = 4.0;
+/// Edições de cada tipo por rodada.
+const std::size_t EDITS = 200000;
+
+/// Gera uma soma de `n_terms_` produtos; um a cada sete termos fica entre parênteses.
+std::string make_expression( std::size_t n_terms_ )
+{
+    std::string expr;
+    expr.reserve( n_terms_ * 12 );
+    for ( std::size_t i( 0 ); i < n_terms_; ++i )
+    {
+        if ( i > 0 ) expr += i % 2 ? " + " : " - ";
+        const auto a = std::to_string( 1 + ( i * 7919 ) % 97 );
+        const auto b = std::to_string( 1 + ( i * 104729 ) % 89 );
+        if ( i % 7 == 3 ) expr += "(" + a + " - " + b + " * 2)";
+        else expr += a + " * " + b;
+    }
+    return expr;
+}
+
+int main()
+{
+    const std::vector< std::size_t > sizes = { 1000, 10000, 100000 };
+    const std::string new_term = " - 7 * 3";
+    LineEvaluator pipeline;
+    IncrementalEvaluator inc;
+    std::vector< double > ns_per_edit;
+    bool ok = true;
+
+    std::cout << std::setw( 10 ) << "terms" << std::setw( 14 ) << "full (us)"
+              << std::setw( 14 ) << "digit (ns)" << std::setw( 14 ) << "term (ns)" << std::setw( 14 ) << "random (ns)"
+              << std::setw( 12 ) << "rebuilds" << "\n";
+
+    for ( auto n : sizes )
+    {
+        const auto expr = make_expression( n );
+        std::vector< std::size_t > digits, ends; // Posições de dígitos e de fins de número.
+        for ( std::size_t i( 0 ); i < expr.size(); ++i )
+        {
+            if ( expr[ i ] < '0' or expr[ i ] > '9' ) continue;
+            digits.push_back( i );
+            if ( i + 1 == expr.size() or expr[ i + 1 ] < '0' or expr[ i + 1 ] > '9' )
+                ends.push_back( i + 1 );
+        }
+        std::mt19937 gen( 42 );
+        std::vector< std::size_t > digit_at( EDITS ), end_at( EDITS ), random_at( EDITS );
+        // Cursor: anda até `STEP` posições para cada lado a cada edição.
+        const std::size_t STEP = 16;
+        std::size_t cursor = digits.size() / 2;
+        for ( auto & p : digit_at )
+        {
+            cursor = ( cursor + digits.size() + gen() % ( 2 * STEP + 1 ) - STEP ) % digits.size();
+            p = digits[ cursor ];
+        }
+        cursor = ends.size() / 2;
+        for ( auto & p : end_at )
+        {
+            cursor = ( cursor + ends.size() + gen() % ( 2 * STEP + 1 ) - STEP ) % ends.size();
+            p = ends[ cursor ];
+        }
+        for ( auto & p : random_at ) p = digits[ gen() % digits.size() ];
+
+        // Reavaliar tudo, para comparação.
+        auto start = std::chrono::steady_clock::now();
+        const int full_reps = 20;
+        for ( int r( 0 ); r < full_reps; ++r ) pipeline.evaluate( expr );
+        const double full_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / full_reps;
+
+        inc.load( expr );
+        const auto rebuilds = inc.rebuilds();
+        std::string text = expr;
+
+        // Troca de dígitos (o tamanho do texto não muda).
+        const char new_digit[] = "123456789";
+        start = std::chrono::steady_clock::now();
+        for ( std::size_t i( 0 ); i < EDITS; ++i )
+            inc.edit( digit_at[ i ], 1, std::string_view( new_digit + i % 9, 1 ) );
+        const double digit_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / EDITS;
+        for ( std::size_t i( 0 ); i < EDITS; ++i ) text[ digit_at[ i ] ] = new_digit[ i % 9 ];
+        ok = ok and inc.text() == text and same( inc.result(), pipeline.evaluate( text ) );
+
+        start = std::chrono::steady_clock::now();
+        for ( std::size_t i( 0 ); i < EDITS; ++i )
+            inc.edit( random_at[ i ], 1, std::string_view( new_digit + i % 9, 1 ) );
+        const double random_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / EDITS;
+        for ( std::size_t i( 0 ); i < EDITS; ++i ) text[ random_at[ i ] ] = new_digit[ i % 9 ];
+        ok = ok and inc.text() == text and same( inc.result(), pipeline.evaluate( text ) );
+
+        // Inserir um termo e removê-lo na edição seguinte.
+        start = std::chrono::steady_clock::now();
+        for ( std::size_t i( 0 ); i < EDITS; i += 2 )
+        {
+            inc.edit( end_at[ i ], 0, new_term );
+            inc.edit( end_at[ i ], new_term.size(), "" );
+        }
+        const double term_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / EDITS;
+        inc.edit( end_at[ 0 ], 0, new_term );
+        text.insert( end_at[ 0 ], new_term );
+        ok = ok and inc.text() == text and same( inc.result(), pipeline.evaluate( text ) );
+
+        ns_per_edit.push_back( ( digit_ns + term_ns ) / 2 );
+        std::cout << std::setw( 10 ) << n
+                  << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << full_ns / 1e3
+                  << std::setw( 14 ) << digit_ns << std::setw( 14 ) << term_ns << std::setw( 14 ) << random_ns
+                  << std::setw( 12 ) << inc.rebuilds() - rebuilds << "\n";
+    }
+
+    if ( not ok )
+    {
+        std::cout << ">>> FALHOU: o resultado incremental difere do pipeline.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto growth = ns_per_edit.back() / ns_per_edit.front();
+    std::cout << ">>> Crescimento do custo por edição ("
+              << sizes.front() << " -> " << sizes.back() << " termos): "
+              << std::setprecision( 2 ) << growth << "x\n";
+    if ( growth > MAX_GROWTH )
+    {
+        std::cout << ">>> FALHOU: o custo das edições cresce com o tamanho da expressão (limite "
+                  << MAX_GROWTH << "x).\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << ">>> OK: edições com custo logarítmico no tamanho da expressão.\n";
+    return EXIT_SUCCESS;
+}
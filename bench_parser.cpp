@@ -0,0 +1,107 @@
+/*!
+ * Benchmark de escalabilidade do parser.
+ *
+ * Gera expressões com 1k, 10k, 100k e 1M termos, mede o tempo de
+ * `Parser::parse()` para cada uma e calcula o custo médio por termo.
+ * Como o parsing deve ser linear no tamanho da entrada, o custo por termo
+ * precisa ficar aproximadamente constante. Se o custo por termo da maior
+ * expressão passar de `MAX_GROWTH` vezes o custo da menor, o programa
+ * termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp parser.cpp structural_index.cpp bench_parser.cpp -o bench_parser
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>    // std::chrono::steady_clock
+#include <algorithm> // std::min
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "parser.h"
+
+/// Crescimento máximo tolerado no custo por termo (cache e TLB explicam alguma variação).
+const double MAX_GROWTH = 4.0;
+
+/// Gera uma expressão válida com `n_terms_` termos, alternando operadores e espaços.
+std::string make_expression( std::size_t n_terms_ )
+{
+    const char ops[] = { '+', '-', '*', '/', '%', '^' };
+    std::string expr;
+    expr.reserve( n_terms_ * 8 );
+
+    for ( std::size_t i( 0 ); i < n_terms_; ++i )
+    {
+        if ( i > 0 )
+        {
+            expr += ' ';
+            expr += ops[ i % 6 ];
+            expr += ' ';
+        }
+        if ( i % 5 == 0 ) expr += '-';
+        expr += std::to_string( 1 + ( i * 7919 ) % 32767 );
+    }
+
+    return expr;
+}
+
+/// Mede o menor tempo (em nanossegundos) de `reps_` execuções de `Parser::parse()`.
+double time_parse( Parser & parser_, const std::string & expr_, int reps_ )
+{
+    double best = 1e300;
+    for ( int r( 0 ); r < reps_; ++r )
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto result = parser_.parse( expr_ );
+        auto stop = std::chrono::steady_clock::now();
+
+        if ( result.type != Parser::ParserResult::PARSER_OK )
+        {
+            std::cerr << ">>> Expressão gerada foi rejeitada pelo parser na coluna "
+                      << result.at_col << "!\n";
+            std::exit( EXIT_FAILURE );
+        }
+        best = std::min( best, std::chrono::duration< double, std::nano >( stop - start ).count() );
+    }
+    return best;
+}
+
+int main()
+{
+    const std::vector< std::size_t > sizes = { 1000, 10000, 100000, 1000000 };
+    Parser my_parser;
+    std::vector< double > ns_per_term;
+
+    std::cout << std::setw( 10 ) << "terms" << std::setw( 16 ) << "total (ms)"
+              << std::setw( 16 ) << "ns/term" << "\n";
+
+    for ( auto n : sizes )
+    {
+        auto expr = make_expression( n );
+        // Mais repetições para as expressões menores, para reduzir o ruído.
+        int reps = n >= 1000000 ? 3 : n >= 100000 ? 10 : 50;
+        auto ns = time_parse( my_parser, expr, reps );
+
+        ns_per_term.push_back( ns / n );
+        std::cout << std::setw( 10 ) << n
+                  << std::setw( 16 ) << std::fixed << std::setprecision( 3 ) << ns / 1e6
+                  << std::setw( 16 ) << std::setprecision( 2 ) << ns / n << "\n";
+    }
+
+    auto growth = ns_per_term.back() / ns_per_term.front();
+    std::cout << ">>> Crescimento do custo por termo ("
+              << sizes.front() << " -> " << sizes.back() << " termos): "
+              << std::setprecision( 2 ) << growth << "x\n";
+
+    if ( growth > MAX_GROWTH )
+    {
+        std::cout << ">>> FALHOU: o parsing não está escalando linearmente (limite "
+                  << MAX_GROWTH << "x).\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << ">>> OK: parsing linear no tamanho da expressão.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*!
+ * Benchmark do `LineReader`.
+ *
+ * Grava `LINES` linhas aleatórias (de tamanhos variados) em um arquivo
+ * temporário e mede a leitura das linhas com `next()` de duas maneiras:
+ *  - `mmap`: o arquivo aberto como entrada (mapeado em memória);
+ *  - `pipe`: o mesmo conteúdo escrito em um pipe por outra thread (lido em blocos).
+ *
+ * Antes disso, confere que, num arquivo cujo começo já foi lido do descritor
+ * (como em `{ read -r x; ./bares; } < arquivo`), o leitor começa no offset
+ * atual e não no início do arquivo, com offsets no meio da primeira página e
+ * depois dela, e que o descritor termina no fim do arquivo. Se alguma linha
+ * divergir do conteúdo gravado, o programa termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp line_reader.cpp bench_reader.cpp -pthread -o bench_reader
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>    // std::thread
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include <fcntl.h>     // ::open
+#include <unistd.h>    // ::read, ::write, ::close, ::lseek, ::pipe, ::unlink, ::getpid
+
+#include "line_reader.h"
+
+/// Linhas geradas.
+const std::size_t LINES = 2000000;
+
+/// Escreve todo o texto no descritor.
+bool write_all( int fd_, std::string_view text_ )
+{
+    while ( not text_.empty() )
+    {
+        const ssize_t n = ::write( fd_, text_.data(), text_.size() );
+        if ( n <= 0 ) return false;
+        text_.remove_prefix( n );
+    }
+    return true;
+}
+
+/// Lê todas as linhas de `reader_` e confere com `lines_`, a partir da linha `first_`.
+bool read_all( LineReader & reader_, const std::vector< std::string > & lines_, std::size_t first_ )
+{
+    std::string_view line;
+    std::size_t i = first_;
+    while ( reader_.next( line ) )
+    {
+        if ( i == lines_.size() or line != lines_[ i ] ) return false;
+        ++i;
+    }
+    return i == lines_.size();
+}
+
+int main()
+{
+    std::mt19937 gen( 9 );
+    const std::string ops = "+-*/%^";
+    std::vector< std::string > lines( LINES );
+    std::string text;
+    for ( auto & line : lines )
+    {
+        line = std::to_string( gen() % 1000 );
+        const std::size_t terms = gen() % 8;
+        for ( std::size_t t( 0 ); t < terms; ++t )
+            line += std::string( " " ) + ops[ gen() % ops.size() ] + " " + std::to_string( gen() % 100 );
+        text += line;
+        text += '\n';
+    }
+
+    const std::string path = "/tmp/bench_reader." + std::to_string( ::getpid() ) + ".txt";
+    int fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600 );
+    if ( fd < 0 or not write_all( fd, text ) )
+    {
+        std::cout << ">>> FALHOU: não foi possível gravar " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    ::unlink( path.c_str() ); // Some junto com o descritor.
+
+    // Começo já consumido: lemos as primeiras linhas direto do descritor.
+    bool ok = true;
+    LineReader reader;
+    for ( std::size_t skip : { std::size_t( 0 ), std::size_t( 1 ), std::size_t( 700 ), LINES - 1, LINES } )
+    {
+        std::size_t offset = 0;
+        for ( std::size_t i( 0 ); i < skip; ++i ) offset += lines[ i ].size() + 1;
+        ::lseek( fd, 0, SEEK_SET );
+        std::vector< char > consumed( offset );
+        ok = ok and ::read( fd, consumed.data(), offset ) == static_cast< ssize_t >( offset )
+                and reader.open( fd ) and read_all( reader, lines, skip )
+                and ::lseek( fd, 0, SEEK_CUR ) == static_cast< off_t >( text.size() );
+        reader.close();
+        if ( not ok )
+        {
+            std::cout << ">>> FALHOU: o leitor não continua do offset " << offset << " do descritor (ou não o deixa no fim do arquivo).\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Arquivo mapeado.
+    ::lseek( fd, 0, SEEK_SET );
+    auto start = std::chrono::steady_clock::now();
+    ok = reader.open( fd ) and reader.stable() and read_all( reader, lines, 0 );
+    const double mmap_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / LINES;
+    reader.close();
+    ::close( fd );
+
+    // Pipe, escrito por outra thread.
+    int p[ 2 ];
+    if ( ::pipe( p ) != 0 ) ok = false;
+    else
+    {
+        std::thread writer( [&]{ write_all( p[ 1 ], text ); ::close( p[ 1 ] ); } );
+        start = std::chrono::steady_clock::now();
+        ok = ok and reader.open( p[ 0 ] ) and not reader.stable() and read_all( reader, lines, 0 );
+        writer.join();
+        reader.close();
+        ::close( p[ 0 ] );
+    }
+    const double pipe_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / LINES;
+
+    if ( not ok )
+    {
+        std::cout << ">>> FALHOU: as linhas lidas diferem das gravadas.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << std::setw( 12 ) << "lines" << std::setw( 14 ) << "mmap (ns)" << std::setw( 14 ) << "pipe (ns)" << "\n";
+    std::cout << std::setw( 12 ) << LINES << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << mmap_ns
+              << std::setw( 14 ) << pipe_ns << "\n";
+    std::cout << ">>> OK: mesmas linhas, a partir do offset do descritor.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/*!
+ * Benchmark do `Server`.
+ *
+ * Sobe um servidor (com `WORKERS` workers) em um socket Unix temporário e
+ * mede duas coisas:
+ *  - vazão: `CLIENTS` clientes simultâneos, cada um com `LINES` expressões
+ *    aleatórias (algumas mal formadas), enviadas sem esperar as respostas
+ *    (*pipelining*) por uma thread, enquanto outra lê as respostas;
+ *  - latência: um cliente envia `PINGS` expressões, uma por vez, esperando
+ *    cada resposta (o custo de um pedido a um servidor já quente, em vez de
+ *    iniciar um processo por lote).
+ * A resposta de cada cliente é conferida, byte a byte, com a saída do
+ * `LineEvaluator` para as mesmas linhas; se alguma divergir, o programa
+ * termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp fused_evaluator.cpp program.cpp table_parser.cpp line_evaluator.cpp result_cache.cpp output.cpp server.cpp bench_server.cpp -pthread -o bench_server
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>    // std::thread
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>   // std::strcpy
+
+#include <unistd.h>     // ::read, ::write, ::close, ::getpid
+#include <sys/socket.h> // ::socket, ::connect, ::shutdown
+#include <sys/un.h>     // sockaddr_un
+
+#include "server.h"
+#include "output.h"
+
+/// Clientes simultâneos.
+const std::size_t CLIENTS = 8;
+/// Linhas por cliente.
+const std::size_t LINES = 100000;
+/// Pedidos do teste de latência.
+const std::size_t PINGS = 20000;
+/// Workers do servidor.
+const std::size_t WORKERS = 2;
+
+/// Conecta ao servidor; retorna -1 em caso de erro.
+int connect_to( const std::string & path_ )
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy( addr.sun_path, path_.c_str() );
+    const int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd >= 0 and ::connect( fd, reinterpret_cast< const sockaddr * >( &addr ), sizeof( addr ) ) != 0 )
+    {
+        ::close( fd );
+        return -1;
+    }
+    return fd;
+}
+
+/// Escreve todo o texto (o socket é bloqueante).
+bool write_all( int fd_, const std::string & text_ )
+{
+    std::size_t done = 0;
+    while ( done < text_.size() )
+    {
+        const ssize_t n = ::write( fd_, text_.data() + done, text_.size() - done );
+        if ( n <= 0 ) return false;
+        done += n;
+    }
+    return true;
+}
+
+/// Envia `request_` (enquanto lê as respostas, em outra thread) e retorna tudo o que o servidor respondeu até fechar a conexão.
+std::string exchange( const std::string & path_, const std::string & request_ )
+{
+    const int fd = connect_to( path_ );
+    if ( fd < 0 ) return "";
+    std::thread writer( [&]{
+        write_all( fd, request_ );
+        ::shutdown( fd, SHUT_WR );
+    } );
+    std::string reply;
+    char buffer[ 64 * 1024 ];
+    ssize_t n;
+    while ( ( n = ::read( fd, buffer, sizeof( buffer ) ) ) > 0 )
+        reply.append( buffer, n );
+    writer.join();
+    ::close( fd );
+    return reply;
+}
+
+int main()
+{
+    const std::string path = "/tmp/bench_server." + std::to_string( ::getpid() ) + ".sock";
+    Server server( WORKERS, LineEvaluator::PIPELINE, 0 );
+    if ( not server.listen( path.c_str() ) )
+    {
+        std::cout << ">>> FALHOU: não foi possível criar o socket " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    std::thread loop( [&]{ server.run(); } );
+
+    // Pedidos e respostas esperadas de cada cliente.
+    std::mt19937 gen( 42 );
+    const std::string ops = "+-*/%^";
+    LineEvaluator evaluator;
+    std::vector< std::string > requests( CLIENTS ), expected( CLIENTS );
+    for ( std::size_t c( 0 ); c < CLIENTS; ++c )
+    {
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+        {
+            std::string line = std::to_string( static_cast< int >( gen() % 2001 ) - 1000 );
+            const std::size_t terms = gen() % 6;
+            for ( std::size_t t( 0 ); t < terms; ++t )
+                line += std::string( " " ) + ops[ gen() % ops.size() ] + " " + std::to_string( gen() % 100 );
+            if ( gen() % 50 == 0 ) line += " +"; // Mal formada.
+            append_result( expected[ c ], evaluator.evaluate( line ) );
+            requests[ c ] += line;
+            requests[ c ] += '\n';
+        }
+        requests[ c ].pop_back(); // A última linha vai sem '\n'.
+    }
+
+    // Vazão: todos os clientes ao mesmo tempo.
+    std::vector< std::string > replies( CLIENTS );
+    std::vector< std::thread > clients;
+    auto start = std::chrono::steady_clock::now();
+    for ( std::size_t c( 0 ); c < CLIENTS; ++c )
+        clients.emplace_back( [&, c]{ replies[ c ] = exchange( path, requests[ c ] ); } );
+    for ( auto & t : clients ) t.join();
+    const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+    bool ok = true;
+    for ( std::size_t c( 0 ); c < CLIENTS; ++c )
+        ok = ok and replies[ c ] == expected[ c ];
+
+    // Latência: uma expressão por vez, na mesma conexão.
+    double ping_us = 0;
+    const int fd = connect_to( path );
+    if ( fd < 0 ) ok = false;
+    else
+    {
+        const std::string ping = "5 * 10 + 10\n";
+        char buffer[ 64 ];
+        start = std::chrono::steady_clock::now();
+        for ( std::size_t i( 0 ); i < PINGS and ok; ++i )
+        {
+            ok = write_all( fd, ping ) and ::read( fd, buffer, sizeof( buffer ) ) == 3 and std::string( buffer, 3 ) == "60\n";
+        }
+        ping_us = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count() / PINGS;
+        ::close( fd );
+    }
+
+    server.stop();
+    loop.join();
+
+    if ( not ok )
+    {
+        std::cout << ">>> FALHOU: a resposta do servidor difere do LineEvaluator.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << std::setw( 10 ) << "clients" << std::setw( 12 ) << "lines" << std::setw( 10 ) << "workers"
+              << std::setw( 16 ) << "lines/s" << std::setw( 14 ) << "ping (us)" << "\n";
+    std::cout << std::setw( 10 ) << CLIENTS << std::setw( 12 ) << CLIENTS * LINES << std::setw( 10 ) << WORKERS
+              << std::setw( 16 ) << std::fixed << std::setprecision( 0 ) << CLIENTS * LINES / seconds
+              << std::setw( 14 ) << std::setprecision( 1 ) << ping_us << "\n";
+    std::cout << ">>> OK: mesmas respostas, na ordem dos pedidos.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,621 @@
+/*!
+ * Suíte de benchmarks do BARES.
+ *
+ * Gera corpora sintéticos (sempre os mesmos, com semente fixa) e mede cada
+ * etapa separadamente:
+ *
+ *  - `parse`: `Parser::parse()` de cada linha;
+ *  - `infix_to_postfix`: `Evaluator::infix_to_postfix()` das listas de tokens;
+ *  - `optimize_postfix`: `Evaluator::optimize_postfix()` das listas pósfixas
+ *    (inclui a cópia da lista para o contexto, já que ela é otimizada no lugar);
+ *  - `evaluate_postfix`: `Evaluator::evaluate_postfix()` das listas pósfixas;
+ *  - `end_to_end*`: `LineEvaluator::evaluate()` mais a formatação da saída,
+ *    em cada um dos modos (pipeline, fused e compiled);
+ *  - `end_to_end_stream`: `StreamEvaluator`, com cada linha entregue em
+ *    pedaços de `STREAM_PIECE` bytes, mais a formatação da saída.
+ *
+ * As etapas de avaliação só recebem as linhas que o parser aceitou.
+ *
+ * Os corpora são:
+ *
+ *  - `short`: linhas curtas, com 1 a 8 termos (o caso típico);
+ *  - `long_flat`: poucas linhas com 100k termos cada;
+ *  - `errors`: linhas que provocam cada um dos erros de parsing e de avaliação;
+ *  - `overflow`: expressões válidas cujo resultado (ou um intermediário) não cabe em um short;
+ *  - `ws_padded`: linhas curtas com muito ws entre os símbolos;
+ *  - `deep_nested`: poucas linhas com 100k níveis de parênteses cada.
+ *
+ * Para cada par (corpus, etapa) o resultado é o menor tempo entre algumas
+ * repetições, em ns por linha. Os resultados podem ser gravados em JSON
+ * (`--json arquivo`) e comparados com um JSON gravado antes (`--baseline
+ * arquivo`): se alguma medida ficar mais de `--tolerance` (padrão 25%) mais
+ * lenta que a de referência, o programa termina com `EXIT_FAILURE`. Medidas
+ * que não estão na referência (uma etapa ou um corpus novo) são listadas como
+ * `SEM REFERÊNCIA`: a referência deve ser gravada de novo junto com a mudança.
+ *
+ * Como os tempos absolutos dependem da máquina, a comparação é relativa:
+ * antes de cada corpus é medida a etapa `calibration`, um lexer mínimo que não
+ * usa o código do BARES, e cada medida do corpus é dividida por ela antes de
+ * ser comparada com a medida de referência dividida pela calibração da
+ * referência. Isso desconta a velocidade da máquina (e as suas variações ao
+ * longo da execução), mas não as diferenças de microarquitetura (caches,
+ * preditor, SIMD): para uma comparação estrita, grave a referência na mesma
+ * máquina com `--json` antes de usar `--baseline`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp arena.cpp evaluator.cpp fused_evaluator.cpp program.cpp table_parser.cpp line_evaluator.cpp output.cpp stream_evaluator.cpp bench_suite.cpp -o bench_suite
+ * Usar com:
+ *     ./bench_suite [--quick] [--json resultado.json] [--baseline bench_baseline.json] [--tolerance 0.25]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <random>    // std::mt19937
+#include <chrono>    // std::chrono::steady_clock
+#include <algorithm> // std::min, std::max
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "parser.h"
+#include "evaluator.h"
+#include "line_evaluator.h"
+#include "output.h"
+#include "stream_evaluator.h"
+
+/// Um corpus: nome e linhas.
+struct Workload
+{
+    std::string name;
+    std::vector< std::string > lines;
+    std::size_t bytes = 0; //<! Total de bytes (com um '\n' por linha).
+};
+
+/// Resultado de uma medida.
+struct Measure
+{
+    std::string workload;
+    std::string stage;
+    std::size_t lines = 0;   //<! Linhas processadas pela etapa em cada repetição.
+    std::size_t bytes = 0;   //<! Bytes dessas linhas.
+    double ns_per_line = 0;  //<! Menor tempo entre as repetições, por linha.
+    double mb_per_s = 0;     //<! Vazão correspondente.
+};
+
+// ================================================================================
+// Geradores de corpora.
+// ================================================================================
+
+/// Gerador de números pseudo-aleatórios com semente fixa: os corpora são sempre os mesmos.
+std::mt19937 rng( 2016 );
+
+/// Inteiro uniforme em [lo_, hi_].
+int uniform( int lo_, int hi_ )
+{
+    return std::uniform_int_distribution< int >( lo_, hi_ )( rng );
+}
+
+/// Um dos operadores binários.
+char random_operator( void )
+{
+    const char ops[] = { '+', '-', '*', '/', '%', '^' };
+    return ops[ uniform( 0, 5 ) ];
+}
+
+/// Um operando de até `max_` (às vezes negativo), que nunca é zero, para não dividir por zero.
+std::string random_operand( int max_ )
+{
+    std::string s = uniform( 0, 3 ) == 0 ? "-" : "";
+    return s + std::to_string( uniform( 1, max_ ) );
+}
+
+/// Uma sequência de 1 a `max_` ws (espaços e tabs).
+std::string random_ws( int max_ )
+{
+    std::string s;
+    for ( int i( uniform( 1, max_ ) ); i > 0; --i )
+        s += uniform( 0, 3 ) == 0 ? '\t' : ' ';
+    return s;
+}
+
+/// Linhas curtas, com 1 a 8 termos.
+Workload make_short( std::size_t n_lines_ )
+{
+    Workload w{ "short", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        std::string line = random_operand( 999 );
+        for ( int t( uniform( 1, 8 ) ); t > 1; --t )
+        {
+            char op = random_operator();
+            line += ' ';
+            line += op;
+            line += ' ';
+            // Expoentes pequenos, para que nem toda potência estoure.
+            line += op == '^' ? std::to_string( uniform( 0, 3 ) ) : random_operand( 999 );
+        }
+        w.lines.push_back( line );
+    }
+    return w;
+}
+
+/*!
+ * Poucas linhas muito longas, sem parênteses.
+ * Os termos vêm em pares `+ a * b - a * b`, de modo que o valor acumulado
+ * volta a zero a cada par e a avaliação percorre a linha inteira.
+ */
+Workload make_long_flat( std::size_t n_lines_, std::size_t n_terms_ )
+{
+    Workload w{ "long_flat", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        std::string line = "1";
+        for ( std::size_t t( 1 ); t + 4 <= n_terms_; t += 4 )
+        {
+            auto a = std::to_string( uniform( 1, 99 ) );
+            auto b = std::to_string( uniform( 1, 99 ) );
+            line += " + " + a + " * " + b + " - " + a + " * " + b;
+        }
+        w.lines.push_back( line );
+    }
+    return w;
+}
+
+/*!
+ * Linhas com erros: cada modelo provoca um dos códigos de `Parser::ParserResult`
+ * (ou um erro de avaliação), em uma coluna que varia com o prefixo válido.
+ */
+Workload make_errors( std::size_t n_lines_ )
+{
+    const std::vector< std::string > suffixes =
+    {
+        "",              // UNEXPECTED_END_OF_EXPRESSION (linha só com ws)
+        " + a",          // ILL_FORMED_INTEGER
+        " * - 5",        // ILL_FORMED_INTEGER (o "-" precisa vir colado ao número)
+        " -",            // MISSING_TERM
+        " 12",           // EXTRANEOUS_SYMBOL
+        " + ( 1 + 2",    // MISSING_CLOSING_PARENTHESIS
+        " + 32768",      // INTEGER_OUT_OF_RANGE
+        " / 0",          // DIVISION_BY_ZERO
+        " % 0",          // DIVISION_BY_ZERO
+    };
+
+    Workload w{ "errors", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        const auto & suffix = suffixes[ i % suffixes.size() ];
+        if ( suffix.empty() )
+        {
+            w.lines.push_back( random_ws( 8 ) );
+            continue;
+        }
+        std::string line = random_operand( 999 );
+        for ( int t( uniform( 0, 4 ) ); t > 0; --t )
+            line += std::string( " + " ) + random_operand( 99 );
+        w.lines.push_back( line + suffix );
+    }
+    return w;
+}
+
+/// Expressões válidas em que o resultado (ou um valor intermediário) sai dos limites de um short.
+Workload make_overflow( std::size_t n_lines_ )
+{
+    Workload w{ "overflow", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        std::string line;
+        switch ( i % 4 )
+        {
+            case 0: line = std::to_string( uniform( 200, 32767 ) ) + " * " + std::to_string( uniform( 200, 32767 ) ); break;
+            case 1: line = std::to_string( uniform( 10, 99 ) ) + " ^ " + std::to_string( uniform( 4, 9 ) ); break;
+            case 2: line = "32767 + " + std::to_string( uniform( 1, 999 ) ) + " - 1000"; break;
+            default: line = "-32768 - " + std::to_string( uniform( 1, 999 ) ) + " + 1000"; break;
+        }
+        w.lines.push_back( line );
+    }
+    return w;
+}
+
+/// Linhas curtas com muito ws antes, entre e depois dos símbolos.
+Workload make_ws_padded( std::size_t n_lines_ )
+{
+    Workload w{ "ws_padded", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        std::string line = random_ws( 40 ) + random_operand( 999 );
+        for ( int t( uniform( 1, 6 ) ); t > 1; --t )
+            line += random_ws( 40 ) + '+' + random_ws( 40 ) + random_operand( 999 );
+        w.lines.push_back( line + random_ws( 40 ) );
+    }
+    return w;
+}
+
+/*!
+ * Poucas linhas com `depth_` níveis de parênteses: `1 - ( 2 - ( 1 - ( ... ) ) )`.
+ * O valor alterna entre dois valores pequenos a cada nível, então a avaliação
+ * percorre a linha inteira sem overflow.
+ */
+Workload make_deep_nested( std::size_t n_lines_, std::size_t depth_ )
+{
+    Workload w{ "deep_nested", {} };
+    for ( std::size_t i( 0 ); i < n_lines_; ++i )
+    {
+        std::string line;
+        for ( std::size_t d( 0 ); d < depth_; ++d )
+            line += d % 2 ? "2 - ( " : "1 - ( ";
+        line += std::to_string( uniform( 1, 9 ) );
+        for ( std::size_t d( 0 ); d < depth_; ++d )
+            line += " )";
+        w.lines.push_back( line );
+    }
+    return w;
+}
+
+// ================================================================================
+// Medidas.
+// ================================================================================
+
+/// Evita que o compilador descarte resultados que não são usados (cada medida grava aqui a soma dos seus resultados).
+volatile long g_sink = 0;
+
+/// Tempo mínimo gasto em cada medida (em nanossegundos): etapas rápidas são repetidas mais vezes.
+double g_min_total_ns = 300e6;
+
+/// Tamanho dos pedaços entregues ao `StreamEvaluator` (o de uma leitura típica de um pipe).
+const std::size_t STREAM_PIECE = 4096;
+
+/*!
+ * Executa `run_` pelo menos `reps_` vezes, e até somar `g_min_total_ns`, e
+ * retorna o menor tempo, em nanossegundos. O menor tempo é a estimativa menos
+ * afetada por interrupções e por outros processos.
+ */
+template < typename F >
+double best_of( int reps_, F run_ )
+{
+    double best = 1e300;
+    double total = 0;
+    for ( int r( 0 ); r < reps_ or total < g_min_total_ns; ++r )
+    {
+        auto start = std::chrono::steady_clock::now();
+        run_();
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration< double, std::nano >( stop - start ).count();
+        best = std::min( best, ns );
+        total += ns;
+    }
+    return best;
+}
+
+/// Listas de tokens de várias linhas, guardadas em um único vetor.
+struct TokenLists
+{
+    std::vector< Token > tokens;
+    std::vector< std::size_t > ends; //<! Fim de cada lista em `tokens`.
+
+    void add( std::span< const Token > list_ )
+    {
+        tokens.insert( tokens.end(), list_.begin(), list_.end() );
+        ends.push_back( tokens.size() );
+    }
+
+    template < typename F >
+    void for_each( F f_ ) const
+    {
+        std::size_t begin = 0;
+        for ( auto end : ends )
+        {
+            f_( std::span< const Token >( tokens.data() + begin, end - begin ) );
+            begin = end;
+        }
+    }
+};
+
+/*!
+ * Mede a calibração do corpus `name_`: um lexer mínimo (tabela de classes,
+ * acumulação dos dígitos e um desvio por classe) sobre os bytes de `w_`, sem
+ * usar o código do BARES, de modo que mudanças no BARES não a alteram. É a
+ * unidade de tempo da máquina na comparação com a referência.
+ */
+void calibrate( const Workload & w_, const std::string & name_, int reps_, std::vector< Measure > & out_ )
+{
+    unsigned char cls[ 256 ] = {};
+    for ( int c( '0' ); c <= '9'; ++c ) cls[ c ] = 1;
+    for ( char c : std::string_view( "+-*/%^()" ) ) cls[ static_cast< unsigned char >( c ) ] = 2;
+
+    const double ns = best_of( reps_, [&]
+    {
+        long sum = 0;
+        for ( const auto & line : w_.lines )
+        {
+            long value = 0;
+            for ( unsigned char c : line )
+            {
+                if ( cls[ c ] == 1 ) value = value * 10 + ( c - '0' );
+                else if ( cls[ c ] == 2 ) { sum += value ^ c; value = 0; }
+            }
+            sum += value;
+        }
+        g_sink = sum;
+    } );
+    out_.push_back( Measure{ name_, "calibration", w_.lines.size(), w_.bytes,
+                             ns / w_.lines.size(), w_.bytes / ( ns / 1e9 ) / 1e6 } );
+}
+
+/// Mede todas as etapas para um corpus.
+void run_workload( const Workload & w_, int reps_, std::vector< Measure > & out_ )
+{
+    Parser parser;
+    Evaluator evaluator;
+    Parser::Context parser_ctx;
+    Evaluator::Context eval_ctx;
+
+    // Entradas das etapas de avaliação, preparadas fora das medidas.
+    TokenLists infix, postfix;
+    std::size_t ok_bytes = 0;
+    std::size_t max_tokens = 0;
+    for ( const auto & line : w_.lines )
+    {
+        if ( parser.parse( line, parser_ctx ).type != Parser::ParserResult::PARSER_OK )
+            continue;
+        infix.add( parser_ctx.token_list );
+        eval_ctx.prepare( parser_ctx.token_list.size() );
+        evaluator.infix_to_postfix( parser_ctx.token_list, eval_ctx );
+        postfix.add( eval_ctx.postfix_expr );
+        ok_bytes += line.size() + 1;
+        max_tokens = std::max( max_tokens, parser_ctx.token_list.size() );
+    }
+    // As etapas medidas isoladamente usam um contexto preparado para a maior lista.
+    eval_ctx.prepare( max_tokens );
+
+    auto record = [&]( const char * stage_, std::size_t lines_, std::size_t bytes_, double ns_ )
+    {
+        if ( lines_ == 0 ) return;
+        out_.push_back( Measure{ w_.name, stage_, lines_, bytes_, ns_ / lines_, bytes_ / ( ns_ / 1e9 ) / 1e6 } );
+    };
+
+    record( "parse", w_.lines.size(), w_.bytes, best_of( reps_, [&]
+    {
+        long sum = 0;
+        for ( const auto & line : w_.lines )
+            sum += parser.parse( line, parser_ctx ).type;
+        g_sink = sum;
+    } ) );
+
+    record( "infix_to_postfix", infix.ends.size(), ok_bytes, best_of( reps_, [&]
+    {
+        long sum = 0;
+        infix.for_each( [&]( std::span< const Token > list_ )
+        {
+            evaluator.infix_to_postfix( list_, eval_ctx );
+            sum += eval_ctx.postfix_expr.size();
+        } );
+        g_sink = sum;
+    } ) );
+
+    record( "optimize_postfix", postfix.ends.size(), ok_bytes, best_of( reps_, [&]
+    {
+        long sum = 0;
+        postfix.for_each( [&]( std::span< const Token > list_ )
+        {
+            eval_ctx.postfix_expr.assign( list_ );
+            evaluator.optimize_postfix( eval_ctx );
+            sum += eval_ctx.postfix_expr.size();
+        } );
+        g_sink = sum;
+    } ) );
+
+    record( "evaluate_postfix", postfix.ends.size(), ok_bytes, best_of( reps_, [&]
+    {
+        long sum = 0;
+        postfix.for_each( [&]( std::span< const Token > list_ )
+        {
+            eval_ctx.curr_status = Evaluator::EvaluatorResult();
+            sum += evaluator.evaluate_postfix( list_, eval_ctx );
+        } );
+        g_sink = sum;
+    } ) );
+
+    const std::pair< const char *, LineEvaluator::mode_t > modes[] =
+    {
+        { "end_to_end", LineEvaluator::PIPELINE },
+        { "end_to_end_fused", LineEvaluator::FUSED },
+        { "end_to_end_compiled", LineEvaluator::COMPILED },
+    };
+    for ( const auto & [ stage, mode ] : modes )
+    {
+        LineEvaluator line_evaluator( mode );
+        record( stage, w_.lines.size(), w_.bytes, best_of( reps_, [&]
+        {
+            char out[ MAX_RESULT_LENGTH ];
+            long sum = 0;
+            for ( const auto & line : w_.lines )
+                sum += format_result( out, line_evaluator.evaluate( line ) ) - out;
+            g_sink = sum;
+        } ) );
+    }
+
+    StreamEvaluator streamer;
+    record( "end_to_end_stream", w_.lines.size(), w_.bytes, best_of( reps_, [&]
+    {
+        char out[ MAX_RESULT_LENGTH ];
+        long sum = 0;
+        for ( const auto & line : w_.lines )
+        {
+            std::string_view rest( line );
+            for ( ; rest.size() > STREAM_PIECE; rest.remove_prefix( STREAM_PIECE ) )
+                streamer.feed( rest.substr( 0, STREAM_PIECE ) );
+            streamer.feed( rest );
+            sum += format_result( out, streamer.finish() ) - out;
+        }
+        g_sink = sum;
+    } ) );
+}
+
+// ================================================================================
+// JSON.
+// ================================================================================
+
+/// Escreve as medidas em JSON, uma por linha (o formato lido por `read_json()`).
+void write_json( std::ostream & os_, const std::vector< Measure > & measures_ )
+{
+    os_ << "{\n  \"benchmarks\": [\n";
+    for ( std::size_t i( 0 ); i < measures_.size(); ++i )
+    {
+        const auto & m = measures_[i];
+        os_ << "    { \"workload\": \"" << m.workload << "\", \"stage\": \"" << m.stage
+            << "\", \"lines\": " << m.lines << ", \"bytes\": " << m.bytes
+            << std::fixed << std::setprecision( 2 )
+            << ", \"ns_per_line\": " << m.ns_per_line << ", \"mb_per_s\": " << m.mb_per_s << " }"
+            << ( i + 1 < measures_.size() ? ",\n" : "\n" );
+    }
+    os_ << "  ]\n}\n";
+}
+
+/// Valor (texto) do campo `key_` em uma linha escrita por `write_json()`.
+std::string json_field( const std::string & line_, const std::string & key_ )
+{
+    auto pos = line_.find( "\"" + key_ + "\": " );
+    if ( pos == std::string::npos ) return "";
+    pos += key_.size() + 4;
+    if ( line_[ pos ] == '"' )
+        return line_.substr( pos + 1, line_.find( '"', pos + 1 ) - pos - 1 );
+    return line_.substr( pos, line_.find_first_of( ", }", pos ) - pos );
+}
+
+/// Lê o tempo por linha de cada (corpus, etapa) de um arquivo escrito por `write_json()`.
+bool read_json( const char * path_, std::map< std::string, double > & ns_per_line_ )
+{
+    std::ifstream in( path_ );
+    if ( not in ) return false;
+    std::string line;
+    while ( std::getline( in, line ) )
+    {
+        auto workload = json_field( line, "workload" );
+        auto stage = json_field( line, "stage" );
+        auto ns = json_field( line, "ns_per_line" );
+        if ( not workload.empty() and not stage.empty() and not ns.empty() )
+            ns_per_line_[ workload + "/" + stage ] = std::stod( ns );
+    }
+    return true;
+}
+
+int main( int argc, char * argv[] )
+{
+    const char * json_path = nullptr;
+    const char * baseline_path = nullptr;
+    double tolerance = 0.25;
+    bool quick = false;
+
+    for ( int i( 1 ); i < argc; ++i )
+    {
+        std::string_view arg( argv[i] );
+        if ( arg == "--quick" ) quick = true;
+        else if ( arg == "--json" and i + 1 < argc ) json_path = argv[++i];
+        else if ( arg == "--baseline" and i + 1 < argc ) baseline_path = argv[++i];
+        else if ( arg == "--tolerance" and i + 1 < argc ) tolerance = std::strtod( argv[++i], nullptr );
+        else
+        {
+            std::cerr << "Uso: " << argv[0] << " [--quick] [--json arquivo] [--baseline arquivo] [--tolerance fração]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Com `--quick`, corpora 10 vezes menores e medidas mais curtas.
+    const std::size_t scale = quick ? 10 : 1;
+    if ( quick ) g_min_total_ns /= 10;
+    std::vector< Workload > workloads;
+    workloads.push_back( make_short( 200000 / scale ) );
+    workloads.push_back( make_long_flat( 20 / scale + 1, 100000 ) );
+    workloads.push_back( make_errors( 200000 / scale ) );
+    workloads.push_back( make_overflow( 200000 / scale ) );
+    workloads.push_back( make_ws_padded( 100000 / scale ) );
+    workloads.push_back( make_deep_nested( 20 / scale + 1, 100000 ) );
+
+    std::vector< Measure > measures;
+    for ( auto & w : workloads )
+        for ( const auto & line : w.lines ) w.bytes += line.size() + 1;
+    for ( const auto & w : workloads )
+    {
+        calibrate( workloads.front(), w.name, quick ? 3 : 5, measures );
+        run_workload( w, quick ? 3 : 5, measures );
+    }
+
+    std::cout << std::left << std::setw( 12 ) << "workload" << std::setw( 22 ) << "stage" << std::right
+              << std::setw( 10 ) << "lines" << std::setw( 14 ) << "ns/line" << std::setw( 12 ) << "MB/s" << "\n";
+    for ( const auto & m : measures )
+        std::cout << std::left << std::setw( 12 ) << m.workload << std::setw( 22 ) << m.stage << std::right
+                  << std::setw( 10 ) << m.lines
+                  << std::fixed << std::setprecision( 2 )
+                  << std::setw( 14 ) << m.ns_per_line << std::setw( 12 ) << m.mb_per_s << "\n";
+
+    if ( json_path != nullptr )
+    {
+        std::ofstream out( json_path );
+        write_json( out, measures );
+        if ( not out )
+        {
+            std::cerr << ">>> Não foi possível gravar \"" << json_path << "\"!\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( baseline_path == nullptr ) return EXIT_SUCCESS;
+
+    std::map< std::string, double > baseline;
+    if ( not read_json( baseline_path, baseline ) )
+    {
+        std::cerr << ">>> Não foi possível ler \"" << baseline_path << "\"!\n";
+        return EXIT_FAILURE;
+    }
+
+    // Comparação com a referência: razão entre o tempo atual e o de referência,
+    // cada um em unidades da calibração do corpus na sua máquina.
+    std::map< std::string, double > scale_now;
+    for ( const auto & m : measures )
+        if ( m.stage == "calibration" ) scale_now[ m.workload ] = m.ns_per_line;
+    bool calibrated = true;
+    for ( const auto & [ workload, ns ] : scale_now )
+        calibrated = calibrated and baseline.count( workload + "/calibration" );
+    if ( not calibrated )
+        std::cout << "\n>>> Aviso: " << baseline_path << " não tem a calibração de todos os corpora;"
+                  << " os tempos são comparados em ns, o que só vale na máquina em que a referência foi gravada.\n";
+
+    int regressions = 0;
+    int missing = 0;
+    std::cout << "\n>>> Comparação com " << baseline_path << " (tolerância de "
+              << std::setprecision( 0 ) << tolerance * 100 << "%):\n";
+    for ( const auto & m : measures )
+    {
+        if ( m.stage == "calibration" ) continue;
+        auto it = baseline.find( m.workload + "/" + m.stage );
+        if ( it == baseline.end() )
+        {
+            // Etapa ou corpus novo: a referência precisa ser gravada de novo (`--json`).
+            ++missing;
+            std::cout << std::left << std::setw( 12 ) << m.workload << std::setw( 22 ) << m.stage << std::right
+                      << std::setw( 9 ) << "-" << "  <<< SEM REFERÊNCIA\n";
+            continue;
+        }
+        double ratio = m.ns_per_line / it->second;
+        if ( calibrated ) ratio *= baseline[ m.workload + "/calibration" ] / scale_now[ m.workload ];
+        bool regression = ratio > 1 + tolerance;
+        regressions += regression;
+        std::cout << std::left << std::setw( 12 ) << m.workload << std::setw( 22 ) << m.stage << std::right
+                  << std::setprecision( 2 ) << std::setw( 8 ) << ratio << "x"
+                  << ( regression ? "  <<< REGRESSÃO" : "" ) << "\n";
+    }
+
+    if ( missing > 0 )
+        std::cout << ">>> Aviso: " << missing << " medida(s) sem referência em " << baseline_path
+                  << "; grave a referência de novo com `--json`.\n";
+    if ( regressions > 0 )
+    {
+        std::cout << ">>> FALHOU: " << regressions << " medida(s) mais lenta(s) que a referência.\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << ">>> OK: nenhuma regressão.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/*!
+ * Benchmark do `TableParser`.
+ *
+ * Gera `LINES` expressões aleatórias (com parênteses, ws, literais grandes e
+ * negativos, e uma fração de linhas mal formadas) e faz o parsing de cada
+ * uma com o `Parser` (descendente, escrito à mão, com o índice estrutural) e
+ * com o `TableParser` (tabela LL(1) gerada da gramática). Cada medida é a
+ * mais rápida de `REPS` execuções. O resultado, a coluna do erro e os tokens
+ * de cada linha são conferidos entre os dois; se algum divergir, o programa
+ * termina com `EXIT_FAILURE`.
+ *
+ * Compilar com:
+ *     g++ -Wall -std=c++20 -O2 stats.cpp structural_index.cpp parser.cpp table_parser.cpp bench_table.cpp -o bench_table
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>    // std::chrono::steady_clock
+#include <random>    // std::mt19937
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+
+#include "parser.h"
+#include "table_parser.h"
+
+/// Linhas geradas.
+const std::size_t LINES = 200000;
+/// Repetições de cada medida (vale a mais rápida).
+const int REPS = 5;
+
+/// Tempo por linha, em ns, da execução mais rápida de `f_` em `REPS` repetições.
+template < typename F >
+double best_ns( F f_ )
+{
+    double best = 0;
+    for ( int r( 0 ); r < REPS; ++r )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f_();
+        const double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() / LINES;
+        if ( r == 0 or ns < best ) best = ns;
+    }
+    return best;
+}
+
+int main()
+{
+    std::mt19937 gen( 42 );
+    const std::string ops = "+-*/%^";
+    auto literal = [&]() -> std::string
+    {
+        const auto r = gen() % 32;
+        if ( r == 0 ) return "0";
+        if ( r == 1 ) return "123456";
+        return std::to_string( static_cast< int >( gen() % 2001 ) - 1000 );
+    };
+    std::vector< std::string > lines( LINES );
+    for ( auto & line : lines )
+    {
+        const std::size_t terms = 1 + gen() % 8;
+        std::size_t open = 0;
+        for ( std::size_t t( 0 ); t < terms; ++t )
+        {
+            if ( t > 0 ) line += std::string( " " ) + ops[ gen() % ops.size() ] + " ";
+            while ( gen() % 4 == 0 ) { line += "( "; ++open; }
+            line += literal();
+            while ( open > 0 and gen() % 3 == 0 ) { line += " )"; --open; }
+        }
+        while ( open-- > 0 ) line += ")";
+        if ( gen() % 50 == 0 ) line += " +"; // Mal formada.
+        if ( gen() % 50 == 0 ) line.insert( line.begin() + gen() % line.size(), '#' );
+    }
+
+    Parser parser;
+    Parser::Context parser_ctx;
+    std::vector< Parser::ParserResult > expected( LINES );
+    const double parser_ns = best_ns( [&]{
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+            expected[ i ] = parser.parse( lines[ i ], parser_ctx );
+    } );
+
+    TableParser table;
+    TableParser::Context table_ctx;
+    std::vector< Parser::ParserResult > results( LINES );
+    const double table_ns = best_ns( [&]{
+        for ( std::size_t i( 0 ); i < LINES; ++i )
+            results[ i ] = table.parse( lines[ i ], table_ctx );
+    } );
+
+    // Conferir resultados e tokens, linha a linha.
+    bool ok = true;
+    std::size_t errors = 0;
+    for ( std::size_t i( 0 ); i < LINES and ok; ++i )
+    {
+        parser.parse( lines[ i ], parser_ctx );
+        table.parse( lines[ i ], table_ctx );
+        ok = expected[ i ].type == results[ i ].type and expected[ i ].at_col == results[ i ].at_col
+            and parser_ctx.token_list.size() == table_ctx.token_list.size();
+        for ( std::size_t k( 0 ); ok and expected[ i ].type == Parser::ParserResult::PARSER_OK and k < parser_ctx.token_list.size(); ++k )
+        {
+            const auto & a = parser_ctx.token_list[ k ];
+            const auto & b = table_ctx.token_list[ k ];
+            ok = a.type == b.type and a.symbol == b.symbol and a.value == b.value and a.col == b.col;
+        }
+        if ( expected[ i ].type != Parser::ParserResult::PARSER_OK ) ++errors;
+        if ( not ok ) std::cout << ">>> FALHOU: os parsers divergem em \"" << lines[ i ] << "\"\n";
+    }
+    if ( not ok ) return EXIT_FAILURE;
+
+    std::cout << std::setw( 12 ) << "lines" << std::setw( 12 ) << "errors"
+              << std::setw( 14 ) << "parser (ns)" << std::setw( 14 ) << "table (ns)" << "\n";
+    std::cout << std::setw( 12 ) << LINES << std::setw( 12 ) << errors
+              << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << parser_ns << std::setw( 14 ) << table_ns << "\n";
+    std::cout << ">>> OK: mesmos resultados, tokens e colunas.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,266 @@
+#include "column_evaluator.h"
+
+#include <algorithm> // std::fill_n, std::copy_n, std::min, std::max
+#include <cassert>   // assert
+#include <cstdint>   // std::int16_t, std::int32_t, std::int64_t, std::uint16_t, std::uint32_t, std::uint64_t
+#include <type_traits> // std::conditional_t
+
+namespace {
+    typedef Token::value_type value_type;
+    typedef Evaluator::EvaluatorResult EvaluatorResult;
+    typedef ColumnEvaluator::code_t code_t;
+    typedef std::span< const std::span< const value_type > > columns_t;
+    const std::size_t BLOCK = ColumnEvaluator::BLOCK;
+    const value_type OVERFLOW = EvaluatorResult::RESULT_OVERFLOW;
+    const value_type DIV_ZERO = EvaluatorResult::DIVISION_BY_ZERO;
+
+    /// Inteiro sem sinal da largura de `value_type` (somas e subtrações módulo 2^bits).
+    typedef std::conditional_t< sizeof( value_type ) == 2, std::uint16_t,
+            std::conditional_t< sizeof( value_type ) == 4, std::uint32_t,
+            std::conditional_t< sizeof( value_type ) == 8, std::uint64_t, uint128_t > > > uvalue_type;
+
+    /// Tipos onde `*` não transborda e o quociente de `/` é exato (só para operandos de 16 e 32 bits).
+    template < typename T > struct Wide { static constexpr bool exists = false; };
+    template <> struct Wide< std::int16_t > { static constexpr bool exists = true; typedef std::int32_t type; typedef float real; };
+    template <> struct Wide< std::int32_t > { static constexpr bool exists = true; typedef std::int64_t type; typedef double real; };
+
+    /// `b_`, ou 1 se `cond_` (0 ou 1), sem desvio.
+    template < typename T > T one_if( int cond_, T b_ )
+    {
+        const uvalue_type mask = -static_cast< uvalue_type >( cond_ );
+        return static_cast< T >( static_cast< uvalue_type >( b_ ) + ( ( 1 - static_cast< uvalue_type >( b_ ) ) & mask ) );
+    }
+
+    // Cada operador calcula uma linha: troca o primeiro operando pelo resultado
+    // e retorna o erro da linha (0 se não houve). Com operandos de 16 e 32 bits
+    // o código não tem desvios (as escolhas viram máscaras), para que o laço de
+    // `apply()` seja vetorizado pelo compilador.
+
+    /// `a + b`: transborda se os operandos têm o mesmo sinal e o resultado, o sinal oposto.
+    struct Add
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            const T r = static_cast< T >( static_cast< uvalue_type >( a_ ) + static_cast< uvalue_type >( b_ ) );
+            const T err = ( ( a_ ^ r ) & ( b_ ^ r ) ) < 0 ? OVERFLOW : 0;
+            a_ = r;
+            return err;
+        }
+    };
+
+    /// `a - b`: transborda se os operandos têm sinais opostos e o resultado não tem o sinal de `a`.
+    struct Sub
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            const T r = static_cast< T >( static_cast< uvalue_type >( a_ ) - static_cast< uvalue_type >( b_ ) );
+            const T err = ( ( a_ ^ b_ ) & ( a_ ^ r ) ) < 0 ? OVERFLOW : 0;
+            a_ = r;
+            return err;
+        }
+    };
+
+    /// `a * b`: o produto na largura dobrada é exato; transborda se não cabe de volta.
+    struct Mul
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            if constexpr ( Wide< T >::exists )
+            {
+                const auto p = static_cast< typename Wide< T >::type >( a_ ) * b_;
+                a_ = static_cast< T >( p );
+                return a_ != p ? OVERFLOW : 0;
+            }
+            else
+                return Numeric::mul( a_, b_, a_ ) ? 0 : OVERFLOW;
+        }
+    };
+
+    /*!
+     * `a / b`, em ponto flutuante: com operandos de até 16 (32) bits, o
+     * quociente em `float` (`double`) nunca é arredondado para outro inteiro,
+     * então truncá-lo dá o mesmo resultado da divisão inteira. As linhas com
+     * `b == 0` ou `min / -1` dividem por 1 (o resultado é descartado).
+     */
+    struct Div
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            if constexpr ( Wide< T >::exists )
+            {
+                typedef typename Wide< T >::real real;
+                const T zero = b_ == 0;
+                const T overflow = ( a_ == Numeric::min ) & ( b_ == -1 );
+                const T b = one_if( zero | overflow, b_ );
+                a_ = static_cast< T >( static_cast< std::int32_t >( static_cast< real >( a_ ) / static_cast< real >( b ) ) );
+                return static_cast< T >( zero * DIV_ZERO + overflow * OVERFLOW ); // Nunca os dois: `overflow` exige `b == -1`.
+            }
+            else
+            {
+                if ( b_ == 0 ) return DIV_ZERO;
+                return Numeric::div( a_, b_, a_ ) ? 0 : OVERFLOW;
+            }
+        }
+    };
+
+    /// `a % b = a - ( a / b ) * b`, com o quociente de `Div` (`x % -1` é 0, como `x % 1`).
+    struct Mod
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            if constexpr ( Wide< T >::exists )
+            {
+                typedef typename Wide< T >::real real;
+                const T zero = b_ == 0;
+                const T b = one_if( zero | ( b_ == -1 ), b_ );
+                const T q = static_cast< T >( static_cast< std::int32_t >( static_cast< real >( a_ ) / static_cast< real >( b ) ) );
+                a_ = static_cast< T >( static_cast< std::uint32_t >( a_ ) - static_cast< std::uint32_t >( q ) * static_cast< std::uint32_t >( b ) );
+                return static_cast< T >( zero * DIV_ZERO );
+            }
+            else
+            {
+                if ( b_ == 0 ) return DIV_ZERO;
+                return Numeric::mod( a_, b_, a_ ) ? 0 : OVERFLOW;
+            }
+        }
+    };
+
+    /// `a ^ b`: só escalar (o laço de quadrados sucessivos depende de cada expoente).
+    struct Pow
+    {
+        template < typename T > static T row( T & a_, T b_ )
+        {
+            return Numeric::power( a_, b_, a_ ) ? 0 : OVERFLOW;
+        }
+    };
+
+    /*!
+     * \brief Aplica o operador `Op` a um bloco: `a_[ i ] = a_[ i ] op b_[ i ]`.
+     * O erro de cada linha só é registrado em `st_` se ela ainda não tinha erro,
+     * então `st_` guarda o primeiro erro de cada linha. Depois de um erro, os
+     * valores da linha continuam sendo calculados (sem comportamento
+     * indefinido), mas são ignorados.
+     */
+    template < typename Op >
+    [[gnu::always_inline]] inline void apply( value_type * __restrict a_, const value_type * __restrict b_, value_type * __restrict st_ )
+    {
+#pragma GCC ivdep
+        for ( std::size_t i = 0; i < BLOCK; ++i )
+        {
+            const value_type err = Op::row( a_[ i ], b_[ i ] );
+            st_[ i ] = st_[ i ] != 0 ? st_[ i ] : err;
+        }
+    }
+
+    /*!
+     * \brief Executa o programa sobre as linhas `r0_` a `r0_ + n_ - 1` (no máximo `BLOCK`).
+     *
+     * As instruções são executadas em ordem sobre a pilha de blocos:
+     * `OP_PUSH` preenche um bloco com a constante, `OP_LOAD` copia o trecho da
+     * coluna da variável (o resto do bloco é preenchido com zeros, e essas
+     * linhas são descartadas) e cada operador combina os dois blocos do topo.
+     * No fim, o valor (o primeiro bloco de `stack_`) e o erro (`st_`) de
+     * cada linha são copiados para `results_` e `status_`.
+     * \return Quantidade de linhas com erro.
+     */
+    [[gnu::always_inline]] inline std::size_t run_block( const Program & prog_, columns_t columns_, std::size_t r0_, std::size_t n_,
+                                                         value_type * __restrict stack_, value_type * __restrict st_,
+                                                         value_type * __restrict results_, code_t * __restrict status_ )
+    {
+        std::fill_n( st_, BLOCK, 0 );
+        value_type * sp = stack_; // Próximo bloco livre da pilha.
+        for ( const auto & ins : prog_.code() )
+        {
+            switch ( ins.op )
+            {
+                case Program::OP_PUSH:
+                    std::fill_n( sp, BLOCK, ins.imm );
+                    sp += BLOCK;
+                    break;
+                case Program::OP_LOAD:
+                    std::copy_n( columns_[ ins.imm ].data() + r0_, n_, sp );
+                    std::fill_n( sp + n_, BLOCK - n_, 0 );
+                    sp += BLOCK;
+                    break;
+                case Program::OP_ADD: sp -= BLOCK; apply< Add >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_SUB: sp -= BLOCK; apply< Sub >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_MUL: sp -= BLOCK; apply< Mul >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_DIV: sp -= BLOCK; apply< Div >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_MOD: sp -= BLOCK; apply< Mod >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_POW: sp -= BLOCK; apply< Pow >( sp - BLOCK, sp, st_ ); break;
+                case Program::OP_HALT: break;
+            }
+        }
+
+        // Saída sem desvios: o valor é zerado nas linhas com erro. As linhas
+        // além de `n_` (só no último bloco) não contam como erros.
+        std::fill_n( st_ + n_, BLOCK - n_, 0 );
+        value_type errors = 0; // No máximo `BLOCK`, cabe em 16 bits.
+        for ( std::size_t i = 0; i < BLOCK; ++i )
+        {
+            const value_type failed = st_[ i ] != 0;
+            stack_[ i ] = static_cast< value_type >( stack_[ i ] & ( failed - 1 ) );
+            errors = static_cast< value_type >( errors + failed );
+        }
+        std::copy_n( stack_, n_, results_ );
+        for ( std::size_t i = 0; i < n_; ++i )
+            status_[ i ] = static_cast< code_t >( st_[ i ] );
+        return static_cast< std::size_t >( errors );
+    }
+
+    /// Executa um bloco (`run_block()`).
+    typedef std::size_t (*block_fn)( const Program &, columns_t, std::size_t, std::size_t,
+                                     value_type *, value_type *, value_type *, code_t * );
+
+    /// Versão compilada para a CPU base (SSE2, no x86-64).
+    std::size_t run_block_base( const Program & prog_, columns_t columns_, std::size_t r0_, std::size_t n_,
+                                value_type * stack_, value_type * st_, value_type * results_, code_t * status_ )
+    {
+        return run_block( prog_, columns_, r0_, n_, stack_, st_, results_, status_ );
+    }
+
+#if defined( __x86_64__ ) or defined( __i386__ )
+    /// Versão AVX2 (vetores de 32 bytes). Compilada para AVX2 mesmo sem `-mavx2`; só é chamada se a CPU suporta.
+    __attribute__(( target( "avx2" ) ))
+    std::size_t run_block_avx2( const Program & prog_, columns_t columns_, std::size_t r0_, std::size_t n_,
+                                value_type * stack_, value_type * st_, value_type * results_, code_t * status_ )
+    {
+        return run_block( prog_, columns_, r0_, n_, stack_, st_, results_, status_ );
+    }
+#endif
+
+    /// A melhor versão suportada pela CPU.
+    block_fn best_block( void )
+    {
+#if defined( __x86_64__ ) or defined( __i386__ )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) ) return run_block_avx2;
+#endif
+        return run_block_base;
+    }
+}
+
+/*!
+ * \brief Avalia o programa em todas as linhas, um bloco de `BLOCK` linhas por vez.
+ * A versão de `run_block()` (AVX2 ou a da CPU base) é escolhida no primeiro uso.
+ */
+std::size_t ColumnEvaluator::evaluate( const Program & prog_, columns_t columns_,
+                                       std::span< result_t > results_, std::span< code_t > status_ )
+{
+    assert( not prog_.code().empty() and prog_.code().back().op == Program::OP_HALT );
+    assert( columns_.size() >= prog_.variables() );
+    assert( status_.size() >= results_.size() );
+
+    static const block_fn run = best_block();
+    const std::size_t rows = results_.size();
+    for ( std::size_t v = 0; v < prog_.variables(); ++v )
+        assert( columns_[ v ].size() >= rows );
+
+    m_stack.resize( std::max< std::size_t >( prog_.max_depth(), 1 ) * BLOCK );
+    m_status.resize( BLOCK );
+    std::size_t errors = 0;
+    for ( std::size_t r0 = 0; r0 < rows; r0 += BLOCK )
+        errors += run( prog_, columns_, r0, std::min( BLOCK, rows - r0 ), m_stack.data(), m_status.data(),
+                       results_.data() + r0, status_.data() + r0 );
+    return errors;
+}
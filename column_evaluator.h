@@ -0,0 +1,69 @@
+#ifndef _COLUMN_EVALUATOR_H_
+#define _COLUMN_EVALUATOR_H_
+
+#include <cstddef>     // std::size_t
+#include <span>        // std::span
+#include <vector>      // std::vector
+
+#include "token.h"
+#include "evaluator.h" // Evaluator::result_t, Evaluator::EvaluatorResult
+#include "program.h"   // Program
+
+/*!
+ * Avaliador colunar de uma fórmula: executa um mesmo programa compilado
+ * (`Evaluator::compile()`, com variáveis) sobre muitas linhas de valores.
+ *
+ * Os valores chegam em colunas: `columns_[ v ][ r ]` é o valor da variável de
+ * número `v` (a ordem de `Parser::Context::variable_names`) na linha `r`. Em
+ * vez de interpretar o programa uma vez por linha, cada instrução é executada
+ * sobre um bloco de `BLOCK` linhas de uma vez: a pilha do programa guarda
+ * blocos de valores, e cada operador é um laço sobre o bloco. Com operandos
+ * de 16 e 32 bits, os laços de `+`, `-`, `*`, `/` e `%` não têm desvios e são
+ * vetorizados pelo compilador (`-O2` basta); no x86, uma cópia deles é
+ * compilada para AVX2 e escolhida em tempo de execução se a CPU suporta.
+ * O overflow é detectado por linha:
+ *  - `+` e `-` comparam os sinais dos operandos e do resultado;
+ *  - `*` multiplica na largura dobrada e confere se o produto cabe;
+ *  - `/` e `%` dividem em ponto flutuante (`float` ou `double`, onde o
+ *    quociente truncado é exato para esses operandos).
+ * `^` e as larguras de 64 e 128 bits usam a aritmética escalar da política.
+ *
+ * Cada linha recebe o seu próprio resultado: o primeiro erro (na ordem de
+ * avaliação do programa, a mesma de `Program::run()`) ou o valor. Depois de
+ * um erro, os valores da linha continuam sendo calculados, mas são ignorados.
+ *
+ * Os blocos são reaproveitados de uma chamada para a outra. Cada thread deve
+ * usar o seu próprio objeto.
+ */
+class ColumnEvaluator
+{
+    public:
+        typedef Evaluator::result_t result_t;
+        typedef Token::value_type value_type;
+        typedef Evaluator::EvaluatorResult::code_t code_t;
+
+        static constexpr std::size_t BLOCK = 1024; //<! Linhas avaliadas por vez.
+
+        /*!
+         * Avalia `prog_` em cada linha.
+         * \param columns_ Uma coluna por variável (pelo menos `prog_.variables()`), cada uma com pelo menos `results_.size()` valores.
+         * \param results_ Recebe o valor de cada linha (0 nas linhas com erro).
+         * \param status_ Recebe o erro de cada linha (`EVALUATOR_OK` se não houve), com o tamanho de `results_`.
+         * \return Quantidade de linhas com erro.
+         */
+        std::size_t evaluate( const Program & prog_, std::span< const std::span< const value_type > > columns_,
+                              std::span< result_t > results_, std::span< code_t > status_ );
+
+        /// Constutor default.
+        ColumnEvaluator() = default;
+        ~ColumnEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        ColumnEvaluator( const ColumnEvaluator & ) = delete;
+        ColumnEvaluator & operator=( const ColumnEvaluator & ) = delete;
+
+    private:
+        std::vector< value_type > m_stack;  //<! Pilha do programa: `max_depth()` blocos de `BLOCK` valores.
+        std::vector< value_type > m_status; //<! Erro de cada linha do bloco (0 se não houve).
+};
+
+#endif
@@ -1,10 +1,28 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <string>  // std::string
 #include <cstdlib> // EXIT_SUCCESS
+#include <string_view> // std::string_view
+#include <memory>  // std::unique_ptr
+#include <algorithm> // std::max
+#include <thread>  // std::thread::hardware_concurrency
+#include <cerrno>  // errno
+#include <cstring> // std::strerror
+#include <csignal> // std::signal, SIGINT, SIGTERM
+#include <unistd.h> // STDOUT_FILENO, ::isatty
 
 #include "parser.h"
 #include "evaluator.h"
+#include "line_evaluator.h"
+#include "result_cache.h"
+#include "output.h"
+#include "parallel_runner.h"
+#include "server.h"
+#include "line_reader.h"
+#include "stream_evaluator.h"
+#include "batch_evaluator.h"
+#include "stats.h"
 
 /*std::vector<std::string> expressions =
 {
@@ -42,81 +60,280 @@
     "   5 * 10 + 10 ^ 5 "
 };
 */
-void print_msg( const Parser::ParserResult & result)
-{    
-    // Have we got a parsing error?
-   
-    switch ( result.type )
-    {
-        case Parser::ParserResult::UNEXPECTED_END_OF_EXPRESSION:
-            std::cout << "Unexpected end of input at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ParserResult::ILL_FORMED_INTEGER:
-            std::cout << "Ill formed integer at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ParserResult::MISSING_TERM:
-            std::cout << "Missing <term> at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ParserResult::EXTRANEOUS_SYMBOL:
-            std::cout << "Extraneous symbol after valid expression found at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ParserResult::MISSING_CLOSING_PARENTHESIS:
-            std::cout << "Missing closing \")\" at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ParserResult::INTEGER_OUT_OF_RANGE:
-            std::cout << "Integer constant out of range beginning at column (" << result.at_col << ")!\n";
-            break;
-        default:
-            std::cout << "Unhandled error found!\n";
-            break;
-    }
+/// Imprime os contadores do cache na saída de erro.
+void print_cache_stats( const ResultCache::Stats & stats, std::size_t entries )
+{
+    std::cerr << "cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.evictions << " evictions (" << entries << " entries)\n";
 }
 
-void print_msg_eval( const Evaluator::EvaluatorResult & result )
+/// Encerra a instrumentação: grava as métricas uma última vez e imprime o relatório, se pedido.
+void finish_stats( bool print_, const char * file_ )
 {
-    
-    // Have we got a parsing error?
-    switch ( result.type )
-    {
-        case Evaluator::EvaluatorResult::DIVISION_BY_ZERO:
-            std::cout << "Division by zero!\n";
-            break;
-        case Evaluator::EvaluatorResult::RESULT_OVERFLOW:
-            std::cout << "Numeric overflow error!\n";
-            break;
-        default:
-            std::cout << "Unhandled error found!\n";
-            break;
-    }
+    if ( file_ != nullptr ) Stats::stop_periodic();
+    if ( print_ ) Stats::print( std::cerr );
 }
 
+/// Servidor em execução (`--listen`), encerrado por SIGINT ou SIGTERM.
+Server * running_server = nullptr;
+
+/// Tratador de SIGINT e SIGTERM no modo servidor.
+void stop_server( int )
+{
+    if ( running_server != nullptr ) running_server->stop();
+}
+
+/// Imprime a forma de uso do programa.
+void usage( const char * prog )
+{
+    std::cerr << "Uso: " << prog << " [--fused | --compiled | --table | --stream | --batch] [--cache N] [-j N] [--line-buffered] [--stats] [--stats-file F [--stats-interval S]] [arquivo...] > saida\n"
+              << "       " << prog << " --listen SOCKET [--fused | --compiled | --table] [--cache N] [-j N] [--stats] [--stats-file F [--stats-interval S]]\n"
+              << "  Sem arquivos (ou com \"-\") as expressões são lidas da entrada padrão.\n"
+              << "  --fused      parsing e avaliação em uma única passada.\n"
+              << "  --compiled   compila cada expressão para bytecode e a executa.\n"
+              << "  --table      faz o parsing com a tabela LL(1) gerada da gramática.\n"
+              << "  --stream     avalia cada linha em pedaços, sem guardar a linha inteira (não combina com --cache nem -j).\n"
+              << "  --batch      agrupa as linhas de cada lote pela forma e avalia cada grupo de uma vez, com SIMD (não combina com --cache nem -j).\n"
+              << "  --cache N    guarda os resultados das N últimas expressões distintas (LRU).\n"
+              << "  -j N         avalia as linhas com N threads (0: uma por núcleo); a saída mantém a ordem.\n"
+              << "  --listen SOCKET  fica no ar atendendo clientes no socket Unix SOCKET (uma expressão por linha, uma resposta por linha), com N workers.\n"
+              << "  --line-buffered  escreve cada resultado assim que fica pronto (padrão se a saída é um terminal).\n"
+              << "  --stats      ao final, imprime contadores e latências de cada etapa na saída de erro.\n"
+              << "  --stats-file F  grava as métricas em F (formato do Prometheus) a cada S segundos (padrão: 10) e ao final.\n";
+}
 
-int main()
+int main( int argc, char * argv[] )
 {
-    std::string expr;  // Guarda temporariamente a linha do arquivo
-    Parser my_parser; // Instancia um parser.
-    Evaluator my_evaluator; //Instancia um evaluator.
-    // Tentar analisar cada expressão da lista.
-    while( std::getline(std::cin, expr) )
+    LineEvaluator::mode_t mode = LineEvaluator::PIPELINE;
+    bool stream = false;        // Avaliar as linhas em pedaços (StreamEvaluator)?
+    bool batch = false;         // Avaliar as linhas em lotes, agrupadas pela forma (BatchEvaluator)?
+    std::size_t cache_size = 0; // Zero: sem cache.
+    std::size_t n_threads = 1;  // Uma thread: modo serial.
+    std::vector< const char * > files; // Arquivos de entrada, na ordem da linha de comando.
+    // Em um terminal cada resultado aparece assim que fica pronto; caso contrário, a saída só é escrita quando o buffer enche.
+    auto flush_mode = ::isatty( STDOUT_FILENO ) ? ResultWriter::LINE : ResultWriter::THROUGHPUT;
+    bool print_stats = false;      // Imprimir as estatísticas ao final?
+    const char * stats_file = nullptr; // Arquivo das métricas periódicas.
+    unsigned stats_interval = 10;  // Intervalo das métricas periódicas, em segundos.
+    const char * listen_path = nullptr; // Socket do modo servidor.
+
+    for ( int i( 1 ); i < argc; ++i )
     {
-        // Fazer o parsing desta expressão.
-        auto result = my_parser.parse( expr );
-        // Preparar cabeçalho da saida.
-        // Se deu pau, imprimir a mensagem adequada.
-        if ( result.type != Parser::ParserResult::PARSER_OK ){
-            print_msg( result );
-            continue;
+        std::string_view arg( argv[i] );
+        // Com `--fused` o parsing e a avaliação são feitos em uma única passada,
+        // sem lista de tokens nem lista pósfixa.
+        if ( arg == "--fused" ) mode = LineEvaluator::FUSED;
+        // Com `--compiled` cada expressão é compilada para bytecode e então executada.
+        else if ( arg == "--compiled" ) mode = LineEvaluator::COMPILED;
+        // Com `--table` o parsing é feito pela tabela LL(1) gerada da gramática (TableParser).
+        else if ( arg == "--table" ) mode = LineEvaluator::TABLE;
+        // Com `--stream` cada linha é lida e avaliada em pedaços, com memória limitada.
+        else if ( arg == "--stream" ) stream = true;
+        // Com `--batch` as linhas com a mesma forma são avaliadas juntas, uma por lane.
+        else if ( arg == "--batch" ) batch = true;
+        // Com `--cache N` expressões repetidas (a menos de ws) não são avaliadas de novo.
+        else if ( arg == "--cache" and i + 1 < argc ) cache_size = std::strtoul( argv[++i], nullptr, 10 );
+        // Com `-j N` as linhas são avaliadas em paralelo por N threads.
+        else if ( arg == "-j" and i + 1 < argc )
+        {
+            n_threads = std::strtoul( argv[++i], nullptr, 10 );
+            if ( n_threads == 0 ) n_threads = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+        // Com `--listen SOCKET` o programa vira um servidor, que atende clientes no socket Unix indicado.
+        else if ( arg == "--listen" and i + 1 < argc ) listen_path = argv[++i];
+        // Com `--line-buffered` cada resultado é escrito assim que fica pronto (pipes interativos).
+        else if ( arg == "--line-buffered" ) flush_mode = ResultWriter::LINE;
+        // Com `--stats` as etapas são instrumentadas e o relatório vai para a saída de erro ao final.
+        else if ( arg == "--stats" ) print_stats = true;
+        // Com `--stats-file F` as métricas são gravadas periodicamente em F, no formato do Prometheus.
+        else if ( arg == "--stats-file" and i + 1 < argc ) stats_file = argv[++i];
+        else if ( arg == "--stats-interval" and i + 1 < argc ) stats_interval = std::strtoul( argv[++i], nullptr, 10 );
+        // Qualquer outro argumento que não seja uma opção é um arquivo de entrada.
+        else if ( arg == "-" or ( not arg.empty() and arg.front() != '-' ) ) files.push_back( argv[i] );
+        else
+        {
+            usage( argv[0] );
+            return EXIT_FAILURE;
         }
-       // Recuperar a lista de tokens.
-        auto lista = my_parser.get_tokens();
-        
-        auto eval_result = my_evaluator.evaluate( lista );
-        
-        if( eval_result.type != Evaluator::EvaluatorResult::EVALUATOR_OK ){
-            print_msg_eval( eval_result );
+    }
+    // O servidor lê as expressões dos clientes, uma linha inteira por vez.
+    const bool server_conflict = listen_path != nullptr and ( stream or batch or not files.empty() );
+    if ( files.empty() ) files.push_back( "-" );
+    // O cache e as threads precisam da linha inteira; os lotes têm o seu próprio laço.
+    if ( server_conflict or ( stream and batch ) or ( ( stream or batch ) and ( cache_size > 0 or n_threads > 1 ) ) )
+    {
+        usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    // A instrumentação só é ligada se foi pedida (antes de criar as threads).
+    if ( print_stats or stats_file != nullptr )
+    {
+        if ( not Stats::enabled() ) Stats::enable();
+        if ( not Stats::enabled() ) std::cerr << "Aviso: compilado com BARES_NO_STATS, as estatísticas ficam vazias.\n";
+        if ( stats_file != nullptr ) Stats::start_periodic( stats_file, stats_interval );
+    }
+
+    if ( listen_path != nullptr )
+    {
+        // Os workers (um por thread de `-j`) ficam quentes de um cliente para o outro.
+        Server server( n_threads, mode, cache_size );
+        if ( not server.listen( listen_path ) )
+        {
+            std::cerr << "Não foi possível escutar em \"" << listen_path << "\": " << std::strerror( errno ) << "\n";
+            return EXIT_FAILURE;
+        }
+        running_server = &server;
+        std::signal( SIGINT, stop_server );
+        std::signal( SIGTERM, stop_server );
+        server.run();
+        running_server = nullptr;
+        if ( cache_size > 0 ) print_cache_stats( server.cache_stats(), n_threads * cache_size );
+        finish_stats( print_stats, stats_file );
+        return EXIT_SUCCESS;
+    }
+
+    // Arquivos regulares (inclusive a entrada padrão redirecionada de um arquivo)
+    // são mapeados em memória; pipes são lidos em blocos.
+    LineReader reader;
+    ResultWriter writer( STDOUT_FILENO, flush_mode );
+    int status = EXIT_SUCCESS;
+
+    if ( n_threads > 1 )
+    {
+        ParallelRunner runner( n_threads, mode, cache_size );
+        for ( auto file : files )
+        {
+            if ( not reader.open( file ) )
+            {
+                std::cerr << "Não foi possível abrir o arquivo \"" << file << "\"!\n";
+                status = EXIT_FAILURE;
+                continue;
+            }
+            runner.run( reader, writer );
+        }
+        if ( not writer.flush() ) status = EXIT_FAILURE;
+        if ( cache_size > 0 ) print_cache_stats( runner.cache_stats(), n_threads * cache_size );
+        finish_stats( print_stats, stats_file );
+        return status;
+    }
+
+    if ( stream )
+    {
+        // Cada linha chega ao avaliador em pedaços do tamanho do buffer de leitura
+        // (ou inteira, se o arquivo foi mapeado), e nenhuma linha é guardada.
+        StreamEvaluator streamer;
+        std::string_view piece;
+        bool eol;
+        for ( auto file : files )
+        {
+            if ( not reader.open( file ) )
+            {
+                std::cerr << "Não foi possível abrir o arquivo \"" << file << "\"!\n";
+                status = EXIT_FAILURE;
+                continue;
+            }
+            while ( reader.next_piece( piece, eol ) )
+            {
+                streamer.feed( piece );
+                if ( not eol ) continue;
+                LineResult result = streamer.finish();
+                writer.put( result );
+                if ( Stats::enabled() ) Stats::local().add_result( result.parser_result.type, result.eval_result.type );
+            }
+        }
+        if ( not writer.flush() ) status = EXIT_FAILURE;
+        finish_stats( print_stats, stats_file );
+        return status;
+    }
+
+    if ( batch )
+    {
+        // As linhas são lidas em lotes; se a entrada não está mapeada, elas
+        // são copiadas para `input`, pois só valem até a próxima leitura.
+        const std::size_t BATCH_LINES = 64 * 1024;
+        BatchEvaluator batcher;
+        std::vector< std::string_view > lines;
+        std::vector< LineResult > results;
+        std::vector< std::size_t > ends;
+        std::string input;
+        std::string_view line;
+        for ( auto file : files )
+        {
+            if ( not reader.open( file ) )
+            {
+                std::cerr << "Não foi possível abrir o arquivo \"" << file << "\"!\n";
+                status = EXIT_FAILURE;
+                continue;
+            }
+            bool more = true;
+            while ( more )
+            {
+                lines.clear();
+                ends.clear();
+                input.clear();
+                while ( lines.size() < BATCH_LINES and ( more = reader.next( line ) ) )
+                {
+                    lines.push_back( line );
+                    if ( reader.stable() ) continue;
+                    input.append( line );
+                    ends.push_back( input.size() );
+                }
+                if ( not reader.stable() )
+                {
+                    // Agora que o lote não cresce mais, as linhas apontam para a cópia.
+                    std::size_t begin = 0;
+                    for ( std::size_t i( 0 ); i < ends.size(); ++i )
+                    {
+                        lines[i] = std::string_view( input.data() + begin, ends[i] - begin );
+                        begin = ends[i];
+                    }
+                }
+
+                results.resize( lines.size() );
+                batcher.evaluate( lines, results );
+                for ( const auto & result : results )
+                {
+                    writer.put( result );
+                    if ( Stats::enabled() ) Stats::local().add_result( result.parser_result.type, result.eval_result.type );
+                }
+            }
+        }
+        if ( not writer.flush() ) status = EXIT_FAILURE;
+        finish_stats( print_stats, stats_file );
+        return status;
+    }
+
+    std::string_view expr;  // Linha atual (aponta para o arquivo mapeado ou para o buffer de leitura).
+    LineEvaluator my_evaluator( mode ); // Parser e evaluator, com contextos reaproveitados a cada linha.
+    std::unique_ptr< ResultCache > cache;
+    if ( cache_size > 0 ) cache.reset( new ResultCache( cache_size ) );
+
+    LineResult result;
+    for ( auto file : files )
+    {
+        if ( not reader.open( file ) )
+        {
+            std::cerr << "Não foi possível abrir o arquivo \"" << file << "\"!\n";
+            status = EXIT_FAILURE;
             continue;
         }
-        else std::cout << my_evaluator.get_result() << "\n";
+        // Tentar analisar cada expressão da lista.
+        while( reader.next( expr ) )
+        {
+            StageTimer timer( Stats::LINE );
+            if ( not cache or not cache->lookup( expr, result ) )
+            {
+                result = my_evaluator.evaluate( expr );
+                if ( cache ) cache->insert( result );
+            }
+            writer.put( result );
+            if ( Stats::enabled() ) Stats::local().add_result( result.parser_result.type, result.eval_result.type );
+        }
     }
-    return EXIT_SUCCESS;
+
+    if ( not writer.flush() ) status = EXIT_FAILURE;
+    if ( cache ) print_cache_stats( cache->stats(), cache->size() );
+    finish_stats( print_stats, stats_file );
+    return status;
 }
@@ -1,18 +1,32 @@
 #ifndef _EVALUATOR_H_
 #define _EVALUATOR_H_
 
-#include <stack>     // stack
 #include <string>    // string
 #include <vector>	// std::vector
+#include <span>      // std::span
 #include <cassert>   // assert
 #include <iterator> // std::distance()
-#include <cmath>     // pow
-#include <sstream>	 // std::stringstream.
+#include <type_traits> // std::is_same_v, std::is_constant_evaluated()
+#include <algorithm> // std::copy
 #include "token.h"
+#include "stats.h"       // StageTimer
+#include "arena.h"       // Arena
+#include "fixed_stack.h" // FixedStack
 
-class Evaluator{
+class Program; // Programa compilado (program.h).
+
+/*!
+ * Avaliador de expressões (conversão para pósfixa e avaliação).
+ * É um template sobre a política numérica (numeric_policy.h), que define a
+ * largura dos operandos e os limites de overflow; `Evaluator` é a política do programa.
+ * A conversão e a avaliação são `constexpr` (definidas neste cabeçalho), e também
+ * rodam em tempo de compilação (veja bares.h).
+ */
+template < typename Policy >
+class BasicEvaluator{
 	public:
-		typedef long int result_t;
+		typedef typename Policy::result_t result_t;
+		typedef BasicToken< typename Policy::value_type > Token; //<! Token com operandos da política.
 
 		struct EvaluatorResult{
 
@@ -24,57 +38,497 @@ class Evaluator{
 
 			code_t type;
 
-			explicit EvaluatorResult( code_t type_ = EVALUATOR_OK )
+			constexpr explicit EvaluatorResult( code_t type_ = EVALUATOR_OK )
 				: type{ type_ }
 			{/*empty*/}
 		};
 
-		EvaluatorResult evaluate( std::vector<Token> );
-		result_t get_result() const ;
+		/*! Estado de uma avaliação.
+		 *  O contexto pertence ao cliente e deve ser reutilizado entre as expressões.
+		 *  As listas e pilhas têm capacidade fixa e usam a memória da arena do contexto:
+		 *  `prepare()` esvazia a arena e reserva todas elas de uma vez, a partir do
+		 *  número de tokens da expressão. Depois das primeiras expressões a arena tem
+		 *  um só bloco, do tamanho da maior expressão vista, e a avaliação não faz
+		 *  mais nenhuma alocação.
+		 *  Cada thread deve usar o seu próprio contexto.
+		 */
+		struct Context{
+			/// Subárvore da expressão pósfixa, usada por optimize_postfix().
+			struct Subtree{
+				std::size_t begin; //<! Posição do primeiro token da subárvore.
+				bool constant;     //<! A subárvore é um único operando constante.
+				bool pure;         //<! A avaliação da subárvore nunca dá erro.
+			};
+
+			Arena arena;                        //<! Memória das listas e pilhas abaixo, descartada a cada expressão.
+			FixedStack<Token> postfix_expr;     //<! Expressão convertida para pósfixa.
+			FixedStack<Token> op_stack;         //<! Pilha de operadores da conversão infixa -> pósfixa.
+			FixedStack<result_t> val_stack;     //<! Pilha de operandos da avaliação pósfixa.
+			FixedStack<Subtree> fold_stack;     //<! Pilha de subárvores da otimização da expressão pósfixa.
+			EvaluatorResult curr_status;        //<! Estado atual da avaliação.
+			result_t final_result = 0;          //<! Resultado da última expressão avaliada.
+
+			/// Prepara o contexto para uma expressão (infixa) de até `n_` tokens, ou uma pósfixa de até `n_` tokens.
+			constexpr void prepare( std::size_t n_ ){
+				if( not std::is_constant_evaluated() ) arena.reset(); // Em `constexpr` as pilhas não usam a arena.
+				postfix_expr.reset( arena, n_ );
+				op_stack.reset( arena, n_ );
+				val_stack.reset( arena, n_ );
+				fold_stack.reset( arena, n_ );
+			}
+		};
+
+		/// Avalia a lista de tokens (infixa, sem variáveis) usando o contexto indicado.
+		constexpr EvaluatorResult evaluate( std::span<const Token>, Context & ) const;
+		/// Avalia a lista de tokens (infixa) usando o contexto interno.
+		constexpr EvaluatorResult evaluate( std::span<const Token> );
+		/// Retorna o resultado da última avaliação feita com o contexto interno.
+		constexpr result_t get_result() const ;
+
+		/// Compila a lista de tokens (infixa) para um programa que pode ser executado depois (só na política do programa).
+		void compile( std::span<const Token>, Context &, Program & ) const
+			requires std::is_same_v< Policy, Numeric >;
+
+		// Etapas de evaluate(), públicas para que possam ser medidas separadamente.
+		// O contexto já deve ter sido preparado (Context::prepare()) para listas do tamanho das recebidas.
+
+		/// Converts a expression in infix notation to a corresponding profix representation.
+		constexpr void infix_to_postfix( std::span<const Token>, Context & ) const;
+
+		/// Simplifies the postfix expression of the context (constant folding and algebraic identities).
+		constexpr void optimize_postfix( Context & ) const;
+
+		/// Evaluates a postfix expression (the status is reported in the context).
+		constexpr result_t evaluate_postfix( std::span<const Token>, Context & ) const;
+
+		// Regras de avaliação, compartilhadas com o FusedEvaluator.
+
+		/// Returns the precedence of the operator.
+		static constexpr int get_operator_precedence( const Token & );
+
+		/// Checks if the token works by right association.
+		static constexpr bool right_association( const Token & );
+
+		/// This is where we calculate values (with overflow checking) and return them.
+		static constexpr result_t apply_operation( result_t op1, result_t op2, const Token & ch, EvaluatorResult & );
 
 		/// Constutor default.
-        Evaluator() = default;
-        ~Evaluator() = default;
+        BasicEvaluator() = default;
+        ~BasicEvaluator() = default;
         /// Desligar cópia e atribuição.
-        Evaluator( const Evaluator & ) = delete;  // Construtor cópia.
-        Evaluator & operator=( const Evaluator & ) = delete; // Atribuição.
+        BasicEvaluator( const BasicEvaluator & ) = delete;  // Construtor cópia.
+        BasicEvaluator & operator=( const BasicEvaluator & ) = delete; // Atribuição.
 
     private:
-    	std::vector<Token> infix_expr;
-    	std::vector<Token> postfix_expr;
-    	EvaluatorResult curr_status;
-    	result_t final_result;
-
-    	/// Converts a expression in infix notation to a corresponding profix representation.
-		void infix_to_postfix( void );
+    	Context own_ctx; //<! Contexto usado pela versão de conveniência de `evaluate()`.
 
 		/// Checks whether the first operator has higher precedence over the second one.
-		bool has_higher_precedence(Token , Token);
-
-		/// Checks if the token works by right association.
-		bool right_association( Token );
+		constexpr bool has_higher_precedence( const Token &, const Token & ) const;
 
 		/// Checks whether a token is operator symbol or not. 
-		bool is_operator(Token);
+		constexpr bool is_operator( const Token & ) const;
 
 		/// Checks whether a token is a character is alphanumeric chanaracter (letter or numeric digit) or not. 
-		bool is_operand( Token );
+		constexpr bool is_operand( const Token & ) const;
 
 		/// Checks whether the token is an opening scope symbol
-		bool is_opening_scope( Token );
+		constexpr bool is_opening_scope( const Token & ) const;
 
 		/// Checks whether the token is a closing scope symbol
-		bool is_closing_scope( Token );
-
-		/// Returns the precedence of the operator.
-		int get_operator_precedence( Token );
+		constexpr bool is_closing_scope( const Token & ) const;
 
 		/// Return the value of a token.
-		result_t tk_2_int( Token );
+		constexpr result_t tk_2_int( const Token & ) const;
+};
 
-		/// This is where we calculate values and return them.
-		result_t apply_operation( result_t op1, result_t op2, Token ch );
+/*!
+* \brief compares two operators and return the higher precedence one.
+* Compara dois operadores para saber quem é o de maior precedência, muito relevante na hora da conversão de formato infixo para pósfixo
+* \param op1 primeiro token que é um operador a ser comparado
+* \param op2 segundo token que é um operador a ser comparado
+* \return Retorna 'true' caso op1 > op2 ou quando são iguais em precedência e o op1 tenha precedência a direita. Retorna 'false' caso contrário
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::has_higher_precedence( const Token & op1, const Token & op2 ) const{
+	bool result ( true );
+	if( get_operator_precedence( op1 ) == get_operator_precedence( op2 ) ){
+		if( right_association( op1 ) )
+			result = not result;
+	}
+	else{
+		result = get_operator_precedence( op1 ) > get_operator_precedence( op2 );
+	}
+	return result;
+}
+/*!
+	\brief verifica se é operador de associação a direita
+	Recebe um token e checa se é um operador de associação a direita, que no caso do bares, é somente a potenciação.
+	\param tk_ Token a ser avaliado
+	\return Retorna 'true' caso seja o operador de potenciação.
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::right_association( const Token & tk_ ){
+	return ( tk_.symbol == Token::POWER );
+}
+/*!
+	\brief Checa se o token é operador
+	usando o campo de tipo, podemos verificar se o token em questão é um operador ou não
+	\param tk_ Token a ser avaliado
+	\return Retorna 'true' caso seja um operador.
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::is_operator( const Token & tk_ ) const{
+	//return ( tk_.value == "+" or tk_.value == "-" or tk_.value == "/" or tk_.value == "%" or tk_.value == "*" or tk_.value == "^");
+	return tk_.type == Token::OPERATOR;
+}
+/*!
+	\brief Checa se o token é operando
+	usando o campo de tipo, podemos verificar se o token em questão é um operando (um número ou uma variável) ou não
+	\param tk_ Token a ser avaliado
+	\return Retorna 'true' caso seja um operando.
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::is_operand( const Token & tk_ ) const{
+	//return ( tk_.value >= "0" and tk_.value <= "9" );
+	return tk_.type == Token::OPERAND or tk_.type == Token::VARIABLE;
+}
+/*!
+	\brief Checa se o token é um parentesis abrindo
+	Basta comparar o símbolo do token, que só é "(" em tokens de escopo.
+	\param tk_ Token a ser avaliado
+	\return Retorna 'true' caso seja um parentesis abrindo.
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::is_opening_scope( const Token & tk_ ) const{
+	return tk_.symbol == Token::L_PAREN;
+}
 
-		result_t evaluate_postfix( void );
-};
-#endif
\ No newline at end of file
+/*!
+	\brief Checa se o token é um parentesis fechando
+	Basta comparar o símbolo do token, que só é ")" em tokens de escopo.
+	\param tk_ Token a ser avaliado
+	\return Retorna 'true' caso seja um parentesis fechando.
+*/
+template < typename Policy >
+constexpr bool
+BasicEvaluator< Policy >::is_closing_scope( const Token & tk_ ) const{
+	return tk_.symbol == Token::R_PAREN;
+}
+/*!
+	\brief verifica qual a precedência de um operador e a retorna.
+	Recebe um token e checa qual a precedência dele, associando um número inteiro que é retornado.
+	\param tk_ Token a ser avaliado
+	\return Retorna um inteiro representativo da precedência dele.
+*/
+template < typename Policy >
+constexpr int
+BasicEvaluator< Policy >::get_operator_precedence( const Token & tk_ ){
+	int weight = -1;
+
+	switch ( tk_.symbol ){
+		case Token::POWER   : weight = 3; break;
+		case Token::TIMES   :
+		case Token::DIVIDED :
+		case Token::MOD     : weight = 2; break;
+		case Token::PLUS    :
+		case Token::MINUS   : weight = 1; break;
+		default             : break;
+	}
+
+	return weight;
+}
+/*!
+	\brief converte uma expressão de formato infixo para pósfixo.
+	Utilizando um vetor de tokens dispostos de maneira infixa, utilizamos uma pilha para fazer a conversão. As funções anteriores de precedência serão
+	cruciais nesse ponto
+*/
+
+template < typename Policy >
+constexpr void
+BasicEvaluator< Policy >::infix_to_postfix( std::span<const Token> infix_, Context & ctx_ ) const{
+	auto & postfix = ctx_.postfix_expr;
+	auto & S = ctx_.op_stack; // Pilha de operadores (um vetor, para reaproveitar a memória).
+	postfix.clear();
+	S.clear();
+
+	// Percorrer cada caractere da expressão
+	for( const auto & Token : infix_ ){
+		// Abertura de escopo.
+		if( is_opening_scope( Token ) ){
+			S.push_back( Token );
+		}
+		else if( is_operand( Token ) ){
+			postfix.push_back( Token );
+		}
+		else if( is_closing_scope( Token ) ){
+			// Desempilhar ate aTokenar o escopo de abertura correspondente.
+			while( not S.empty() and not is_opening_scope( S.back() ) ){
+				postfix.push_back( S.back() );
+				S.pop_back();
+			}
+			S.pop_back();
+		}
+		else if( is_operator( Token ) ){
+			// Desempilhar as operações que tem maior (ou igual) prioridade.
+			while( not S.empty() and not is_opening_scope( S.back() ) and has_higher_precedence( S.back(), Token ) ){
+				postfix.push_back( S.back() );
+				S.pop_back();
+			}
+			S.push_back( Token ); // O novo operador sempre entra na pilha.
+		}
+		// Elemento não esperado.
+		else{
+			continue;
+		}
+		// Mandando pra saída
+	} //ranged-for
+	// Esvaziar a pilha para a saida ( operações pendentes ).
+	while( not S.empty() ){
+		postfix.push_back( S.back() );
+		S.pop_back();
+	}
+}
+/*!
+	\brief simplifica a expressão pósfixa do contexto, antes da avaliação ou da compilação.
+	A lista `ctx_.postfix_expr` é reescrita no próprio lugar (a saída nunca passa da posição lida), com uma pilha de subárvores:
+	- subárvores constantes cuja avaliação não dá erro viram um único operando (*constant folding*);
+	- operações neutras são removidas: `x*1`, `1*x`, `x/1`, `x^1`, `x+0`, `0+x` e `x-0` viram `x`;
+	- elementos absorventes descartam subárvores puras (que nunca dão erro): `0*x`, `x*0`, `x%1`, `x^0` e `1^x`.
+	Uma operação que dá erro não é dobrada, e só são removidas operações e subárvores que nunca dão erro; assim a avaliação
+	da lista otimizada encontra o mesmo primeiro erro (divisão por zero ou overflow) que a avaliação da lista original.
+	Cadeias associativas não são rebalanceadas: na forma pósfixa uma cadeia à esquerda já usa só duas posições da pilha,
+	e reassociar a cadeia mudaria o ponto em que o overflow é detectado.
+	\param ctx_ contexto com a expressão pósfixa (normalmente produzida por infix_to_postfix()).
+*/
+template < typename Policy >
+constexpr void
+BasicEvaluator< Policy >::optimize_postfix( Context & ctx_ ) const{
+	using Subtree = typename Context::Subtree;
+	auto & out = ctx_.postfix_expr;
+	auto & S = ctx_.fold_stack; // Pilha de subárvores (um vetor, para reaproveitar a memória).
+	S.clear();
+	std::size_t w = 0; // Fim da lista já otimizada.
+
+	// A subárvore é a constante `value_`?
+	auto is = [&]( const Subtree & st_, result_t value_ ){ return st_.constant and out[ st_.begin ].value == value_; };
+
+	for( std::size_t r = 0; r < out.size(); ++r ){
+		const Token tk = out[r];
+		if( is_operand( tk ) ){
+			// Uma variável não é constante, mas nunca dá erro.
+			S.push_back( Subtree{ w, tk.type == Token::OPERAND, true } );
+			out[w++] = tk;
+			continue;
+		}
+		const Subtree b = S.back(); S.pop_back();
+		const Subtree a = S.back(); S.pop_back(); // A subárvore `a` vem logo antes de `b` na lista.
+
+		enum { KEEP, LEFT, RIGHT, CONSTANT } action = KEEP;
+		result_t value = 0;
+		if( a.constant and b.constant ){
+			EvaluatorResult status;
+			value = apply_operation( out[ a.begin ].value, out[ b.begin ].value, tk, status );
+			if( status.type == EvaluatorResult::EVALUATOR_OK )
+				action = CONSTANT;
+		}
+		else{
+			switch( tk.symbol ){
+				case Token::PLUS:    if( is( b, 0 ) ) action = LEFT;
+									 else if( is( a, 0 ) ) action = RIGHT;
+									 break;
+				case Token::MINUS:   if( is( b, 0 ) ) action = LEFT;
+									 break;
+				case Token::TIMES:   if( is( b, 1 ) ) action = LEFT;
+									 else if( is( a, 1 ) ) action = RIGHT;
+									 else if( ( is( a, 0 ) and b.pure ) or ( is( b, 0 ) and a.pure ) ) action = CONSTANT;
+									 break;
+				case Token::DIVIDED: if( is( b, 1 ) ) action = LEFT;
+									 break;
+				case Token::MOD:     if( is( b, 1 ) and a.pure ) action = CONSTANT;
+									 break;
+				case Token::POWER:   if( is( b, 1 ) ) action = LEFT;
+									 else if( ( is( b, 0 ) and a.pure ) or ( is( a, 1 ) and b.pure ) ){ action = CONSTANT; value = 1; }
+									 break;
+				default:             break;
+			}
+		}
+
+		switch( action ){
+			case LEFT: // O resultado é `a`: descartar `b` e o operador.
+				w = b.begin;
+				S.push_back( a );
+				break;
+			case RIGHT: // O resultado é `b`: descartar `a` (e o operador), trazendo `b` para o lugar de `a`.
+				std::copy( out.begin() + b.begin, out.begin() + w, out.begin() + a.begin );
+				w = a.begin + ( w - b.begin );
+				S.push_back( Subtree{ a.begin, b.constant, b.pure } );
+				break;
+			case CONSTANT: // A subárvore inteira vira um operando, na coluna do seu primeiro token.
+				out[ a.begin ] = Token( Token::OPERAND, Token::NONE, value, out[ a.begin ].col );
+				w = a.begin + 1;
+				S.push_back( Subtree{ a.begin, true, true } );
+				break;
+			case KEEP:
+				out[w++] = tk;
+				S.push_back( Subtree{ a.begin, false, false } );
+				break;
+		}
+	}
+	out.resize( w );
+}
+/*!
+	\brief converte um token operando para um valor inteiro.
+	O valor já foi decodificado pelo parser, então basta convertê-lo para o tipo do resultado.
+	Variáveis não têm valor aqui: só um programa compilado (compile()) recebe os valores delas.
+	\param tk_ Token a ser convertido para inteiro
+	\return Retorna o valor inteiro armazenado no token.
+*/
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::result_t
+BasicEvaluator< Policy >::tk_2_int( const Token & tk_ ) const{
+	assert( tk_.type == Token::OPERAND );
+	return tk_.value;
+}
+
+/*!
+	\brief aplica operações em operandos
+	Aqui é onde os cálculos são devidamente feitos, com a aritmética verificada da política numérica
+	(o overflow é detectado na própria operação) e tendo-se o cuidado com divisão por zero.
+	\param op1 Primeiro operando
+	\param op2 Segundo operando
+	\param tk_ Token operador binário que usará os parâmetros op1 e op2.
+	\param status_ Recebe o erro, em caso de divisão por zero ou de overflow.
+	\return Retorna o valor inteiro da operação realizada.
+*/
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::result_t
+BasicEvaluator< Policy >::apply_operation( result_t op1, result_t op2, const Token & tk_, EvaluatorResult & status_ ){
+	result_t result = 42;
+	bool ok;
+	switch( tk_.symbol ){
+		case Token::PLUS:    ok = Policy::add( op1, op2, result ); break;
+		case Token::MINUS:   ok = Policy::sub( op1, op2, result ); break;
+		case Token::TIMES:   ok = Policy::mul( op1, op2, result ); break;
+		case Token::DIVIDED: if( op2 == 0 )
+							 {
+								status_ = EvaluatorResult(EvaluatorResult::DIVISION_BY_ZERO);
+								return 42; // you'll certainly need a towel now
+							 }
+							 ok = Policy::div( op1, op2, result ); break;
+		case Token::MOD:     if( op2 == 0 )
+							 {
+								status_ = EvaluatorResult(EvaluatorResult::DIVISION_BY_ZERO);
+								return 42;
+							 }
+							 ok = Policy::mod( op1, op2, result ); break;
+		case Token::POWER:   ok = Policy::power( op1, op2, result ); break;
+		default :            assert(false); ok = false;
+	}
+	if( not ok ){
+		status_ = EvaluatorResult(EvaluatorResult::RESULT_OVERFLOW);
+		return 42; // Carry a towel
+	}
+	return result;
+}
+/*!
+	\brief avalia uma expressão pósfixa e retorna o resultado ou um erro.
+	Aqui é onde de fato acontecem os diversos cálculos para obtermos o resultado final da expressão passada. Utilizamos uma lista em formato pósfixo
+	e jogamos operadores numa pilha até aparecer um operador, desempilha dois operando e retorna o resultado pra pilha. Ao final, irá restar somente
+	um elemento na pilha, que será o resultado. Cada operação verifica se o valor está além dos limites da política numérica.
+	A avaliação é interrompida no primeiro erro (divisão por zero ou overflow), que fica registrado em `ctx_.curr_status`.
+	\param postfix_ expressão em formato pósfixo (normalmente `ctx_.postfix_expr`).
+	\param ctx_ contexto com a pilha de operandos e o estado da avaliação.
+	\return Retorna um valor inteiro que é o resultado da expressão que foi avaliada.
+*/
+
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::result_t
+BasicEvaluator< Policy >::evaluate_postfix( std::span<const Token> postfix_, Context & ctx_ ) const{
+	auto & S = ctx_.val_stack; // Pilha de operandos (um vetor, para reaproveitar a memória).
+	S.clear();
+
+	for( const auto & tk : postfix_ ){
+		if( is_operand( tk ) ){
+			S.push_back( tk_2_int( tk ) );
+		}
+		else if ( is_operator( tk ) ){
+			auto op2 = S.back(); S.pop_back();
+			auto op1 = S.back(); S.pop_back();
+
+			// Realiza a operação sobre os elementos (com verificação de overflow).
+			auto result = apply_operation( op1, op2, tk, ctx_.curr_status );
+			if( ctx_.curr_status.type != EvaluatorResult::EVALUATOR_OK )
+				return result;
+			S.push_back( result );
+		}
+		else{
+			assert( false );
+		}
+	}
+	// A pilha não pode estar vazia, pois no topo deve estar o resultado.
+	assert( not S.empty() );
+	return S.back();
+}
+/*!
+	\brief Está é a função que o cliente tem acesso para poder fazer avaliação de expressões
+	Recebe-se uma lista de tokens que devem estar dispostos de maneira infixa e as funções de conversão para pósfixo, de otimização e de avaliação
+	de uma expressão pósfixa são chamadas. A lista não é copiada, e todo o estado da avaliação fica no contexto do cliente, de modo que um mesmo
+	Evaluator pode ser compartilhado por várias threads (cada uma com o seu contexto).
+	\param e_ lista de tokens em formato infixo.
+	\param ctx_ contexto (reutilizável) que recebe o estado e o resultado da avaliação.
+	\return Retorna um EvaluatorResult, indicando se a avaliação ocorreu sem problemas ou caso contrário qual erro aconteceu.
+*/
+
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::EvaluatorResult
+BasicEvaluator< Policy >::evaluate( std::span<const Token> e_, Context & ctx_ ) const{
+	ctx_.curr_status = EvaluatorResult( EvaluatorResult::EVALUATOR_OK ); // "Resetar" a msg de status p/ OK.
+	ctx_.prepare( e_.size() ); // Reservar as listas e pilhas da expressão (na arena do contexto).
+
+	{
+		StageTimer timer( Stats::CONVERT );
+		infix_to_postfix( e_, ctx_ );
+		optimize_postfix( ctx_ );
+	}
+	StageTimer timer( Stats::EVALUATE );
+	ctx_.final_result = evaluate_postfix( ctx_.postfix_expr, ctx_ );
+
+    return ctx_.curr_status;
+}
+/*!
+	\brief versão de conveniência de evaluate(), que usa o contexto interno do avaliador.
+	Não é reentrante: use evaluate( e_, ctx_ ) para compartilhar o avaliador entre threads.
+	\param e_ lista de tokens em formato infixo.
+	\return Retorna um EvaluatorResult, indicando se a avaliação ocorreu sem problemas ou caso contrário qual erro aconteceu.
+*/
+
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::EvaluatorResult
+BasicEvaluator< Policy >::evaluate( std::span<const Token> e_ ){
+	return evaluate( e_, own_ctx );
+}
+/*!
+	\brief retorna o valor da expressão avaliada (com o contexto interno) para o cliente.
+	\return Retorna um inteiro que é o resultado da expressão passada pro avaliador.
+*/
+
+template < typename Policy >
+constexpr typename BasicEvaluator< Policy >::result_t
+BasicEvaluator< Policy >::get_result(void) const{
+	return own_ctx.final_result;
+}
+
+// As variantes da política numérica são instanciadas uma vez só, em evaluator.cpp.
+extern template class BasicEvaluator< Int16Policy >;
+extern template class BasicEvaluator< Int32Policy >;
+extern template class BasicEvaluator< Int64Policy >;
+extern template class BasicEvaluator< Int128Policy >;
+
+/// Avaliador da política numérica do programa.
+typedef BasicEvaluator< Numeric > Evaluator;
+#endif
@@ -0,0 +1,98 @@
+#ifndef _FIXED_STACK_H_
+#define _FIXED_STACK_H_
+
+#include <algorithm>   // std::copy
+#include <cassert>     // assert
+#include <cstddef>     // std::size_t
+#include <memory>      // std::allocator, std::construct_at
+#include <span>        // std::span
+#include <type_traits> // std::is_trivially_copyable_v, std::is_constant_evaluated()
+
+#include "arena.h"
+
+/*!
+ * Pilha (ou lista) de capacidade fixa, com a memória tirada de uma `Arena`.
+ *
+ * A capacidade é definida em `reset()`, a partir do tamanho da expressão, e
+ * nunca muda: `push_back()` só grava o elemento e avança o topo, sem testar
+ * se precisa crescer (o limite só é verificado com `assert`). A interface é
+ * a mesma parte da de `std::vector` usada pelo `Evaluator`.
+ *
+ * A memória pertence à arena: depois de `Arena::reset()`, a pilha precisa de
+ * um novo `reset()` antes de ser usada.
+ *
+ * Em `constexpr` (avaliação em tempo de compilação, veja bares.h) não há
+ * arena: a pilha aloca os seus elementos com `std::allocator` e os libera no
+ * próximo `reset()` ou no destrutor.
+ */
+template < typename T >
+class FixedStack
+{
+    static_assert( std::is_trivially_copyable_v< T >, "Os elementos são copiados byte a byte e nunca destruídos." );
+
+    public:
+        typedef T value_type;
+
+        /// Esvazia a pilha e reserva, na arena, espaço para `capacity_` elementos.
+        constexpr void reset( Arena & arena_, std::size_t capacity_ )
+        {
+            if ( std::is_constant_evaluated() )
+            {
+                release();
+                m_data = std::allocator< T >().allocate( capacity_ );
+                for ( std::size_t i( 0 ); i < capacity_; ++i ) std::construct_at( m_data + i );
+            }
+            else m_data = arena_.allocate< T >( capacity_ );
+            m_size = 0;
+            m_capacity = capacity_;
+        }
+
+        /// Pilha vazia, sem memória até o primeiro `reset()`.
+        constexpr FixedStack() = default;
+        /// Só libera a memória alocada em `constexpr` (a da arena é descartada pela arena).
+        constexpr ~FixedStack() { if ( std::is_constant_evaluated() ) release(); }
+
+        constexpr void push_back( const T & value_ ) { assert( m_size < m_capacity ); m_data[ m_size++ ] = value_; }
+        constexpr void pop_back( void ) { assert( m_size > 0 ); --m_size; }
+        constexpr T & back( void ) { assert( m_size > 0 ); return m_data[ m_size - 1 ]; }
+        constexpr const T & back( void ) const { assert( m_size > 0 ); return m_data[ m_size - 1 ]; }
+
+        constexpr T & operator[]( std::size_t i_ ) { return m_data[ i_ ]; }
+        constexpr const T & operator[]( std::size_t i_ ) const { return m_data[ i_ ]; }
+
+        constexpr bool empty( void ) const { return m_size == 0; }
+        constexpr std::size_t size( void ) const { return m_size; }
+        constexpr std::size_t capacity( void ) const { return m_capacity; }
+        /// Esvazia a pilha (a capacidade não muda).
+        constexpr void clear( void ) { m_size = 0; }
+        /// Diminui (ou aumenta, até a capacidade) a quantidade de elementos.
+        constexpr void resize( std::size_t n_ ) { assert( n_ <= m_capacity ); m_size = n_; }
+        /// Copia os elementos de `list_` (que devem caber na capacidade).
+        constexpr void assign( std::span< const T > list_ )
+        {
+            assert( list_.size() <= m_capacity );
+            std::copy( list_.begin(), list_.end(), m_data );
+            m_size = list_.size();
+        }
+
+        constexpr T * data( void ) { return m_data; }
+        constexpr const T * data( void ) const { return m_data; }
+        constexpr T * begin( void ) { return m_data; }
+        constexpr T * end( void ) { return m_data + m_size; }
+        constexpr const T * begin( void ) const { return m_data; }
+        constexpr const T * end( void ) const { return m_data + m_size; }
+
+    private:
+        T * m_data = nullptr;       //<! Elementos (memória da arena).
+        std::size_t m_size = 0;     //<! Quantidade de elementos.
+        std::size_t m_capacity = 0; //<! Capacidade reservada em `reset()`.
+
+        /// Libera os elementos alocados em `constexpr`.
+        constexpr void release( void )
+        {
+            if ( m_data != nullptr ) std::allocator< T >().deallocate( m_data, m_capacity );
+            m_data = nullptr;
+        }
+};
+
+#endif
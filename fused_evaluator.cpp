@@ -0,0 +1,252 @@
+#include "fused_evaluator.h"
+
+/*!
+ * Este é o **ponto de entrada**.
+ * A expressão é percorrida uma única vez: cada operando é decodificado e
+ * validado assim que é lido, e cada operador é aplicado assim que o seu
+ * operando direito está completo.
+ *
+ * Depois de um erro de avaliação a expressão continua sendo analisada (sem
+ * calcular mais nada), porque um erro de parsing mais adiante tem prioridade,
+ * exatamente como no pipeline `Parser` + `Evaluator`.
+ *
+ * \param e_ A expressão a ser avaliada.
+ * \param ctx_ Contexto (reutilizável) com as pilhas da avaliação.
+ * \return O resultado do parsing, da avaliação e o valor da expressão.
+ */
+FusedEvaluator::FusedResult
+FusedEvaluator::evaluate( std::string_view e_, Context & ctx_ ) const
+{
+    ctx_.prepare( e_.size() );
+    State st{ e_, 0, Parser::ParserResult(), Evaluator::EvaluatorResult(), ctx_ };
+    result_t value = 0;
+
+    // Verificar se a string acabou sem conter uma expressão.
+    skip_ws( st );
+    if ( end_input( st ) )
+    {
+        st.parser_status = Parser::ParserResult( Parser::ParserResult::UNEXPECTED_END_OF_EXPRESSION, st.pos );
+    }
+    else
+    {
+        value = expression( st );
+
+        // Se sobrou algum caractere (que não seja ws), então existem símbolo(s) estranho(s)...
+        if ( st.parser_status.type == Parser::ParserResult::PARSER_OK )
+        {
+            skip_ws( st );
+            if ( not end_input( st ) )
+                st.parser_status = Parser::ParserResult( Parser::ParserResult::EXTRANEOUS_SYMBOL, st.pos );
+        }
+    }
+
+    return FusedResult{ st.parser_status, st.eval_status, value };
+}
+
+/*!
+ * Versão de conveniência de `evaluate()`, que usa um contexto interno.
+ * Não é reentrante: use `evaluate( e_, ctx_ )` para compartilhar o avaliador entre threads.
+ */
+FusedEvaluator::FusedResult
+FusedEvaluator::evaluate( std::string_view e_ )
+{
+    return evaluate( e_, own_ctx );
+}
+
+/// Pula os caracteres ws (espaço em branco ou tab).
+void FusedEvaluator::skip_ws( State & st_ ) const
+{
+    while ( not end_input( st_ ) and ( st_.expr[ st_.pos ] == ' ' or st_.expr[ st_.pos ] == '\t' ) )
+        ++st_.pos;
+}
+
+/// Verifica se chegamos ao fim da expressão.
+bool FusedEvaluator::end_input( const State & st_ ) const
+{
+    return st_.pos == st_.expr.size();
+}
+
+/*!
+ * \brief Salta ws e verifica se o próximo símbolo é um operador binário.
+ * O operador **não é consumido**; o cliente decide se ele deve ser aplicado agora.
+ * \param op_ Recebe o token do operador, se houver.
+ * \return `true` se o próximo símbolo for um operador binário.
+ */
+bool FusedEvaluator::peek_operator( State & st_, Token & op_ ) const
+{
+    skip_ws( st_ );
+    if ( end_input( st_ ) ) return false;
+
+    auto symbol = Token::to_symbol( st_.expr[ st_.pos ] );
+    if ( symbol == Token::NONE or symbol == Token::L_PAREN or symbol == Token::R_PAREN )
+        return false;
+
+    op_ = Token( Token::OPERATOR, symbol, 0, st_.pos );
+    return true;
+}
+
+/*!
+ * \brief Aceita um <integer>, com as mesmas regras e erros do `Parser`.
+ *
+ * ```
+ * <integer> := 0 | ["-"],<natural_number>;
+ * <natural_number> := <digit_excl_zero>,{<digit>};
+ * ```
+ * O valor é acumulado negado enquanto os dígitos são consumidos, e deixa de
+ * ser acumulado assim que sai dos limites da política numérica (`Numeric`).
+ *
+ * \return O valor do operando (zero em caso de erro, registrado em `parser_status`).
+ */
+FusedEvaluator::result_t FusedEvaluator::operand( State & st_ ) const
+{
+    skip_ws( st_ );
+    auto begin_token = st_.pos;
+    // Podemos receber um zero...
+    if ( not end_input( st_ ) and st_.expr[ st_.pos ] == '0' )
+    {
+        ++st_.pos;
+        return 0;
+    }
+
+    //... ou então um ["-"],<natural_number>
+    bool negative = not end_input( st_ ) and st_.expr[ st_.pos ] == '-';
+    if ( negative ) ++st_.pos;
+
+    if ( end_input( st_ ) or st_.expr[ st_.pos ] < '1' or st_.expr[ st_.pos ] > '9' )
+    {
+        st_.parser_status = Parser::ParserResult( Parser::ParserResult::ILL_FORMED_INTEGER, st_.pos );
+        return 0;
+    }
+
+    Token::value_type value = 0;
+    bool overflow = false;
+    while ( not end_input( st_ ) and st_.expr[ st_.pos ] >= '0' and st_.expr[ st_.pos ] <= '9' )
+    {
+        if ( not overflow )
+            overflow = not Numeric::push_digit( value, st_.expr[ st_.pos ] - '0' );
+        ++st_.pos;
+    }
+    if ( not negative and not overflow ) overflow = not Numeric::negate( value );
+
+    if ( overflow )
+    {
+        st_.parser_status = Parser::ParserResult( Parser::ParserResult::INTEGER_OUT_OF_RANGE, begin_token );
+        return 0;
+    }
+    return value;
+}
+
+/*!
+ * \brief Aceita uma <expr> e calcula o seu valor, sem recursão.
+ *
+ * ```
+ * <expr> := <term>,{ ("+"|"-"|"*"|"/"|"%"|"^"),<term> };
+ * <term> := "(",<expr>,")" | <integer>;
+ * ```
+ * Cada operando vai para a pilha de valores. Antes de empilhar um operador,
+ * os operadores pendentes que "prendem" mais forte (maior precedência, ou a
+ * mesma precedência sem associatividade à direita) são aplicados; um "(" é
+ * empilhado como barreira, e o ")" correspondente aplica tudo o que está
+ * acima dele. Os operadores são aplicados exatamente na ordem da lista
+ * pósfixa do `Evaluator`, então o primeiro erro de avaliação é o mesmo.
+ *
+ * \return O valor da expressão (zero em caso de erro de parsing, registrado em `parser_status`).
+ */
+FusedEvaluator::result_t FusedEvaluator::expression( State & st_ ) const
+{
+    auto & ops = st_.ctx.ops;
+    std::size_t open = 0; // Parênteses abertos (e ainda não fechados) até aqui.
+
+    for ( ;; )
+    {
+        // Os "(" que abrem o <term>.
+        skip_ws( st_ );
+        while ( not end_input( st_ ) and st_.expr[ st_.pos ] == '(' )
+        {
+            ops.push_back( Token( Token::SCOPE, Token::L_PAREN, 0, st_.pos ) );
+            ++open;
+            ++st_.pos;
+
+            skip_ws( st_ );
+            if ( end_input( st_ ) ) // Depois de um "(", precisamos de uma <expr>.
+            {
+                st_.parser_status = Parser::ParserResult( Parser::ParserResult::MISSING_TERM, st_.pos );
+                return 0;
+            }
+        }
+
+        st_.ctx.values.push_back( operand( st_ ) );
+        if ( st_.parser_status.type != Parser::ParserResult::PARSER_OK )
+            return 0;
+
+        // Cada ")" aplica os operadores pendentes até o "(" correspondente.
+        skip_ws( st_ );
+        while ( open > 0 and not end_input( st_ ) and st_.expr[ st_.pos ] == ')' )
+        {
+            while ( ops.back().type != Token::SCOPE )
+                reduce( st_ );
+            ops.pop_back();
+            --open;
+            ++st_.pos;
+            skip_ws( st_ );
+        }
+
+        Token op;
+        if ( not peek_operator( st_, op ) )
+            break;
+        ++st_.pos; // Consome o operador.
+
+        const auto prec = Evaluator::get_operator_precedence( op );
+        while ( not ops.empty() and ops.back().type != Token::SCOPE )
+        {
+            const auto top_prec = Evaluator::get_operator_precedence( ops.back() );
+            if ( top_prec < prec or ( top_prec == prec and Evaluator::right_association( op ) ) )
+                break;
+            reduce( st_ );
+        }
+        ops.push_back( op );
+
+        skip_ws( st_ );
+        if ( end_input( st_ ) ) // Depois de saltar ws, não encontramos mais nada!! Erro!!
+        {
+            st_.parser_status = Parser::ParserResult( Parser::ParserResult::MISSING_TERM, st_.pos );
+            return 0;
+        }
+    }
+
+    // Algum "(" ficou aberto: o ")" deveria estar aqui (o ws já foi saltado).
+    if ( open > 0 )
+    {
+        st_.parser_status = Parser::ParserResult( Parser::ParserResult::MISSING_CLOSING_PARENTHESIS, st_.pos );
+        return 0;
+    }
+
+    // Aplicar os operadores pendentes.
+    while ( not ops.empty() )
+        reduce( st_ );
+    return st_.ctx.values.back();
+}
+
+/// Desempilha um operador e os seus dois operandos, e empilha o resultado.
+void FusedEvaluator::reduce( State & st_ ) const
+{
+    auto & values = st_.ctx.values;
+    const auto op2 = values.back(); values.pop_back();
+    const auto op1 = values.back();
+    values.back() = apply( st_, op1, op2, st_.ctx.ops.back() );
+    st_.ctx.ops.pop_back();
+}
+
+/*!
+ * \brief Aplica um operador com as regras do `Evaluator`.
+ * Depois do primeiro erro de avaliação nada mais é calculado; o erro fica
+ * guardado até sabermos se a expressão inteira está bem formada.
+ */
+FusedEvaluator::result_t FusedEvaluator::apply( State & st_, result_t op1_, result_t op2_, const Token & op_ ) const
+{
+    if ( st_.eval_status.type != Evaluator::EvaluatorResult::EVALUATOR_OK )
+        return 0;
+
+    // A aritmética verificada registra a divisão por zero ou o overflow em `eval_status`.
+    return Evaluator::apply_operation( op1_, op2_, op_, st_.eval_status );
+}
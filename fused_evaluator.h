@@ -0,0 +1,108 @@
+#ifndef _FUSED_EVALUATOR_H_
+#define _FUSED_EVALUATOR_H_
+
+#include <string_view> // std::string_view
+
+#include "token.h"
+#include "parser.h"      // Parser::ParserResult
+#include "evaluator.h"   // Evaluator::EvaluatorResult e regras de avaliação.
+#include "arena.h"       // Arena
+#include "fixed_stack.h" // FixedStack
+
+/*!
+ * Avaliador que calcula o valor da expressão **durante** o parsing.
+ *
+ * Quando só o resultado numérico interessa, não precisamos da lista de tokens
+ * do `Parser` nem da lista pósfixa do `Evaluator`: este avaliador percorre a
+ * expressão uma única vez, com uma pilha de operandos e outra de operadores
+ * (a conversão de `Evaluator::infix_to_postfix()` e a avaliação pósfixa feitas
+ * juntas), usando as mesmas regras de precedência e associatividade de
+ * `Evaluator::get_operator_precedence()` e `Evaluator::right_association()`.
+ * Como o `Parser`, não há recursão: a profundidade dos parênteses só é
+ * limitada pela memória.
+ *
+ * Os resultados e erros são os mesmos do pipeline `Parser` + `Evaluator`:
+ * erros de parsing têm prioridade (mesmo código e coluna), e um erro de
+ * avaliação só é reportado se a expressão inteira estiver bem formada.
+ *
+ * Todo o estado de uma avaliação fica no contexto, que pertence ao cliente;
+ * um mesmo objeto pode ser compartilhado por várias threads, desde que cada
+ * uma use o seu próprio contexto.
+ */
+class FusedEvaluator
+{
+    public:
+        typedef Evaluator::result_t result_t;
+
+        /// Resultado da avaliação: o erro de parsing, o erro de avaliação e o valor.
+        struct FusedResult
+        {
+            Parser::ParserResult parser_result;       //<! Resultado do parsing.
+            Evaluator::EvaluatorResult eval_result;   //<! Resultado da avaliação (só vale se o parsing foi OK).
+            result_t value;                           //<! Valor da expressão (só vale se não houve erros).
+        };
+
+        /*! Pilhas de uma avaliação.
+         *  Assim como no `Evaluator`, as pilhas têm capacidade fixa e usam a
+         *  memória da arena do contexto, reservada a cada expressão a partir do
+         *  seu tamanho; depois das primeiras expressões não há mais alocação.
+         */
+        struct Context
+        {
+            Arena arena;                   //<! Memória das pilhas, descartada a cada expressão.
+            FixedStack< result_t > values; //<! Operandos (e resultados parciais) ainda não consumidos.
+            FixedStack< Token > ops;       //<! Operadores pendentes e "(" ainda abertos.
+
+            /// Prepara o contexto para uma expressão de até `n_` caracteres.
+            void prepare( std::size_t n_ )
+            {
+                arena.reset();
+                values.reset( arena, n_ );
+                ops.reset( arena, n_ );
+            }
+        };
+
+        /// Faz o parsing e avalia a expressão em uma única passada, no contexto indicado.
+        FusedResult evaluate( std::string_view e_, Context & ctx_ ) const;
+        /// Faz o parsing e avalia a expressão em uma única passada, no contexto interno.
+        FusedResult evaluate( std::string_view e_ );
+
+        /// Constutor default.
+        FusedEvaluator() = default;
+        ~FusedEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        FusedEvaluator( const FusedEvaluator & ) = delete;  // Construtor cópia.
+        FusedEvaluator & operator=( const FusedEvaluator & ) = delete; // Atribuição.
+
+    private:
+        /// Estado de uma avaliação (vive na pilha de `evaluate()`).
+        struct State
+        {
+            std::string_view expr;                   //<! Expressão sendo avaliada.
+            std::string_view::size_type pos;         //<! Posição atual dentro da expressão.
+            Parser::ParserResult parser_status;      //<! Primeiro erro de parsing encontrado.
+            Evaluator::EvaluatorResult eval_status;  //<! Primeiro erro de avaliação encontrado.
+            Context & ctx;                           //<! Pilhas da avaliação.
+        };
+
+        Context own_ctx; //<! Contexto usado pela versão de conveniência de `evaluate()`.
+
+        // Métodos de suporte (mesmas regras léxicas do Parser).
+        void skip_ws( State & ) const; // Pula os caracteres ws (espaço em branco ou tab).
+        bool end_input( const State & ) const; // Verifica se chegamos ao fim da expressão.
+        bool peek_operator( State &, Token & ) const; // Pula ws e espia o próximo operador, sem consumi-lo.
+
+        /// Aceita um <integer> e o valida, como `Parser::integer()` e `Parser::natural_number()`.
+        result_t operand( State & ) const;
+
+        /// Aceita uma <expr> (com parênteses) e retorna o seu valor.
+        result_t expression( State & ) const;
+
+        /// Aplica o operador do topo da pilha aos dois operandos do topo.
+        void reduce( State & ) const;
+
+        /// Aplica um operador, registrando o primeiro erro de avaliação.
+        result_t apply( State &, result_t op1_, result_t op2_, const Token & op_ ) const;
+};
+
+#endif
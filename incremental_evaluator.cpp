@@ -0,0 +1,862 @@
+#include "incremental_evaluator.h"
+
+#include <algorithm> // std::min, std::max, std::copy, std::none_of, std::upper_bound
+
+namespace {
+    typedef Evaluator::EvaluatorResult::code_t code_t;
+    const code_t EVAL_OK = Evaluator::EvaluatorResult::EVALUATOR_OK;
+
+    /// Fim do <integer> que começa na coluna `col_` de `text_`.
+    std::size_t integer_end( std::string_view text_, std::size_t col_ )
+    {
+        if ( text_[ col_ ] == '-' ) ++col_;
+        while ( col_ < text_.size() and text_[ col_ ] >= '0' and text_[ col_ ] <= '9' ) ++col_;
+        return col_;
+    }
+}
+
+const LineResult & IncrementalEvaluator::load( std::string_view expr_ )
+{
+    m_text.assign( expr_ );
+    m_damaged = false;
+    m_root = nullptr;
+    rebuild();
+    return m_result;
+}
+
+/*!
+ * \brief Aplica uma edição e recalcula o resultado.
+ *
+ * Se a edição não pode ser aplicada à árvore (em geral porque a expressão
+ * ficou mal formada, como no meio da digitação de um termo novo), o texto
+ * inteiro é analisado e a árvore fica danificada: `m_text` guarda o texto
+ * atual, que só difere do da árvore numa região. As edições seguintes
+ * aumentam essa região, e a cada uma tentamos aplicar a região inteira à
+ * árvore, como uma única edição; quando dá certo, a árvore volta a valer.
+ */
+const LineResult & IncrementalEvaluator::edit( std::size_t offset_, std::size_t removed_, std::string_view inserted_ )
+{
+    const std::size_t n = size();
+    offset_ = std::min( offset_, n );
+    removed_ = std::min( removed_, n - offset_ );
+
+    // Sem árvore: a expressão está mal formada e não há árvore para consertar.
+    if ( m_root == nullptr )
+    {
+        m_text.replace( offset_, removed_, inserted_ );
+        rebuild();
+        return m_result;
+    }
+
+    if ( m_damaged )
+    {
+        // A região danificada passa a cobrir também esta edição; o texto fora dela é o da árvore.
+        const std::size_t suffix = std::min( m_damage_suffix, n - offset_ - removed_ );
+        m_damage_begin = std::min( m_damage_begin, offset_ );
+        m_damage_suffix = suffix;
+        m_text.replace( offset_, removed_, inserted_ );
+        if ( m_allocated > COMPACT_FACTOR * m_built + COMPACT_SLACK )
+        {
+            // Tentativas demais de consertar a árvore: ela é descartada.
+            m_damaged = false;
+            m_root = nullptr;
+            rebuild();
+            return m_result;
+        }
+        // Consertar a árvore com a região inteira, como se fosse uma única edição.
+        const std::size_t old_size = total( m_root->root ) + m_root->tail;
+        const std::string_view repaired = std::string_view( m_text ).substr( m_damage_begin, m_text.size() - suffix - m_damage_begin );
+        if ( update( m_damage_begin, old_size - suffix - m_damage_begin, repaired ) )
+        {
+            m_damaged = false;
+            m_text.clear();
+        }
+        else
+            rebuild();
+        return m_result;
+    }
+
+    if ( m_allocated > COMPACT_FACTOR * m_built + COMPACT_SLACK )
+    {
+        // Arena cheia de nós descartados: análise completa.
+        m_text = text();
+        m_text.replace( offset_, removed_, inserted_ );
+        rebuild();
+        return m_result;
+    }
+
+    if ( not update( offset_, removed_, inserted_ ) )
+    {
+        // O trecho não forma termos isolados (a expressão pode ter ficado mal formada): analisar tudo.
+        m_text = text();
+        m_text.replace( offset_, removed_, inserted_ );
+        m_damaged = true;
+        m_damage_begin = offset_;
+        m_damage_suffix = n - offset_ - removed_;
+        rebuild();
+    }
+    return m_result;
+}
+
+/*!
+ * \brief Aplica uma edição à árvore, sem análise completa.
+ *
+ * Primeiro a edição desce pelos parênteses: enquanto ela está inteira dentro
+ * do conteúdo de um fator entre parênteses (sem tocar no "(" nem no ")"), o
+ * nível de trabalho passa a ser o desse fator. Nesse nível, `replace()` ou
+ * `splice()` troca os termos tocados; depois, cada nível de cima só ajusta o
+ * tamanho do fator que contém a edição e recalcula o caminho até a raiz da
+ * sua treap.
+ * \return `false` (e a árvore não muda) se o trecho editado não pôde ser
+ * analisado de novo isoladamente.
+ */
+bool IncrementalEvaluator::update( std::size_t offset_, std::size_t removed_, std::string_view inserted_ )
+{
+    // Descer até o nível mais interno que contém a edição.
+    m_path.clear();
+    Sum * sum = m_root;
+    std::size_t a = offset_;
+    std::size_t b = offset_ + removed_;
+    Element * e = nullptr; // Termo que contém `a` no nível `sum` (`nullptr` no ws final).
+    std::size_t pos = 0;   // Posição de `e`.
+    while ( a < total( sum->root ) )
+    {
+        e = sum->root;
+        pos = 0;
+        for ( ;; )
+        {
+            const std::size_t lt = total( e->left );
+            if ( a < pos + lt ) { e = e->left; continue; }
+            pos += lt;
+            if ( a < pos + length( e ) ) break;
+            pos += length( e );
+            e = e->right;
+        }
+        const std::size_t item = pos + e->gap;
+        if ( a < item ) break; // No ws ou no operador antes do termo.
+        // Fator que contém `a` (os fatores estão em ordem de posição).
+        auto f = std::upper_bound( e->factors, e->factors + e->n_factors, a - item,
+                                   []( std::size_t x_, const Factor & f_ ) { return x_ < f_.start; } ) - 1;
+        if ( f->inner == nullptr or a - item < f->start + 1u or b - item > f->start + f->len - 1u )
+            break;
+        m_path.push_back( { sum, pos, static_cast< std::uint32_t >( f - e->factors ) } );
+        const std::size_t inner = item + f->start + 1;
+        a -= inner;
+        b -= inner;
+        sum = f->inner;
+        e = nullptr;
+    }
+
+    // Caso comum: a edição fica dentro de um único termo (sem tocar nos vizinhos).
+    const bool single = e != nullptr and ( a > pos or pos == 0 ) and b <= pos + length( e );
+    if ( not ( single and replace( sum, e, pos, a - pos, removed_, inserted_ ) )
+         and not splice( sum, a, removed_, inserted_, false ) and not splice( sum, a, removed_, inserted_, true ) )
+        return false;
+
+    // Subir recalculando os fatores que contêm a edição.
+    const std::ptrdiff_t delta = static_cast< std::ptrdiff_t >( inserted_.size() ) - static_cast< std::ptrdiff_t >( removed_ );
+    for ( auto step = m_path.rbegin(); step != m_path.rend(); ++step )
+    {
+        resize_factor( step->sum->root, step->pos, step->factor, delta );
+        step->sum->result = apply( step->sum->root->summary );
+    }
+    set_result();
+    return true;
+}
+
+std::string IncrementalEvaluator::text( void ) const
+{
+    if ( m_root == nullptr or m_damaged ) return m_text;
+    std::string out;
+    out.reserve( size() );
+    std::vector< const Element * > order;
+    std::vector< EmitFrame > frames;
+    flatten( m_root->root, order );
+    emit( order, m_root, out, frames );
+    return out;
+}
+
+std::size_t IncrementalEvaluator::size( void ) const
+{
+    return m_root == nullptr or m_damaged ? m_text.size() : total( m_root->root ) + m_root->tail;
+}
+
+/*!
+ * \brief Analisa `m_text` inteiro; se estiver bem formado, reconstrói a árvore (e libera a arena).
+ * Se estiver mal formado e houver uma árvore danificada, ela fica guardada
+ * para ser consertada pelas próximas edições.
+ */
+void IncrementalEvaluator::rebuild( void )
+{
+    ++m_rebuilds;
+    m_result = LineResult();
+    m_result.parser_result = m_parser.parse( m_text, m_parser_ctx );
+    if ( m_result.parser_result.type != Parser::ParserResult::PARSER_OK )
+    {
+        if ( not m_damaged )
+        {
+            m_arena.reset();
+            m_allocated = 0;
+            m_root = nullptr;
+        }
+        return;
+    }
+
+    m_arena.reset();
+    m_allocated = 0;
+    m_damaged = false;
+
+    std::size_t tail;
+    const char * tail_text = build( m_text, tail );
+    m_root = make_sum( 0, tail_text, tail );
+    m_built = m_allocated;
+    m_text.clear();
+    set_result();
+}
+
+/*!
+ * \brief Analisa de novo só o termo `e_` (na posição `pos_` do nível `sum_`).
+ * Como em `splice()`, mas sem separar a treap no caso comum: se o texto
+ * editado ainda é um único termo, ele toma o lugar de `e_` no mesmo nó, e só
+ * o caminho da raiz até ele é recalculado. Se virou vários termos, eles
+ * tomam o lugar de `e_` na treap.
+ * \param a_ Posição da edição dentro do termo.
+ * \return `false` (e nada muda) se o texto editado não forma termos isolados.
+ */
+bool IncrementalEvaluator::replace( Sum * sum_, Element * e_, std::size_t pos_, std::size_t a_,
+                                    std::size_t removed_, std::string_view inserted_ )
+{
+    if ( patch_literal( e_, a_, removed_, inserted_ ) )
+    {
+        refresh( sum_->root, pos_ );
+        sum_->result = apply( sum_->root->summary );
+        return true;
+    }
+
+    // O termo novo é construído na arena; se ele couber no nó antigo, a arena volta para cá.
+    const Arena::Mark mark = m_arena.mark();
+    const std::size_t allocated = m_allocated;
+    m_scratch.clear();
+    if ( pos_ > 0 ) m_scratch += '0';
+    const std::size_t base = m_scratch.size();
+    const Element * old = e_;
+    m_order.assign( &old, &old + 1 );
+    emit( m_order, nullptr, m_scratch, m_emit );
+    m_scratch.replace( base + a_, removed_, inserted_ );
+
+    if ( m_parser.parse( m_scratch, m_parser_ctx ).type != Parser::ParserResult::PARSER_OK )
+        return false;
+    std::size_t tail;
+    build( m_scratch, tail );
+    const std::size_t first = pos_ > 0 ? 1 : 0;
+    bool ok = tail == 0 and m_elems.size() > first;
+    if ( ok and pos_ > 0 )
+    {
+        const Element * zero = m_elems.front();
+        ok = zero->item_len == 1 and zero->n_factors == 1 and zero->factors[ 0 ].inner == nullptr;
+    }
+    if ( ok and m_elems.size() > first + 1 )
+    {
+        // O termo virou vários (por exemplo, um `+` foi inserido): trocar o nó pelos termos novos.
+        Element * l, * m, * r;
+        split_end_lt( sum_->root, pos_ + 1, l, m );
+        split_start_le( m, 0, m, r );
+        sum_->root = merge( merge( l, treap_from( m_elems.data() + first, m_elems.data() + m_elems.size() ) ), r );
+        sum_->result = apply( sum_->root->summary );
+    }
+    else if ( ok )
+    {
+        // Copiar o termo novo para o nó antigo (que mantém os filhos e a prioridade).
+        const Element * n = m_elems.back();
+        const bool fits = n->text_len <= e_->text_len and n->n_factors <= e_->n_factors
+                          and std::none_of( n->factors, n->factors + n->n_factors, []( const Factor & f_ ) { return f_.inner; } );
+        e_->op = n->op;
+        e_->gap = n->gap;
+        e_->item_len = n->item_len;
+        e_->item = n->item;
+        if ( fits )
+        {
+            // Nada do que foi construído continua em uso: reaproveitar os vetores do nó antigo.
+            std::copy( n->text, n->text + n->text_len, e_->text );
+            std::copy( n->factors, n->factors + n->n_factors, e_->factors );
+            m_arena.rewind( mark );
+            m_allocated = allocated;
+        }
+        else
+        {
+            e_->text = n->text;
+            e_->factors = n->factors;
+        }
+        e_->text_len = n->text_len;
+        e_->n_factors = n->n_factors;
+        refresh( sum_->root, pos_ );
+        sum_->result = apply( sum_->root->summary );
+    }
+    m_elems.clear();
+    return ok;
+}
+
+/*!
+ * \brief Troca o valor de um número de `e_`, sem o `Parser`.
+ * Só vale se a edição fica dentro de um único número e o texto novo ainda é
+ * um <integer> dentro dos limites (o resto, inclusive os erros, fica com o
+ * `Parser`). Como o texto em volta não muda, o número não pode se juntar aos
+ * vizinhos.
+ * \param a_ Posição da edição dentro do termo.
+ */
+bool IncrementalEvaluator::patch_literal( Element * e_, std::size_t a_, std::size_t removed_, std::string_view inserted_ )
+{
+    if ( a_ < e_->gap ) return false;
+    const std::size_t rel = a_ - e_->gap;
+    Factor * f = std::upper_bound( e_->factors, e_->factors + e_->n_factors, rel,
+                                   []( std::size_t x_, const Factor & f_ ) { return x_ < f_.start; } ) - 1;
+    if ( f->inner or rel + removed_ > f->start + f->len )
+        return false;
+
+    // Posição do número no texto próprio (o conteúdo dos parênteses anteriores não está lá).
+    std::size_t own = e_->gap + f->start;
+    for ( const Factor * g = e_->factors; g != f; ++g )
+        if ( g->inner ) own -= g->len - 2;
+
+    m_scratch.assign( e_->text + own, f->len );
+    m_scratch.replace( rel - f->start, removed_, inserted_ );
+
+    // <integer> := 0 | ["-"],<natural_number>, com as regras de `Parser::integer()`.
+    const std::string_view lit = m_scratch;
+    value_type value = 0;
+    if ( lit != "0" )
+    {
+        const bool negative = not lit.empty() and lit[ 0 ] == '-';
+        const std::size_t first = negative ? 1 : 0;
+        if ( lit.size() == first or lit[ first ] < '1' or lit[ first ] > '9' ) return false;
+        for ( std::size_t i( first ); i < lit.size(); ++i )
+            if ( lit[ i ] < '0' or lit[ i ] > '9' or not Numeric::push_digit( value, lit[ i ] - '0' ) )
+                return false;
+        if ( not negative and not Numeric::negate( value ) ) return false;
+    }
+
+    const std::ptrdiff_t delta = static_cast< std::ptrdiff_t >( lit.size() ) - static_cast< std::ptrdiff_t >( f->len );
+    if ( delta != 0 )
+    {
+        char * text = allocate< char >( e_->text_len + delta );
+        std::copy( e_->text, e_->text + own, text );
+        std::copy( e_->text + own + f->len, e_->text + e_->text_len, text + own + lit.size() );
+        e_->text = text;
+        e_->text_len = static_cast< std::uint32_t >( e_->text_len + delta );
+    }
+    std::copy( lit.begin(), lit.end(), e_->text + own );
+
+    f->value = value;
+    f->len = static_cast< std::uint32_t >( lit.size() );
+    for ( Factor * g = f + 1; g != e_->factors + e_->n_factors; ++g )
+        g->start = static_cast< std::uint32_t >( g->start + delta );
+    e_->item_len = static_cast< std::uint32_t >( e_->item_len + delta );
+    e_->item = eval_product( e_->factors, e_->n_factors );
+    return true;
+}
+
+/*!
+ * \brief Analisa de novo os termos do nível `sum_` tocados pela edição.
+ *
+ * Os termos tocados são os que têm algum caractere (ou uma das pontas) no
+ * trecho `[a_, a_ + removed_]`; com `widen_`, mais um termo de cada lado. O
+ * texto desses termos, já editado, é analisado pelo `Parser`. Se houver
+ * termos antes deles, o texto começa pelo operador do primeiro; para que ele
+ * seja uma expressão, um "0" toma o lugar do termo anterior, e o primeiro
+ * termo do resultado precisa ser esse "0" sozinho (senão o operador editado
+ * liga o trecho ao termo anterior, e a região precisa crescer).
+ *
+ * \return `false` (e o nível fica como estava) se o texto não forma termos isolados.
+ */
+bool IncrementalEvaluator::splice( Sum * sum_, std::size_t a_, std::size_t removed_, std::string_view inserted_, bool widen_ )
+{
+    Element * l, * m, * r, * rest, * t;
+    split_end_lt( sum_->root, a_, l, rest );
+    split_start_le( rest, static_cast< std::ptrdiff_t >( a_ + removed_ - total( l ) ), m, r );
+    if ( m == nullptr )
+    {
+        // A edição está no ws final: o último termo vai junto.
+        split_end_lt( l, total( l ), l, m );
+    }
+    if ( widen_ )
+    {
+        if ( l ) { split_end_lt( l, total( l ), l, t ); m = merge( t, m ); }
+        if ( r ) { split_start_le( r, 0, t, r ); m = merge( m, t ); }
+    }
+    const std::size_t begin = total( l );
+
+    m_scratch.clear();
+    if ( l ) m_scratch += '0';
+    const std::size_t base = m_scratch.size();
+    m_order.clear();
+    flatten( m, m_order );
+    emit( m_order, r ? nullptr : sum_, m_scratch, m_emit );
+    m_scratch.replace( base + a_ - begin, removed_, inserted_ );
+
+    bool ok = m_parser.parse( m_scratch, m_parser_ctx ).type == Parser::ParserResult::PARSER_OK;
+    std::size_t tail = 0;
+    const char * tail_text = nullptr;
+    std::size_t first = 0;
+    if ( ok )
+    {
+        tail_text = build( m_scratch, tail );
+        if ( l )
+        {
+            // O "0" no lugar do termo anterior precisa ter ficado sozinho.
+            const Element * zero = m_elems.front();
+            ok = zero->item_len == 1 and zero->n_factors == 1 and zero->factors[ 0 ].inner == nullptr;
+            first = 1;
+        }
+        // ws no fim do trecho seria do `gap` do termo seguinte (não acontece sem `widen_`).
+        if ( r and tail > 0 ) ok = false;
+    }
+    if ( not ok )
+    {
+        m_elems.clear();
+        sum_->root = merge( merge( l, m ), r );
+        return false;
+    }
+
+    if ( r == nullptr )
+    {
+        sum_->tail_text = tail_text;
+        sum_->tail = tail;
+    }
+    sum_->root = merge( merge( l, treap_from( m_elems.data() + first, m_elems.data() + m_elems.size() ) ), r );
+    m_elems.clear();
+    sum_->result = apply( sum_->root->summary );
+    return true;
+}
+
+/*!
+ * \brief Constrói a árvore a partir dos tokens de `m_parser_ctx`, sem recursão.
+ *
+ * Cada "(" abre um nível em `m_frames`; cada `+` ou `-` do nível atual encerra
+ * um termo; os outros operadores só separam fatores. No ")" o nível é criado
+ * e vira um fator do termo do nível de fora.
+ *
+ * \param text_ Texto analisado (as colunas dos tokens são relativas a ele).
+ * \param tail_ Recebe o tamanho do ws depois do último termo.
+ * \return O ws depois do último termo (copiado para a arena).
+ */
+const char * IncrementalEvaluator::build( std::string_view text_, std::size_t & tail_ )
+{
+    m_frames.clear();
+    m_frames.push_back( { m_elems.size(), m_factors.size(), 0, NO_ITEM, 0, Token::PLUS, Token::NONE } );
+    std::size_t last_end = 0;
+
+    for ( const auto & tk : m_parser_ctx.token_list )
+    {
+        BuildFrame & f = m_frames.back();
+        if ( tk.type == Token::OPERAND )
+        {
+            if ( f.item_begin == NO_ITEM ) f.item_begin = tk.col;
+            last_end = integer_end( text_, tk.col );
+            m_factors.push_back( { nullptr, tk.value, static_cast< std::uint32_t >( tk.col - f.item_begin ),
+                                   static_cast< std::uint32_t >( last_end - tk.col ), f.factor_op } );
+        }
+        else if ( tk.type == Token::OPERATOR )
+        {
+            if ( tk.symbol == Token::PLUS or tk.symbol == Token::MINUS )
+            {
+                close_item( f, text_, last_end );
+                f.elem_op = tk.symbol;
+                f.gap_begin = last_end;
+                f.item_begin = NO_ITEM;
+            }
+            else
+                f.factor_op = tk.symbol;
+        }
+        else if ( tk.symbol == Token::L_PAREN )
+        {
+            if ( f.item_begin == NO_ITEM ) f.item_begin = tk.col;
+            m_frames.push_back( { m_elems.size(), m_factors.size(), tk.col + 1u, NO_ITEM, tk.col, Token::PLUS, Token::NONE } );
+        }
+        else // R_PAREN
+        {
+            close_item( f, text_, last_end );
+            Sum * inner = make_sum( f.elems_begin, copy_text( text_.substr( last_end, tk.col - last_end ) ), tk.col - last_end );
+            const std::size_t paren = f.paren;
+            m_frames.pop_back();
+            BuildFrame & outer = m_frames.back();
+            last_end = tk.col + 1u;
+            m_factors.push_back( { inner, 0, static_cast< std::uint32_t >( paren - outer.item_begin ),
+                                   static_cast< std::uint32_t >( last_end - paren ), outer.factor_op } );
+        }
+    }
+
+    close_item( m_frames.back(), text_, last_end );
+    tail_ = text_.size() - last_end;
+    return copy_text( text_.substr( last_end ) );
+}
+
+/// Cria o termo com os fatores do termo atual de `f_` (que termina em `end_`) e o acrescenta a `m_elems`.
+void IncrementalEvaluator::close_item( BuildFrame & f_, std::string_view text_, std::size_t end_ )
+{
+    const std::size_t n = m_factors.size() - f_.factors_begin;
+    Factor * factors = allocate< Factor >( n );
+    std::copy( m_factors.begin() + f_.factors_begin, m_factors.end(), factors );
+    m_factors.resize( f_.factors_begin );
+
+    // Texto próprio: do início do `gap` ao fim do termo, pulando o conteúdo dos parênteses.
+    std::size_t text_len = end_ - f_.gap_begin;
+    for ( std::size_t i( 0 ); i < n; ++i )
+        if ( factors[ i ].inner ) text_len -= factors[ i ].len - 2;
+    char * own = allocate< char >( text_len );
+    std::size_t from = f_.gap_begin, k = 0;
+    for ( std::size_t i( 0 ); i < n; ++i )
+    {
+        if ( not factors[ i ].inner ) continue;
+        const std::size_t open = f_.item_begin + factors[ i ].start + 1; // Depois do "(".
+        text_.copy( own + k, open - from, from );
+        k += open - from;
+        from = f_.item_begin + factors[ i ].start + factors[ i ].len - 1; // O ")".
+    }
+    text_.copy( own + k, end_ - from, from );
+
+    Element * e = allocate< Element >( 1 );
+    e->left = e->right = nullptr;
+    e->priority = next_priority();
+    e->op = f_.elem_op;
+    e->gap = static_cast< std::uint32_t >( f_.item_begin - f_.gap_begin );
+    e->item_len = static_cast< std::uint32_t >( end_ - f_.item_begin );
+    e->text = own;
+    e->text_len = static_cast< std::uint32_t >( text_len );
+    e->n_factors = static_cast< std::uint32_t >( n );
+    e->factors = factors;
+    e->item = eval_product( factors, e->n_factors );
+    m_elems.push_back( e );
+    f_.factor_op = Token::NONE;
+}
+
+IncrementalEvaluator::Sum * IncrementalEvaluator::make_sum( std::size_t begin_, const char * tail_text_, std::size_t tail_ )
+{
+    Sum * s = allocate< Sum >( 1 );
+    s->root = treap_from( m_elems.data() + begin_, m_elems.data() + m_elems.size() );
+    m_elems.resize( begin_ );
+    s->tail_text = tail_text_;
+    s->tail = tail_;
+    s->result = apply( s->root->summary );
+    return s;
+}
+
+/*!
+ * \brief Monta a treap de uma sequência de termos em O(n).
+ * Como numa árvore cartesiana: o ramo direito fica em `m_spine`, e cada termo
+ * novo desce por ele até achar um nó de prioridade maior. Os resumos são
+ * calculados depois, de baixo para cima.
+ */
+IncrementalEvaluator::Element * IncrementalEvaluator::treap_from( Element * const * first_, Element * const * last_ )
+{
+    m_spine.clear();
+    for ( ; first_ != last_; ++first_ )
+    {
+        Element * e = *first_;
+        Element * below = nullptr;
+        while ( not m_spine.empty() and m_spine.back()->priority < e->priority )
+        {
+            below = m_spine.back();
+            m_spine.pop_back();
+        }
+        e->left = below;
+        e->right = nullptr;
+        if ( not m_spine.empty() ) m_spine.back()->right = e;
+        m_spine.push_back( e );
+    }
+    if ( m_spine.empty() ) return nullptr;
+
+    // Pós-ordem (a altura da treap é O(log n)).
+    struct Pull
+    {
+        static void all( Element * t_ )
+        {
+            if ( t_ == nullptr ) return;
+            all( t_->left );
+            all( t_->right );
+            pull( t_ );
+        }
+    };
+    Pull::all( m_spine.front() );
+    return m_spine.front();
+}
+
+/*!
+ * \brief Valor de um produto.
+ * Os fatores são avaliados da esquerda para a direita com uma pilha de
+ * operandos e outra de operadores (como em `StreamEvaluator`), então o
+ * primeiro erro é o mesmo da avaliação da lista pósfixa.
+ */
+IncrementalEvaluator::Outcome IncrementalEvaluator::eval_product( const Factor * f_, std::uint32_t n_ )
+{
+    auto value_of = []( const Factor & f ) { return f.inner ? f.inner->result : Outcome{ f.value, EVAL_OK }; };
+    if ( n_ == 1 ) return value_of( f_[ 0 ] );
+
+    Evaluator::EvaluatorResult status;
+    auto reduce = [&]( void )
+    {
+        const Token op( Token::OPERATOR, m_pops.back(), 0, 0 );
+        m_pops.pop_back();
+        const auto op2 = m_pvalues.back(); m_pvalues.pop_back();
+        m_pvalues.back() = Evaluator::apply_operation( m_pvalues.back(), op2, op, status );
+        return status.type == EVAL_OK;
+    };
+
+    m_pvalues.clear();
+    m_pops.clear();
+    for ( std::uint32_t i( 0 ); i < n_; ++i )
+    {
+        if ( i > 0 )
+        {
+            const Token op( Token::OPERATOR, f_[ i ].op, 0, 0 );
+            const auto prec = Evaluator::get_operator_precedence( op );
+            while ( not m_pops.empty() )
+            {
+                const auto top_prec = Evaluator::get_operator_precedence( Token( Token::OPERATOR, m_pops.back(), 0, 0 ) );
+                if ( top_prec < prec or ( top_prec == prec and Evaluator::right_association( op ) ) )
+                    break;
+                if ( not reduce() ) return { 0, status.type };
+            }
+            m_pops.push_back( f_[ i ].op );
+        }
+        const Outcome v = value_of( f_[ i ] );
+        if ( v.err != EVAL_OK ) return v;
+        m_pvalues.push_back( v.value );
+    }
+    while ( not m_pops.empty() )
+        if ( not reduce() ) return { 0, status.type };
+    return { m_pvalues.back(), EVAL_OK };
+}
+
+/// Recalcula o caminho de `t_` até o termo na posição `pos_`.
+void IncrementalEvaluator::refresh( Element * t_, std::size_t pos_ )
+{
+    const std::size_t lt = total( t_->left );
+    if ( pos_ < lt )
+        refresh( t_->left, pos_ );
+    else if ( pos_ > lt )
+        refresh( t_->right, pos_ - lt - length( t_ ) );
+    pull( t_ );
+}
+
+/// Depois de uma edição dentro do fator `factor_` do termo na posição `pos_`: ajusta os tamanhos e recalcula.
+void IncrementalEvaluator::resize_factor( Element * t_, std::size_t pos_, std::uint32_t factor_, std::ptrdiff_t delta_ )
+{
+    const std::size_t lt = total( t_->left );
+    if ( pos_ < lt )
+        resize_factor( t_->left, pos_, factor_, delta_ );
+    else if ( pos_ > lt )
+        resize_factor( t_->right, pos_ - lt - length( t_ ), factor_, delta_ );
+    else
+    {
+        Factor * f = t_->factors;
+        f[ factor_ ].len = static_cast< std::uint32_t >( f[ factor_ ].len + delta_ );
+        for ( std::uint32_t i( factor_ + 1 ); i < t_->n_factors; ++i )
+            f[ i ].start = static_cast< std::uint32_t >( f[ i ].start + delta_ );
+        t_->item_len = static_cast< std::uint32_t >( t_->item_len + delta_ );
+        t_->item = eval_product( f, t_->n_factors );
+    }
+    pull( t_ );
+}
+
+/*!
+ * \brief Escreve o texto dos termos de `order_`, sem recursão nos parênteses.
+ * Cada termo escreve o seu texto próprio até o "(" de um fator entre
+ * parênteses; aí os termos do nível interno são acrescentados a `order_` e
+ * escritos, e o termo continua do ")" em diante.
+ */
+void IncrementalEvaluator::emit( std::vector< const Element * > & order_, const Sum * sum_, std::string & out_,
+                                 std::vector< EmitFrame > & frames_ )
+{
+    frames_.clear();
+    frames_.push_back( { 0, 0, order_.size(), sum_, 0, 0, 0 } );
+
+    while ( not frames_.empty() )
+    {
+        EmitFrame & f = frames_.back();
+        if ( f.idx == f.end )
+        {
+            if ( f.sum ) out_.append( f.sum->tail_text, f.sum->tail );
+            order_.resize( f.begin );
+            frames_.pop_back();
+            continue;
+        }
+
+        const Element * e = order_[ f.idx ];
+        const Sum * inner = nullptr;
+        for ( ; f.fi < e->n_factors and inner == nullptr; ++f.fi )
+        {
+            const Factor & fa = e->factors[ f.fi ];
+            if ( fa.inner == nullptr ) continue;
+            const std::uint32_t open = e->gap + fa.start - f.skipped + 1; // Depois do "(" no texto próprio.
+            out_.append( e->text + f.own, open - f.own );
+            f.own = open;
+            f.skipped += fa.len - 2;
+            inner = fa.inner;
+        }
+        if ( inner )
+        {
+            const std::size_t begin = order_.size();
+            flatten( inner->root, order_ );
+            frames_.push_back( { begin, begin, order_.size(), inner, 0, 0, 0 } );
+            continue;
+        }
+        out_.append( e->text + f.own, e->text_len - f.own );
+        ++f.idx;
+        f.fi = f.own = f.skipped = 0;
+    }
+}
+
+void IncrementalEvaluator::set_result( void )
+{
+    m_result = LineResult();
+    m_result.eval_result = Evaluator::EvaluatorResult( m_root->result.err );
+    m_result.value = m_root->result.err == EVAL_OK ? m_root->result.value : 0;
+}
+
+const char * IncrementalEvaluator::copy_text( std::string_view s_ )
+{
+    char * p = allocate< char >( s_.size() );
+    s_.copy( p, s_.size() );
+    return p;
+}
+
+std::uint32_t IncrementalEvaluator::next_priority( void )
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+//
+// Treap.
+//
+
+/// Recalcula o tamanho e o resumo de `t_` a partir dos filhos.
+void IncrementalEvaluator::pull( Element * t_ )
+{
+    Summary s = leaf( *t_ );
+    if ( t_->left ) s = compose( t_->left->summary, s );
+    if ( t_->right ) s = compose( s, t_->right->summary );
+    t_->summary = s;
+    t_->total = total( t_->left ) + length( t_ ) + total( t_->right );
+}
+
+IncrementalEvaluator::Element * IncrementalEvaluator::merge( Element * l_, Element * r_ )
+{
+    if ( l_ == nullptr ) return r_;
+    if ( r_ == nullptr ) return l_;
+    if ( l_->priority > r_->priority )
+    {
+        l_->right = merge( l_->right, r_ );
+        pull( l_ );
+        return l_;
+    }
+    r_->left = merge( l_, r_->left );
+    pull( r_ );
+    return r_;
+}
+
+void IncrementalEvaluator::split_end_lt( Element * t_, std::size_t a_, Element *& l_, Element *& r_ )
+{
+    if ( t_ == nullptr ) { l_ = r_ = nullptr; return; }
+    const std::size_t end = total( t_->left ) + length( t_ );
+    if ( end < a_ )
+    {
+        split_end_lt( t_->right, a_ - end, t_->right, r_ );
+        l_ = t_;
+    }
+    else
+    {
+        split_end_lt( t_->left, a_, l_, t_->left );
+        r_ = t_;
+    }
+    pull( t_ );
+}
+
+void IncrementalEvaluator::split_start_le( Element * t_, std::ptrdiff_t b_, Element *& l_, Element *& r_ )
+{
+    if ( t_ == nullptr ) { l_ = r_ = nullptr; return; }
+    const std::ptrdiff_t start = static_cast< std::ptrdiff_t >( total( t_->left ) );
+    if ( start <= b_ )
+    {
+        split_start_le( t_->right, b_ - start - static_cast< std::ptrdiff_t >( length( t_ ) ), t_->right, r_ );
+        l_ = t_;
+    }
+    else
+    {
+        split_start_le( t_->left, b_, l_, t_->left );
+        r_ = t_;
+    }
+    pull( t_ );
+}
+
+void IncrementalEvaluator::flatten( const Element * t_, std::vector< const Element * > & out_ )
+{
+    if ( t_ == nullptr ) return;
+    flatten( t_->left, out_ );
+    out_.push_back( t_ );
+    flatten( t_->right, out_ );
+}
+
+//
+// Resumos.
+//
+
+/// `x_ + offset_` módulo 2^bits (exato quando o resultado cabe em `value_type`).
+IncrementalEvaluator::value_type IncrementalEvaluator::shift( value_type x_, uvalue_type offset_ )
+{
+    return static_cast< value_type >( static_cast< uvalue_type >( static_cast< uvalue_type >( x_ ) + offset_ ) );
+}
+
+/// Resumo de um termo sozinho: `x + t` ou `x - t`.
+IncrementalEvaluator::Summary IncrementalEvaluator::leaf( const Element & e_ )
+{
+    Summary s{ Numeric::min, Numeric::max, 0, e_.item.err, false };
+    if ( e_.item.err != EVAL_OK ) return s; // O erro do termo vem antes da soma.
+
+    const value_type t = e_.item.value;
+    if ( e_.op == Token::PLUS )
+    {
+        if ( t >= 0 ) s.hi = static_cast< value_type >( Numeric::max - t );
+        else s.lo = static_cast< value_type >( Numeric::min - t );
+        s.offset = static_cast< uvalue_type >( t );
+    }
+    else
+    {
+        if ( t >= 0 ) s.lo = static_cast< value_type >( Numeric::min + t );
+        else s.hi = static_cast< value_type >( Numeric::max + t );
+        s.offset = static_cast< uvalue_type >( -static_cast< uvalue_type >( t ) );
+    }
+    return s;
+}
+
+/*!
+ * \brief Resumo do trecho `s1_` seguido do trecho `s2_`.
+ * A entrada `x` passa por `s1_` se está no seu intervalo; a saída `x + offset1`
+ * passa por `s2_` se está no intervalo de `s2_`. O intervalo composto é a
+ * imagem do primeiro cortada pelo segundo, trazida de volta para a entrada.
+ */
+IncrementalEvaluator::Summary IncrementalEvaluator::compose( const Summary & s1_, const Summary & s2_ )
+{
+    if ( s1_.empty or s1_.err != EVAL_OK ) return s1_; // O que vem depois nunca é calculado.
+    if ( s2_.empty ) return s2_;
+
+    const value_type lo = std::max( shift( s1_.lo, s1_.offset ), s2_.lo );
+    const value_type hi = std::min( shift( s1_.hi, s1_.offset ), s2_.hi );
+    if ( lo > hi ) return Summary{ 0, 0, 0, EVAL_OK, true };
+
+    const uvalue_type back = static_cast< uvalue_type >( -s1_.offset );
+    return Summary{ shift( lo, back ), shift( hi, back ),
+                    static_cast< uvalue_type >( s1_.offset + s2_.offset ), s2_.err, false };
+}
+
+/// Resultado de uma cadeia inteira (a entrada é zero).
+IncrementalEvaluator::Outcome IncrementalEvaluator::apply( const Summary & s_ )
+{
+    if ( s_.empty or s_.lo > 0 or s_.hi < 0 )
+        return { 0, Evaluator::EvaluatorResult::RESULT_OVERFLOW };
+    if ( s_.err != EVAL_OK )
+        return { 0, s_.err };
+    return { shift( 0, s_.offset ), EVAL_OK };
+}
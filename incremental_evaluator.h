@@ -0,0 +1,284 @@
+#ifndef _INCREMENTAL_EVALUATOR_H_
+#define _INCREMENTAL_EVALUATOR_H_
+
+#include <cstddef>     // std::size_t, std::ptrdiff_t
+#include <cstdint>     // std::uint16_t, std::uint32_t, std::uint64_t
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::conditional_t
+#include <vector>      // std::vector
+
+#include "token.h"
+#include "parser.h"         // Parser, Parser::ParserResult
+#include "evaluator.h"      // Evaluator::EvaluatorResult e regras de avaliação.
+#include "arena.h"          // Arena
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Avaliador de uma expressão que é editada aos poucos.
+ *
+ * Depois de `load()`, cada `edit()` troca um trecho do texto (posição,
+ * quantidade de caracteres removidos e texto inserido) e devolve o novo
+ * resultado, sem analisar de novo a expressão inteira. A expressão fica
+ * guardada como uma árvore, na memória de uma `Arena`:
+ *  - cada nível (a expressão inteira ou o conteúdo de um par de parênteses)
+ *    é uma cadeia de termos ligados por `+` e `-`, guardada como uma *treap*
+ *    ordenada pela posição no texto;
+ *  - cada termo é um produto (fatores ligados por `*`, `/`, `%` e `^`) cujos
+ *    fatores são números ou outros níveis entre parênteses;
+ *  - cada termo guarda o seu próprio texto (sem o conteúdo dos parênteses,
+ *    que fica nos níveis internos), o seu valor e o tamanho do seu trecho.
+ *
+ * Uma edição desce pelos parênteses que a contêm por inteiro até o nível mais
+ * interno possível; ali, só os termos tocados pela edição são analisados de
+ * novo (com o próprio `Parser`, sobre o texto desses termos) e trocados na
+ * treap. Se o texto novo não forma termos isolados (por exemplo, um `+`
+ * virou `*`), a região cresce um termo para cada lado; se ainda assim não
+ * dá, a expressão inteira é analisada de novo. Depois, os valores são
+ * recalculados só no caminho até a raiz.
+ *
+ * Para que esse caminho tenha O(log n) passos mesmo em cadeias de 100k
+ * termos, cada nó da treap guarda um resumo da avaliação da esquerda para a
+ * direita do seu trecho da cadeia: o intervalo de valores de entrada que não
+ * transbordam em nenhuma das somas parciais, o deslocamento total e o
+ * primeiro erro de algum termo. Os resumos se compõem em O(1), e o resultado
+ * (inclusive qual erro aparece primeiro) é exatamente o da avaliação da
+ * esquerda para a direita do `Evaluator`, sem reassociar nada. Produtos não
+ * têm resumo: são recalculados por inteiro, o que só custa caro em produtos
+ * muito longos.
+ *
+ * Os nós substituídos ficam na arena até a próxima análise completa, feita
+ * quando a arena passa de `COMPACT_FACTOR` vezes o tamanho da árvore; o
+ * custo é amortizado entre as edições.
+ *
+ * Uma edição que deixa a expressão mal formada (por exemplo, o `+` digitado
+ * antes do termo que vem depois dele) não descarta a árvore: ela fica
+ * guardada, junto com a região do texto que mudou, e volta a valer assim que
+ * essa região, analisada de novo, formar termos isolados. Enquanto isso, cada
+ * edição ainda analisa o texto inteiro, para achar a coluna do erro.
+ *
+ * Os resultados e erros (inclusive as colunas de erros de parsing) são os
+ * mesmos do pipeline `Parser` + `Evaluator` sobre o texto atual.
+ * Cada thread deve usar o seu próprio objeto.
+ */
+class IncrementalEvaluator
+{
+    public:
+        typedef Evaluator::result_t result_t;
+
+        /// Carrega uma nova expressão (descarta a anterior) e retorna o seu resultado.
+        const LineResult & load( std::string_view expr_ );
+        /*!
+         * Troca os `removed_` caracteres a partir de `offset_` por `inserted_`.
+         * Posições além do fim do texto são trazidas para o fim.
+         * \return O resultado da expressão editada.
+         */
+        const LineResult & edit( std::size_t offset_, std::size_t removed_, std::string_view inserted_ );
+
+        /// Resultado da expressão atual.
+        const LineResult & result( void ) const { return m_result; }
+        /// Texto atual da expressão.
+        std::string text( void ) const;
+        /// Tamanho do texto atual.
+        std::size_t size( void ) const;
+        /// Quantas vezes a expressão inteira foi analisada (em `load()`, em edições e para liberar a arena).
+        std::size_t rebuilds( void ) const { return m_rebuilds; }
+
+        /// Constutor default.
+        IncrementalEvaluator() = default;
+        ~IncrementalEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        IncrementalEvaluator( const IncrementalEvaluator & ) = delete;
+        IncrementalEvaluator & operator=( const IncrementalEvaluator & ) = delete;
+
+    private:
+        typedef Token::value_type value_type;
+        typedef Evaluator::EvaluatorResult::code_t code_t;
+        /// Inteiro sem sinal da largura de `value_type` (as somas dos resumos são feitas módulo 2^bits).
+        typedef std::conditional_t< sizeof( value_type ) == 2, std::uint16_t,
+                std::conditional_t< sizeof( value_type ) == 4, std::uint32_t,
+                std::conditional_t< sizeof( value_type ) == 8, std::uint64_t, uint128_t > > > uvalue_type;
+
+        struct Sum;
+
+        /// Valor de um termo ou de um nível, ou o primeiro erro da sua avaliação.
+        struct Outcome
+        {
+            value_type value; //<! Valor (só vale sem erro).
+            code_t err;       //<! Primeiro erro de avaliação (`EVALUATOR_OK` se não houve).
+        };
+
+        /*!
+         * Resumo de um trecho de uma cadeia de `+` e `-`, visto como uma função
+         * do valor acumulado `x` antes do trecho:
+         *  - se `x` está fora de [`lo`, `hi`] (ou se `empty`), alguma soma parcial transborda;
+         *  - senão, se `err` não é `EVALUATOR_OK`, o primeiro erro é o de um termo;
+         *  - senão o valor depois do trecho é `x + offset` (módulo 2^bits, mas
+         *    sempre dentro dos limites).
+         */
+        struct Summary
+        {
+            value_type lo, hi;  //<! Valores de entrada que não transbordam.
+            uvalue_type offset; //<! Soma (com sinal) dos termos do trecho.
+            code_t err;         //<! Primeiro erro de um termo do trecho.
+            bool empty;         //<! Qualquer entrada transborda.
+        };
+
+        /// Um fator de um produto: um número ou um nível entre parênteses.
+        struct Factor
+        {
+            Sum * inner;          //<! Nível entre parênteses (`nullptr` para um número).
+            value_type value;     //<! Valor do número.
+            std::uint32_t start;  //<! Posição do fator (ou do "(") a partir do início do termo.
+            std::uint32_t len;    //<! Tamanho do fator no texto (com os parênteses e o seu conteúdo).
+            Token::symbol_t op;   //<! Operador antes do fator (`NONE` no primeiro).
+        };
+
+        /// Um termo de uma cadeia de `+` e `-`, que também é um nó da treap.
+        struct Element
+        {
+            Element * left;         //<! Termos anteriores na cadeia (subárvore esquerda).
+            Element * right;        //<! Termos posteriores na cadeia (subárvore direita).
+            std::uint32_t priority; //<! Prioridade (aleatória) do nó.
+            Token::symbol_t op;     //<! `PLUS` ou `MINUS` antes do termo (`PLUS` no primeiro).
+            std::uint32_t gap;      //<! Caracteres antes do termo (ws e o operador).
+            std::uint32_t item_len; //<! Tamanho do termo no texto.
+            char * text;            //<! Texto próprio: o `gap` e o termo, sem o conteúdo dos parênteses.
+            std::uint32_t text_len; //<! Tamanho do texto próprio.
+            std::uint32_t n_factors;//<! Quantidade de fatores do produto.
+            Factor * factors;       //<! Fatores do produto.
+            Outcome item;           //<! Valor do termo.
+            Summary summary;        //<! Resumo da subárvore.
+            std::size_t total;      //<! Tamanho do texto da subárvore.
+        };
+
+        /// Um nível: a expressão inteira ou o conteúdo de um par de parênteses.
+        struct Sum
+        {
+            Element * root;         //<! Raiz da treap dos termos.
+            const char * tail_text; //<! ws depois do último termo.
+            std::size_t tail;       //<! Tamanho de `tail_text`.
+            Outcome result;         //<! Valor do nível.
+        };
+
+        /// Nível em construção em `build()` (um por parêntese aberto).
+        struct BuildFrame
+        {
+            std::size_t elems_begin;   //<! Primeiro termo do nível em `m_elems`.
+            std::size_t factors_begin; //<! Primeiro fator do termo atual em `m_factors`.
+            std::size_t gap_begin;     //<! Início do `gap` do termo atual.
+            std::size_t item_begin;    //<! Início do termo atual (`NO_ITEM` antes do primeiro fator).
+            std::size_t paren;         //<! Coluna do "(" do nível.
+            Token::symbol_t elem_op;   //<! Operador antes do termo atual.
+            Token::symbol_t factor_op; //<! Operador antes do próximo fator.
+        };
+
+        /// Termos sendo escritos em `emit()` (um por nível).
+        struct EmitFrame
+        {
+            std::size_t begin, idx, end; //<! Termos do nível em `order_`, e o próximo a escrever.
+            const Sum * sum;             //<! Nível cujo ws final vem depois dos termos (ou `nullptr`).
+            std::uint32_t fi;            //<! Próximo fator do termo atual.
+            std::uint32_t own;           //<! Caracteres do texto próprio do termo atual já escritos.
+            std::uint32_t skipped;       //<! Conteúdo dos parênteses já escritos do termo atual.
+        };
+
+        /// Um passo da descida de `edit()`: o fator (entre parênteses) que contém a edição.
+        struct PathStep
+        {
+            Sum * sum;            //<! Nível que contém o fator.
+            std::size_t pos;      //<! Posição do termo no nível.
+            std::uint32_t factor; //<! Índice do fator no termo.
+        };
+
+        static const std::size_t NO_ITEM = static_cast< std::size_t >( -1 );
+        static const std::size_t COMPACT_FACTOR = 3;      //<! Tamanho da arena, em árvores, que dispara uma análise completa.
+        static const std::size_t COMPACT_SLACK = 1 << 20; //<! Bytes de arena tolerados além disso.
+
+        Arena m_arena;                    //<! Memória da árvore.
+        std::size_t m_allocated = 0;      //<! Bytes pedidos à arena desde a última análise completa.
+        std::size_t m_built = 0;          //<! Bytes da árvore da última análise completa.
+        Sum * m_root = nullptr;           //<! Árvore da expressão (`nullptr` se ela está mal formada).
+        std::string m_text;               //<! Texto da expressão quando não há árvore (ou ela está danificada).
+        bool m_damaged = false;           //<! A árvore é de um texto anterior, que difere de `m_text` numa região.
+        std::size_t m_damage_begin = 0;   //<! Início da região danificada.
+        std::size_t m_damage_suffix = 0;  //<! Caracteres depois da região danificada (iguais aos da árvore).
+        LineResult m_result;              //<! Resultado atual.
+        std::size_t m_rebuilds = 0;       //<! Análises completas.
+        std::uint32_t m_seed = 2463534242u; //<! Estado do gerador das prioridades.
+
+        Parser m_parser;                  //<! Parser (sem estado próprio).
+        Parser::Context m_parser_ctx;     //<! Contexto do parser, reaproveitado entre as edições.
+        std::string m_scratch;            //<! Texto do trecho analisado de novo.
+        std::vector< BuildFrame > m_frames;      //<! Níveis abertos em `build()`.
+        std::vector< Element * > m_elems;        //<! Termos construídos e ainda sem nível.
+        std::vector< Factor > m_factors;         //<! Fatores do termo em construção.
+        std::vector< Element * > m_spine;        //<! Ramo direito em `treap_from()`.
+        std::vector< value_type > m_pvalues;     //<! Pilha de operandos de `eval_product()`.
+        std::vector< Token::symbol_t > m_pops;   //<! Pilha de operadores de `eval_product()`.
+        std::vector< PathStep > m_path;          //<! Descida de `edit()`.
+        std::vector< const Element * > m_order;  //<! Termos a escrever em `emit()`.
+        std::vector< EmitFrame > m_emit;         //<! Níveis abertos em `emit()`.
+
+        /// Analisa `m_text` inteiro e reconstrói a árvore.
+        void rebuild( void );
+        /// Aplica uma edição à árvore, se o trecho editado puder ser analisado isoladamente.
+        bool update( std::size_t offset_, std::size_t removed_, std::string_view inserted_ );
+        /// Tenta trocar só o valor de um número de `e_`, quando a edição (relativa ao termo) fica dentro dele.
+        bool patch_literal( Element * e_, std::size_t a_, std::size_t removed_, std::string_view inserted_ );
+        /// Tenta analisar de novo só o termo `e_`, quando a edição (relativa ao termo) não toca nos vizinhos.
+        bool replace( Sum * sum_, Element * e_, std::size_t pos_, std::size_t a_, std::size_t removed_, std::string_view inserted_ );
+        /// Tenta analisar de novo só os termos do nível `sum_` tocados pela edição (relativa ao nível).
+        bool splice( Sum * sum_, std::size_t a_, std::size_t removed_, std::string_view inserted_, bool widen_ );
+        /// Constrói os termos dos tokens de `m_parser_ctx` (texto `text_`); os do nível de fora ficam em `m_elems`.
+        const char * build( std::string_view text_, std::size_t & tail_ );
+        /// Encerra o termo atual do nível `f_`.
+        void close_item( BuildFrame & f_, std::string_view text_, std::size_t end_ );
+        /// Cria um nível com os termos de `m_elems` a partir de `begin_`.
+        Sum * make_sum( std::size_t begin_, const char * tail_text_, std::size_t tail_ );
+        /// Monta uma treap com os termos em `[first_, last_)`, em O(n).
+        Element * treap_from( Element * const * first_, Element * const * last_ );
+        /// Valor de um produto, com as regras de precedência do `Evaluator`.
+        Outcome eval_product( const Factor * f_, std::uint32_t n_ );
+        /// Recalcula os resumos do caminho de `t_` até o termo na posição `pos_`.
+        static void refresh( Element * t_, std::size_t pos_ );
+        /// Ajusta o tamanho do fator `factor_` do termo na posição `pos_` e recalcula o caminho até `t_`.
+        void resize_factor( Element * t_, std::size_t pos_, std::uint32_t factor_, std::ptrdiff_t delta_ );
+        /// Escreve em `out_` o texto dos termos de `order_` (e o ws final de `sum_`, se não for `nullptr`).
+        static void emit( std::vector< const Element * > & order_, const Sum * sum_, std::string & out_,
+                          std::vector< EmitFrame > & frames_ );
+        /// Atualiza `m_result` a partir do nível de fora.
+        void set_result( void );
+        /// Copia `s_` para a arena.
+        const char * copy_text( std::string_view s_ );
+        /// Próxima prioridade (xorshift).
+        std::uint32_t next_priority( void );
+
+        /// Reserva `n_` objetos na arena, contando os bytes.
+        template < typename T >
+        T * allocate( std::size_t n_ )
+        {
+            m_allocated += n_ * sizeof( T );
+            return m_arena.allocate< T >( n_ );
+        }
+
+        // Treap ordenada pela posição no texto.
+        static std::size_t total( const Element * t_ ) { return t_ ? t_->total : 0; }
+        static std::size_t length( const Element * t_ ) { return t_->gap + t_->item_len; }
+        static void pull( Element * t_ );
+        static Element * merge( Element * l_, Element * r_ );
+        /// Separa os termos que terminam antes de `a_` (em `l_`) dos demais (em `r_`).
+        static void split_end_lt( Element * t_, std::size_t a_, Element *& l_, Element *& r_ );
+        /// Separa os termos que começam até `b_` (em `l_`) dos demais (em `r_`).
+        static void split_start_le( Element * t_, std::ptrdiff_t b_, Element *& l_, Element *& r_ );
+        /// Termos de `t_` em ordem.
+        static void flatten( const Element * t_, std::vector< const Element * > & out_ );
+
+        // Resumos.
+        static value_type shift( value_type x_, uvalue_type offset_ );
+        static Summary leaf( const Element & e_ );
+        static Summary compose( const Summary & s1_, const Summary & s2_ );
+        static Outcome apply( const Summary & s_ );
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "line_evaluator.h"
+#include "stats.h"
+
+/*!
+ * \brief Avalia uma linha com o modo escolhido na construção.
+ * \param line_ A expressão (sem o '\n').
+ * \return O erro de parsing, o erro de avaliação ou o valor da expressão.
+ */
+LineResult LineEvaluator::evaluate( std::string_view line_ )
+{
+    LineResult result;
+
+    if ( m_mode == FUSED )
+    {
+        StageTimer timer( Stats::FUSED );
+        auto fused = m_fused.evaluate( line_, m_fused_ctx );
+        result.parser_result = fused.parser_result;
+        result.eval_result = fused.eval_result;
+        result.value = fused.value;
+        return result;
+    }
+
+    result.parser_result = m_mode == TABLE ? m_table_parser.parse( line_, m_parser_ctx ) : m_parser.parse( line_, m_parser_ctx );
+    if ( result.parser_result.type != Parser::ParserResult::PARSER_OK )
+        return result;
+
+    if ( m_mode == COMPILED )
+    {
+        m_evaluator.compile( m_parser_ctx.token_list, m_eval_ctx, m_program );
+        StageTimer timer( Stats::EVALUATE );
+        result.eval_result = m_program.run( result.value );
+    }
+    else
+    {
+        result.eval_result = m_evaluator.evaluate( m_parser_ctx.token_list, m_eval_ctx );
+        result.value = m_eval_ctx.final_result;
+    }
+    return result;
+}
@@ -0,0 +1,65 @@
+#ifndef _LINE_EVALUATOR_H_
+#define _LINE_EVALUATOR_H_
+
+#include <string_view> // std::string_view
+
+#include "parser.h"
+#include "evaluator.h"
+#include "fused_evaluator.h"
+#include "program.h"
+#include "table_parser.h"
+
+/// Resultado completo de uma linha: erro de parsing, erro de avaliação ou o valor.
+struct LineResult
+{
+    Parser::ParserResult parser_result;     //<! Resultado do parsing.
+    Evaluator::EvaluatorResult eval_result; //<! Resultado da avaliação (só vale se o parsing foi OK).
+    Evaluator::result_t value = 0;          //<! Valor da expressão (só vale se não houve erros).
+};
+
+/*!
+ * Avalia linhas de entrada, uma de cada vez, com um dos modos do BARES.
+ *
+ * Guarda os contextos do `Parser` (ou do `TableParser`), do `Evaluator` e do
+ * `FusedEvaluator` (e o `Program` do modo compilado), que são reaproveitados
+ * de uma linha para a outra. Cada thread deve ter o seu próprio `LineEvaluator`.
+ */
+class LineEvaluator
+{
+    public:
+        /// Modos de avaliação.
+        enum mode_t
+        {
+            PIPELINE = 0, //<! Parser + Evaluator (lista de tokens e lista pósfixa).
+            FUSED,        //<! FusedEvaluator (uma única passada).
+            COMPILED,     //<! Parser + Evaluator::compile() + Program::run().
+            TABLE         //<! TableParser (tabela LL(1) gerada da gramática) + Evaluator.
+        };
+
+        /// Avalia uma linha.
+        LineResult evaluate( std::string_view line_ );
+
+        /// Modo usado por este avaliador.
+        mode_t mode( void ) const { return m_mode; }
+
+        explicit LineEvaluator( mode_t mode_ = PIPELINE )
+            : m_mode( mode_ )
+        { /* empty */ }
+        ~LineEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        LineEvaluator( const LineEvaluator & ) = delete;
+        LineEvaluator & operator=( const LineEvaluator & ) = delete;
+
+    private:
+        mode_t m_mode;                    //<! Modo de avaliação.
+        Parser m_parser;                  //<! Parser (sem estado próprio).
+        TableParser m_table_parser;       //<! Parser dirigido por tabela (sem estado próprio).
+        Evaluator m_evaluator;            //<! Evaluator (sem estado próprio).
+        FusedEvaluator m_fused;           //<! Avaliador de passada única.
+        TableParser::Context m_parser_ctx; //<! Contexto do parser (de qualquer um dos dois), reaproveitado entre as linhas.
+        Evaluator::Context m_eval_ctx;    //<! Contexto do evaluator, reaproveitado entre as linhas.
+        FusedEvaluator::Context m_fused_ctx; //<! Contexto do avaliador de passada única, reaproveitado entre as linhas.
+        Program m_program;                //<! Programa do modo compilado, reaproveitado entre as linhas.
+};
+
+#endif
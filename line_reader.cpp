@@ -0,0 +1,219 @@
+#include "line_reader.h"
+#include "stats.h"
+
+#include <cerrno>      // errno, EINTR
+#include <cstring>     // std::memchr, std::memmove
+#include <string_view> // std::string_view
+#include <fcntl.h>     // ::open
+#include <unistd.h>    // ::read, ::close, ::lseek, ::sysconf
+#include <sys/mman.h>  // ::mmap, ::munmap, ::madvise
+#include <sys/stat.h>  // ::fstat
+
+#if defined( __SSE2__ )
+#include <emmintrin.h> // _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+namespace {
+    /// Tamanho inicial do buffer de leitura para entradas que não podem ser mapeadas.
+    const std::size_t BUFFER_SIZE = 1 << 20;
+}
+
+/*!
+ * \brief Abre o arquivo indicado por `path_` ("-" é a entrada padrão).
+ * \return `false` se o arquivo não pôde ser aberto.
+ */
+bool LineReader::open( const char * path_ )
+{
+    if ( std::string_view( path_ ) == "-" )
+        return open( 0 );
+
+    int fd = ::open( path_, O_RDONLY );
+    if ( fd < 0 ) return false;
+    if ( not open( fd ) )
+    {
+        ::close( fd );
+        return false;
+    }
+    m_owns_fd = true;
+    return true;
+}
+
+/*!
+ * \brief Prepara a leitura do descritor `fd_`.
+ * Arquivos regulares são mapeados em memória a partir do offset atual do
+ * descritor (se ainda há algo depois dele); os demais são lidos em blocos.
+ * \return `false` se o descritor não é válido.
+ */
+bool LineReader::open( int fd_ )
+{
+    close();
+
+    struct stat st;
+    if ( ::fstat( fd_, &st ) != 0 ) return false;
+    m_fd = fd_;
+    m_owns_fd = false;
+    m_eof = false;
+    m_partial = false;
+
+    // Só o que ainda não foi lido do descritor: quem o passou (um `read` do
+    // shell, por exemplo) pode já ter consumido o começo do arquivo.
+    const off_t offset = S_ISREG( st.st_mode ) ? ::lseek( fd_, 0, SEEK_CUR ) : -1;
+    if ( offset >= 0 and offset < st.st_size )
+    {
+        // O mapeamento começa na página do offset.
+        const off_t base = offset - offset % ::sysconf( _SC_PAGESIZE );
+        void * map = ::mmap( nullptr, st.st_size - base, PROT_READ, MAP_PRIVATE, fd_, base );
+        if ( map != MAP_FAILED )
+        {
+            ::madvise( map, st.st_size - base, MADV_SEQUENTIAL );
+            m_map = static_cast< char * >( map );
+            m_map_size = st.st_size - base;
+            m_curr = m_map + ( offset - base );
+            m_end = m_map + m_map_size;
+            m_eof = true; // Todo o arquivo já está disponível.
+            // Como na leitura em blocos, o descritor fica no fim do que foi lido.
+            ::lseek( fd_, st.st_size, SEEK_SET );
+            return true;
+        }
+    }
+
+    // Não deu para mapear: leitura em blocos.
+    if ( m_buffer.empty() ) m_buffer.resize( BUFFER_SIZE );
+    m_curr = m_end = m_buffer.data();
+    return true;
+}
+
+/// Fecha o arquivo (se foi aberto pelo leitor) e desfaz o mapeamento.
+void LineReader::close( void )
+{
+    if ( m_map != nullptr ) ::munmap( m_map, m_map_size );
+    if ( m_owns_fd and m_fd >= 0 ) ::close( m_fd );
+    m_map = nullptr;
+    m_map_size = 0;
+    m_fd = -1;
+    m_owns_fd = false;
+    m_curr = m_end = nullptr;
+    m_eof = true;
+}
+
+/*!
+ * \brief Busca vetorizada pelo primeiro '\n'.
+ * Compara 16 bytes de cada vez com SSE2 e usa a máscara da comparação para
+ * achar a posição exata; o final (menos de 16 bytes) usa `memchr()`.
+ */
+const char * LineReader::find_newline( const char * first_, const char * last_ )
+{
+#if defined( __SSE2__ )
+    const __m128i newline = _mm_set1_epi8( '\n' );
+    while ( last_ - first_ >= 16 )
+    {
+        __m128i block = _mm_loadu_si128( reinterpret_cast< const __m128i * >( first_ ) );
+        int mask = _mm_movemask_epi8( _mm_cmpeq_epi8( block, newline ) );
+        if ( mask != 0 )
+            return first_ + __builtin_ctz( mask );
+        first_ += 16;
+    }
+#endif
+    auto pos = static_cast< const char * >( std::memchr( first_, '\n', last_ - first_ ) );
+    return pos != nullptr ? pos : last_;
+}
+
+/*!
+ * \brief Move a linha incompleta para o início do buffer e lê mais dados do descritor.
+ * Se a linha incompleta ocupa o buffer inteiro, o buffer dobra de tamanho.
+ * \return `false` se não havia mais nada para ler.
+ */
+bool LineReader::refill( void )
+{
+    if ( m_eof ) return false;
+
+    std::size_t pending = m_end - m_curr;
+    if ( pending == m_buffer.size() )
+        m_buffer.resize( 2 * m_buffer.size() );
+    else if ( pending > 0 and m_curr != m_buffer.data() )
+        std::memmove( m_buffer.data(), m_curr, pending );
+    m_curr = m_buffer.data();
+    m_end = m_curr + pending;
+
+    ssize_t n;
+    do n = ::read( m_fd, m_buffer.data() + pending, m_buffer.size() - pending );
+    while ( n < 0 and errno == EINTR );
+
+    if ( n <= 0 )
+    {
+        m_eof = true;
+        return false;
+    }
+    m_end += n;
+    return true;
+}
+
+/*!
+ * \brief Lê a próxima linha.
+ * \param line_ Recebe a linha, sem o '\n'.
+ * \return `false` no fim da entrada. Uma última linha sem '\n' também é entregue.
+ */
+bool LineReader::next( std::string_view & line_ )
+{
+    StageTimer timer( Stats::READ );
+    if ( m_curr == nullptr ) return false;
+
+    const char * scanned = m_curr; // Até aqui já sabemos que não existe '\n'.
+    for ( ;; )
+    {
+        const char * nl = find_newline( scanned, m_end );
+        if ( nl != m_end )
+        {
+            line_ = std::string_view( m_curr, nl - m_curr );
+            m_curr = nl + 1;
+            return true;
+        }
+        // Sem '\n' nos dados disponíveis: lemos mais (se possível).
+        std::size_t offset = m_end - m_curr;
+        if ( not refill() ) break;
+        scanned = m_curr + offset;
+    }
+
+    // Fim da entrada: o que sobrou (se sobrou) é a última linha.
+    if ( m_curr == m_end ) return false;
+    line_ = std::string_view( m_curr, m_end - m_curr );
+    m_curr = m_end;
+    return true;
+}
+
+/*!
+ * \brief Lê o próximo pedaço da linha atual.
+ * O pedaço vai até o próximo '\n' (exclusive) ou até o fim dos dados
+ * disponíveis; no segundo caso `eol_` é `false`, e a próxima chamada continua
+ * a mesma linha. Os pedaços já entregues são descartados do buffer, que
+ * portanto nunca cresce: a memória usada não depende do tamanho da linha.
+ * Uma entrada mapeada já está inteira em memória, então cada pedaço é uma
+ * linha completa.
+ *
+ * \param piece_ Recebe o pedaço (sem o '\n'); só vale até a próxima chamada.
+ * \param eol_ Recebe `true` se o pedaço termina a linha.
+ * \return `false` no fim da entrada. As linhas são as mesmas de `next()`.
+ */
+bool LineReader::next_piece( std::string_view & piece_, bool & eol_ )
+{
+    StageTimer timer( Stats::READ );
+    if ( m_curr == nullptr ) return false;
+
+    // Tudo o que estava no buffer já foi entregue: `refill()` não tem o que preservar.
+    if ( m_curr == m_end and not refill() )
+    {
+        // Fim da entrada: se a última linha não tinha '\n', ela termina aqui.
+        if ( not m_partial ) return false;
+        piece_ = std::string_view();
+        eol_ = true;
+        m_partial = false;
+        return true;
+    }
+
+    const char * nl = find_newline( m_curr, m_end );
+    piece_ = std::string_view( m_curr, nl - m_curr );
+    eol_ = nl != m_end;
+    m_curr = eol_ ? nl + 1 : nl;
+    m_partial = not eol_;
+    return true;
+}
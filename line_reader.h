@@ -0,0 +1,71 @@
+#ifndef _LINE_READER_H_
+#define _LINE_READER_H_
+
+#include <cstddef>     // std::size_t
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+/*!
+ * Leitor de linhas de um arquivo (ou da entrada padrão), sem iostreams.
+ *
+ * Se o descritor aponta para um arquivo regular, o resto do arquivo (do
+ * offset atual do descritor até o fim) é mapeado em memória (`mmap`) e cada
+ * linha é entregue como um `std::string_view` direto para o mapeamento:
+ * nenhuma linha é copiada e nada é alocado por linha. Nesse caso as linhas
+ * continuam válidas até o leitor ser fechado.
+ *
+ * Para pipes, terminais e outros descritores que não podem ser mapeados, a
+ * entrada é lida em blocos grandes com `read()`. As linhas apontam para o
+ * buffer interno e só valem até a próxima chamada de `next()`.
+ *
+ * Os fins de linha são encontrados com uma busca vetorizada por '\n' (SSE2).
+ * As linhas são separadas exatamente como por `std::getline()`.
+ *
+ * Linhas muito longas também podem ser lidas em pedaços (`next_piece()`):
+ * assim o buffer não cresce até o tamanho da linha. Uma mesma entrada deve
+ * ser lida só com `next()` ou só com `next_piece()`.
+ */
+class LineReader
+{
+    public:
+        /// Abre o arquivo indicado ("-" é a entrada padrão).
+        bool open( const char * path_ );
+        /// Usa um descritor já aberto (que não é fechado pelo leitor).
+        bool open( int fd_ );
+        /// Fecha o arquivo e desfaz o mapeamento.
+        void close( void );
+
+        /// Lê a próxima linha (sem o '\n'). Retorna `false` no fim da entrada.
+        bool next( std::string_view & line_ );
+        /// Lê o próximo pedaço da linha atual, sem juntar a linha em memória; `eol_` indica se a linha terminou.
+        bool next_piece( std::string_view & piece_, bool & eol_ );
+
+        /// As linhas continuam válidas depois das próximas chamadas de `next()`? (entrada mapeada)
+        bool stable( void ) const { return m_map != nullptr; }
+
+        /// Encontra o primeiro '\n' em `[first_, last_)`; retorna `last_` se não houver.
+        static const char * find_newline( const char * first_, const char * last_ );
+
+        LineReader() = default;
+        ~LineReader() { close(); }
+        /// Desligar cópia e atribuição.
+        LineReader( const LineReader & ) = delete;
+        LineReader & operator=( const LineReader & ) = delete;
+
+    private:
+        int m_fd = -1;                 //<! Descritor do arquivo.
+        bool m_owns_fd = false;        //<! O descritor deve ser fechado pelo leitor?
+        char * m_map = nullptr;        //<! Início do mapeamento (se o arquivo foi mapeado).
+        std::size_t m_map_size = 0;    //<! Tamanho do mapeamento.
+
+        std::vector< char > m_buffer;  //<! Buffer de leitura (se o arquivo não foi mapeado).
+        const char * m_curr = nullptr; //<! Início da próxima linha.
+        const char * m_end = nullptr;  //<! Fim dos dados disponíveis.
+        bool m_eof = false;            //<! Já lemos tudo do descritor?
+        bool m_partial = false;        //<! A linha do último pedaço entregue ainda não terminou?
+
+        /// Lê mais dados para o buffer, preservando a linha incompleta. Retorna `false` se não havia mais nada.
+        bool refill( void );
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef _LL1_H_
+#define _LL1_H_
+
+#include <algorithm>   // std::copy_n
+#include <array>       // std::array
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint8_t, std::uint64_t
+#include <iterator>    // std::size()
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+/*!
+ * Gerador de parsers LL(1) dirigidos por tabela.
+ *
+ * A gramática é descrita por uma classe (veja `TableGrammar`, em
+ * table_parser.h) com:
+ *  - `N_TERMINALS`, `N_NONTERMINALS`, `START`, `END` e `OTHER`: quantidades,
+ *    o não-terminal inicial, o terminal do fim da entrada (que não tem
+ *    caracteres) e o de qualquer caractere que nenhum outro terminal aceita;
+ *  - `lexemes[ N_TERMINALS ]`: os caracteres de cada terminal;
+ *  - `productions[]`: as produções (`LL1Production`), cujo lado direito
+ *    mistura terminais, não-terminais e ações semânticas.
+ *
+ * `LL1Table< Grammar >` calcula, em tempo de compilação, a classe de cada
+ * caractere, os conjuntos FIRST e FOLLOW e a tabela de predição
+ * (não-terminal x terminal -> produção); se duas produções disputam uma
+ * célula, a gramática não é LL(1) e o programa não compila. Células vazias
+ * de não-terminais anuláveis recebem a produção vazia (*default
+ * reduction*): o erro é detectado um pouco depois, no primeiro símbolo que
+ * não pode ser aceito, sem consumir nenhum caractere a mais.
+ *
+ * `LL1Table::run()` é o laço do parser: uma pilha de símbolos, a classe do
+ * caractere atual numa tabela de 256 posições e, para cada não-terminal no
+ * topo, a produção escolhida pela tabela. Estender a linguagem (um operador,
+ * um tipo de escopo) é editar a descrição da gramática, não o laço.
+ */
+
+/// Símbolo do lado direito de uma produção.
+struct LL1Symbol
+{
+    enum kind_t : std::uint8_t
+    {
+        NONE = 0,    //<! Posição vazia (fim do lado direito).
+        TERMINAL,    //<! Classe de caracteres.
+        NONTERMINAL, //<! Não-terminal da gramática.
+        ACTION       //<! Ação semântica (não consome nada).
+    };
+
+    kind_t kind = NONE; //<! Tipo do símbolo.
+    std::uint8_t id = 0; //<! Número do terminal, do não-terminal ou da ação.
+
+    constexpr bool operator==( const LL1Symbol & ) const = default;
+};
+
+/// Terminal `id_`.
+constexpr LL1Symbol ll1_t( unsigned id_ ) { return LL1Symbol{ LL1Symbol::TERMINAL, static_cast< std::uint8_t >( id_ ) }; }
+/// Não-terminal `id_`.
+constexpr LL1Symbol ll1_n( unsigned id_ ) { return LL1Symbol{ LL1Symbol::NONTERMINAL, static_cast< std::uint8_t >( id_ ) }; }
+/// Ação semântica `id_`.
+constexpr LL1Symbol ll1_a( unsigned id_ ) { return LL1Symbol{ LL1Symbol::ACTION, static_cast< std::uint8_t >( id_ ) }; }
+
+/// Uma produção: `lhs := rhs[0] rhs[1] ...` (até o primeiro `NONE`; nenhum símbolo é a produção vazia).
+struct LL1Production
+{
+    static const std::size_t MAX_RHS = 8; //<! Símbolos do maior lado direito.
+
+    std::uint8_t lhs;                          //<! Não-terminal do lado esquerdo.
+    std::array< LL1Symbol, MAX_RHS > rhs = {}; //<! Lado direito.
+};
+
+/// Não-terminais anuláveis e conjuntos FIRST e FOLLOW (máscaras de terminais) de uma gramática.
+template < std::size_t N_NONTERMINALS >
+struct LL1Sets
+{
+    std::array< bool, N_NONTERMINALS > nullable{};
+    std::array< std::uint64_t, N_NONTERMINALS > first{};
+    std::array< std::uint64_t, N_NONTERMINALS > follow{};
+};
+
+/// Acrescenta a `first_` o FIRST de `rhs_[ from_ ... ]`; retorna se a sequência é anulável.
+template < std::size_t N >
+constexpr bool ll1_first( const LL1Sets< N > & s_, const std::array< LL1Symbol, LL1Production::MAX_RHS > & rhs_,
+        std::size_t from_, std::uint64_t & first_ )
+{
+    for ( std::size_t i( from_ ); i < rhs_.size() and rhs_[ i ].kind != LL1Symbol::NONE; ++i )
+    {
+        const auto sym = rhs_[ i ];
+        if ( sym.kind == LL1Symbol::TERMINAL )
+        {
+            first_ |= std::uint64_t( 1 ) << sym.id;
+            return false;
+        }
+        if ( sym.kind == LL1Symbol::NONTERMINAL )
+        {
+            first_ |= s_.first[ sym.id ];
+            if ( not s_.nullable[ sym.id ] ) return false;
+        }
+    }
+    return true;
+}
+
+/// Calcula (até o ponto fixo) os anuláveis e os conjuntos FIRST e FOLLOW de `Grammar`.
+template < typename Grammar >
+constexpr LL1Sets< Grammar::N_NONTERMINALS > ll1_sets( void )
+{
+    LL1Sets< Grammar::N_NONTERMINALS > s;
+    s.follow[ Grammar::START ] = std::uint64_t( 1 ) << Grammar::END;
+    for ( bool changed = true; changed; )
+    {
+        changed = false;
+        for ( const auto & p : Grammar::productions )
+        {
+            std::uint64_t first = s.first[ p.lhs ];
+            const bool nullable = ll1_first( s, p.rhs, 0, first ) or s.nullable[ p.lhs ];
+            changed = changed or first != s.first[ p.lhs ] or nullable != s.nullable[ p.lhs ];
+            s.first[ p.lhs ] = first;
+            s.nullable[ p.lhs ] = nullable;
+
+            for ( std::size_t i( 0 ); i < p.rhs.size() and p.rhs[ i ].kind != LL1Symbol::NONE; ++i )
+            {
+                if ( p.rhs[ i ].kind != LL1Symbol::NONTERMINAL ) continue;
+                std::uint64_t follow = s.follow[ p.rhs[ i ].id ];
+                if ( ll1_first( s, p.rhs, i + 1, follow ) ) follow |= s.follow[ p.lhs ];
+                changed = changed or follow != s.follow[ p.rhs[ i ].id ];
+                s.follow[ p.rhs[ i ].id ] = follow;
+            }
+        }
+    }
+    return s;
+}
+
+/*!
+ * Tabelas LL(1) de uma gramática, calculadas em tempo de compilação, e o laço do parser.
+ * \tparam Grammar Descrição da gramática (veja o início do arquivo).
+ */
+template < typename Grammar >
+class LL1Table
+{
+    public:
+        static constexpr std::size_t N_TERMINALS = Grammar::N_TERMINALS;
+        static constexpr std::size_t N_NONTERMINALS = Grammar::N_NONTERMINALS;
+        static constexpr std::size_t N_PRODUCTIONS = std::size( Grammar::productions );
+        static constexpr std::uint8_t NO_PRODUCTION = 0xff; //<! Célula vazia (erro).
+
+        static_assert( N_TERMINALS <= 64, "Os conjuntos de terminais são máscaras de 64 bits." );
+        static_assert( N_PRODUCTIONS < NO_PRODUCTION, "As produções são numeradas com 8 bits." );
+
+        /// Terminal de cada caractere.
+        static constexpr std::array< std::uint8_t, 256 > classes = []
+        {
+            std::array< std::uint8_t, 256 > cls{};
+            cls.fill( Grammar::OTHER );
+            for ( std::size_t t( 0 ); t < N_TERMINALS; ++t )
+                for ( char c : Grammar::lexemes[ t ] ) cls[ static_cast< unsigned char >( c ) ] = static_cast< std::uint8_t >( t );
+            return cls;
+        }();
+
+        /// Não-terminais anuláveis e conjuntos FIRST e FOLLOW.
+        static constexpr LL1Sets< N_NONTERMINALS > sets = ll1_sets< Grammar >();
+
+        /// Tabela de predição e se houve conflito.
+        struct Table
+        {
+            std::array< std::array< std::uint8_t, N_TERMINALS >, N_NONTERMINALS > predict{}; //<! Produção de cada (não-terminal, terminal).
+            bool conflict = false; //<! Alguma célula foi disputada por duas produções?
+        };
+
+        /// A tabela de predição (com as produções vazias nas células vazias dos não-terminais anuláveis).
+        static constexpr Table table = []
+        {
+            Table tb;
+            for ( auto & row : tb.predict ) row.fill( NO_PRODUCTION );
+            for ( std::size_t p( 0 ); p < N_PRODUCTIONS; ++p )
+            {
+                const auto & prod = Grammar::productions[ p ];
+                std::uint64_t lookahead = 0;
+                if ( ll1_first( sets, prod.rhs, 0, lookahead ) ) lookahead |= sets.follow[ prod.lhs ];
+                for ( std::size_t t( 0 ); t < N_TERMINALS; ++t )
+                {
+                    if ( not ( lookahead >> t & 1 ) ) continue;
+                    auto & cell = tb.predict[ prod.lhs ][ t ];
+                    tb.conflict = tb.conflict or ( cell != NO_PRODUCTION and cell != p );
+                    cell = static_cast< std::uint8_t >( p );
+                }
+            }
+            for ( std::size_t p( 0 ); p < N_PRODUCTIONS; ++p )
+            {
+                const auto & prod = Grammar::productions[ p ];
+                std::uint64_t ignored = 0;
+                if ( not ll1_first( sets, prod.rhs, 0, ignored ) ) continue;
+                for ( auto & cell : tb.predict[ prod.lhs ] )
+                    if ( cell == NO_PRODUCTION ) cell = static_cast< std::uint8_t >( p );
+            }
+            return tb;
+        }();
+
+        static_assert( not table.conflict, "A gramática não é LL(1): duas produções disputam uma célula da tabela." );
+
+        /// Lado direito de cada produção, invertido (na ordem em que vai para a pilha), e o seu tamanho.
+        struct Reversed
+        {
+            std::array< std::array< LL1Symbol, LL1Production::MAX_RHS >, N_PRODUCTIONS > rhs{};
+            std::array< std::uint8_t, N_PRODUCTIONS > size{};
+        };
+        static constexpr Reversed reversed = []
+        {
+            Reversed r;
+            for ( std::size_t p( 0 ); p < N_PRODUCTIONS; ++p )
+            {
+                const auto & rhs = Grammar::productions[ p ].rhs;
+                std::size_t n = 0;
+                while ( n < rhs.size() and rhs[ n ].kind != LL1Symbol::NONE ) ++n;
+                for ( std::size_t i( 0 ); i < n; ++i ) r.rhs[ p ][ i ] = rhs[ n - 1 - i ];
+                r.size[ p ] = static_cast< std::uint8_t >( n );
+            }
+            return r;
+        }();
+
+        /*!
+         * \brief Reconhece `in_` a partir de `Grammar::START`.
+         * A cada passo o topo da pilha é desempilhado: um terminal precisa ser a
+         * classe do caractere atual (que então é consumido); um não-terminal é
+         * trocado pela produção da tabela; uma ação chama `actions_( id, pos )`,
+         * que retorna `false` para interromper o parsing.
+         * \param in_ A entrada.
+         * \param stack_ Memória da pilha de símbolos (reaproveitada entre as chamadas).
+         * \param actions_ Executa as ações semânticas.
+         * \param pos_ Recebe a posição em que o parsing parou.
+         * \return O símbolo que não pôde ser aceito em `pos_` (um terminal ou um
+         *         não-terminal sem produção para o caractere), a ação que falhou,
+         *         ou um símbolo `NONE` se a entrada foi aceita.
+         */
+        template < typename Actions >
+        static LL1Symbol run( std::string_view in_, std::vector< LL1Symbol > & stack_, Actions & actions_, std::size_t & pos_ )
+        {
+            const std::size_t n = in_.size();
+            std::size_t pos = 0;
+            auto classify = [&]( std::size_t i_ ) -> std::uint8_t
+            {
+                return i_ < n ? classes[ static_cast< unsigned char >( in_[ i_ ] ) ] : static_cast< std::uint8_t >( Grammar::END );
+            };
+            std::uint8_t t = classify( 0 );
+
+            // A pilha é um vetor acessado por índice, sempre com espaço para mais um lado
+            // direito inteiro: cada produção é copiada com tamanho fixo (`MAX_RHS`), e
+            // o topo só avança o tamanho dela.
+            if ( stack_.size() < 4 * LL1Production::MAX_RHS ) stack_.resize( 4 * LL1Production::MAX_RHS );
+            std::size_t top = 0;
+            stack_[ top++ ] = ll1_n( Grammar::START );
+            while ( top > 0 )
+            {
+                const LL1Symbol sym = stack_[ --top ];
+                if ( sym.kind == LL1Symbol::NONTERMINAL )
+                {
+                    const std::uint8_t p = table.predict[ sym.id ][ t ];
+                    if ( p == NO_PRODUCTION ) { pos_ = pos; return sym; }
+                    if ( top + LL1Production::MAX_RHS > stack_.size() ) stack_.resize( 2 * stack_.size() );
+                    std::copy_n( reversed.rhs[ p ].begin(), LL1Production::MAX_RHS, stack_.begin() + top );
+                    top += reversed.size[ p ];
+                }
+                else if ( sym.kind == LL1Symbol::TERMINAL )
+                {
+                    if ( sym.id != t ) { pos_ = pos; return sym; }
+                    if ( t == Grammar::END ) break;
+                    t = classify( ++pos );
+                }
+                else if ( not actions_( sym.id, pos ) )
+                {
+                    pos_ = pos;
+                    return sym;
+                }
+            }
+            pos_ = pos;
+            return LL1Symbol{};
+        }
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef _NUMERIC_POLICY_H_
+#define _NUMERIC_POLICY_H_
+
+#include <cstdint> // std::int16_t, std::int32_t, std::int64_t
+
+/// Inteiro de 128 bits (extensão do GCC/Clang; `std::numeric_limits` e `std::to_chars` não o conhecem em modo estrito).
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+
+/*!
+ * Política numérica do BARES: a largura dos operandos e dos resultados, e a
+ * aritmética verificada nessa largura.
+ *
+ * O `Parser` e o `Evaluator` são templates sobre a política (`BasicParser`,
+ * `BasicEvaluator`), então os limites de cada variante são constantes de
+ * compilação e as contas são feitas na largura da própria variante, sem
+ * nenhum teste de largura em tempo de execução.
+ *
+ * Todas as operações detectam o *overflow* no momento em que ele acontece
+ * (com `__builtin_*_overflow`, que viram a instrução de soma ou multiplicação
+ * seguida de um desvio pela *flag* de overflow), em vez de calcular em um tipo
+ * mais largo e comparar com os limites depois. Um resultado intermediário,
+ * portanto, sempre cabe em `value_type`.
+ *
+ * Semântica das operações (operandos e resultado em `value_type`):
+ *  - `/` trunca em direção ao zero e `%` tem o sinal do dividendo, como em C++;
+ *    o divisor zero é tratado por quem chama (erro de divisão por zero);
+ *  - `min / -1` não cabe no tipo (overflow) e `min % -1` é 0;
+ *  - `^` com expoente negativo é 0, a menos que a base seja 1 ou -1 (a parte
+ *    fracionária é truncada); `0 ^ -n` seria infinito, então é overflow;
+ *    `x ^ 0` é 1 (inclusive `0 ^ 0`).
+ *
+ * \tparam Value Tipo (inteiro com sinal) dos operandos e dos resultados.
+ */
+template < typename Value >
+struct NumericPolicy
+{
+    typedef Value value_type; //<! Operandos e resultados.
+    typedef Value result_t;   //<! Resultados intermediários e final (na mesma largura dos operandos).
+
+    static constexpr int bits = 8 * sizeof( value_type ); //<! Largura do tipo, com o bit de sinal.
+    static constexpr value_type max = static_cast< value_type >( ( static_cast< uint128_t >( 1 ) << ( bits - 1 ) ) - 1 );
+    static constexpr value_type min = -max - 1;
+
+    /*!
+     * Acumula o dígito `digit_` no valor **negado** `value_` (`value_ * 10 - digit_`).
+     * O valor é acumulado negado porque o intervalo negativo é maior que o positivo.
+     * \return `false` (e `value_` não muda) se o novo valor sair dos limites.
+     */
+    static constexpr bool push_digit( value_type & value_, int digit_ )
+    {
+        constexpr value_type limit = min / 10;         // Maior valor negado que ainda aceita qualquer dígito...
+        constexpr int last_digit = -( min % 10 );      // ... ou, se for igual a `limit`, os dígitos até este.
+        if ( value_ < limit or ( value_ == limit and digit_ > last_digit ) )
+            return false;
+        value_ = value_ * 10 - digit_;
+        return true;
+    }
+
+    /// Troca o sinal de um valor acumulado por `push_digit()`; retorna `false` se o valor positivo não cabe.
+    static constexpr bool negate( value_type & value_ )
+    {
+        if ( value_ < -max ) return false;
+        value_ = -value_;
+        return true;
+    }
+
+    // Aritmética verificada: cada função retorna `false` (overflow) se o resultado não cabe em `value_type`.
+
+    /// `a_ + b_`.
+    static constexpr bool add( value_type a_, value_type b_, value_type & r_ )
+    {
+        return not __builtin_add_overflow( a_, b_, &r_ );
+    }
+
+    /// `a_ - b_`.
+    static constexpr bool sub( value_type a_, value_type b_, value_type & r_ )
+    {
+        return not __builtin_sub_overflow( a_, b_, &r_ );
+    }
+
+    /// `a_ * b_`.
+    static constexpr bool mul( value_type a_, value_type b_, value_type & r_ )
+    {
+        return not __builtin_mul_overflow( a_, b_, &r_ );
+    }
+
+    /// `a_ / b_`, com `b_` diferente de zero.
+    static constexpr bool div( value_type a_, value_type b_, value_type & r_ )
+    {
+        if ( a_ == min and b_ == -1 ) return false;
+        r_ = a_ / b_;
+        return true;
+    }
+
+    /// `a_ % b_`, com `b_` diferente de zero (nunca transborda).
+    static constexpr bool mod( value_type a_, value_type b_, value_type & r_ )
+    {
+        r_ = b_ == -1 ? 0 : a_ % b_; // `min % -1` é indefinido em C++ (a divisão transborda).
+        return true;
+    }
+
+    /*!
+     * `base_ ^ exp_`, por quadrados sucessivos.
+     * Com `|base_| >= 2`, qualquer expoente maior que `bits - 1` já transborda,
+     * então o laço faz no máximo log2( `bits` ) iterações, e para assim que
+     * uma multiplicação transborda.
+     */
+    static constexpr bool power( value_type base_, value_type exp_, value_type & r_ )
+    {
+        if ( exp_ <= 0 or base_ == 0 or base_ == 1 or base_ == -1 )
+        {
+            if ( exp_ == 0 or base_ == 1 ) r_ = 1;
+            else if ( base_ == -1 ) r_ = ( exp_ & 1 ) ? -1 : 1;
+            else if ( base_ == 0 ) { if ( exp_ < 0 ) return false; r_ = 0; }
+            else r_ = 0; // Expoente negativo: |1 / base_^n| < 1.
+            return true;
+        }
+        if ( exp_ > bits - 1 ) return false;
+
+        value_type result = 1;
+        for ( ;; )
+        {
+            if ( ( exp_ & 1 ) and __builtin_mul_overflow( result, base_, &result ) ) return false;
+            exp_ >>= 1;
+            if ( exp_ == 0 ) break;
+            // Ainda falta um bit do expoente, então o quadrado da base será usado.
+            if ( __builtin_mul_overflow( base_, base_, &base_ ) ) return false;
+        }
+        r_ = result;
+        return true;
+    }
+};
+
+typedef NumericPolicy< std::int16_t > Int16Policy; //<! O comportamento original do BARES.
+typedef NumericPolicy< std::int32_t > Int32Policy;
+typedef NumericPolicy< std::int64_t > Int64Policy;
+typedef NumericPolicy< int128_t > Int128Policy;
+
+/*!
+ * Política usada pelo programa (`Token`, `Parser`, `Evaluator` e os demais
+ * avaliadores), escolhida na compilação com `-DBARES_INT_BITS=16|32|64|128`.
+ * O padrão é 16 bits.
+ */
+#if not defined( BARES_INT_BITS ) or BARES_INT_BITS == 16
+typedef Int16Policy Numeric;
+#elif BARES_INT_BITS == 32
+typedef Int32Policy Numeric;
+#elif BARES_INT_BITS == 64
+typedef Int64Policy Numeric;
+#elif BARES_INT_BITS == 128
+typedef Int128Policy Numeric;
+#else
+#error "BARES_INT_BITS deve ser 16, 32, 64 ou 128."
+#endif
+
+#endif
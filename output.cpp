@@ -0,0 +1,173 @@
+#include "output.h"
+#include "stats.h"
+
+#include <cerrno>   // errno, EINTR
+#include <charconv> // std::to_chars
+#include <cstring>  // std::memcpy
+#include <iterator> // std::size
+#include <unistd.h> // ::write
+
+namespace {
+    /// Tamanho do buffer de saída.
+    const std::size_t BUFFER_SIZE = 1 << 18;
+
+    /*! Mensagem pré-formatada: a coluna (se houver) vai entre `prefix` e `suffix`. */
+    struct Template
+    {
+        std::string_view prefix;
+        std::string_view suffix;
+    };
+
+    /// Mensagens dos erros de parsing, na ordem de `Parser::ParserResult::code_t`.
+    const Template PARSER_MSG[] =
+    {
+        { "", "" }, // PARSER_OK
+        { "Unexpected end of input at column (", ")!\n" },
+        { "Ill formed integer at column (", ")!\n" },
+        { "Missing <term> at column (", ")!\n" },
+        { "Extraneous symbol after valid expression found at column (", ")!\n" },
+        { "Missing closing \")\" at column (", ")!\n" },
+        { "Integer constant out of range beginning at column (", ")!\n" },
+    };
+
+    const std::string_view DIVISION_BY_ZERO_MSG = "Division by zero!\n";
+    const std::string_view OVERFLOW_MSG = "Numeric overflow error!\n";
+    const std::string_view UNHANDLED_MSG = "Unhandled error found!\n";
+
+    /// Copia `text_` para `first_` e retorna o fim da cópia.
+    inline char * copy( char * first_, std::string_view text_ )
+    {
+        std::memcpy( first_, text_.data(), text_.size() );
+        return first_ + text_.size();
+    }
+
+    /// Escreve um valor inteiro e retorna o fim da escrita.
+    template < typename T >
+    inline char * format_value( char * first_, T value_ )
+    {
+        if constexpr ( sizeof( T ) <= sizeof( long long ) )
+            return std::to_chars( first_, first_ + 40, value_ ).ptr;
+        else
+        {
+            // `std::to_chars()` não aceita inteiros de 128 bits em modo estrito.
+            if ( value_ < 0 ) *first_++ = '-';
+            uint128_t u = value_ < 0 ? -static_cast< uint128_t >( value_ ) : static_cast< uint128_t >( value_ );
+            char digits[ 40 ];
+            char * d = digits + sizeof( digits );
+            do { *--d = static_cast< char >( '0' + u % 10 ); u /= 10; } while ( u != 0 );
+            return copy( first_, std::string_view( d, digits + sizeof( digits ) - d ) );
+        }
+    }
+}
+
+/*!
+ * \brief Formata a linha de saída de um resultado.
+ *
+ * As mensagens de erro são copiadas de modelos prontos; só a coluna (no caso
+ * de um erro de parsing) e o valor são convertidos, com `std::to_chars()`.
+ */
+char * format_result( char * first_, const LineResult & result_ )
+{
+    const auto code = result_.parser_result.type;
+    if ( code != Parser::ParserResult::PARSER_OK )
+    {
+        if ( static_cast< std::size_t >( code ) >= std::size( PARSER_MSG ) )
+            return copy( first_, UNHANDLED_MSG );
+        first_ = copy( first_, PARSER_MSG[ code ].prefix );
+        first_ = std::to_chars( first_, first_ + 20, result_.parser_result.at_col ).ptr;
+        return copy( first_, PARSER_MSG[ code ].suffix );
+    }
+
+    switch ( result_.eval_result.type )
+    {
+        case Evaluator::EvaluatorResult::EVALUATOR_OK:
+            first_ = format_value( first_, result_.value );
+            *first_++ = '\n';
+            return first_;
+        case Evaluator::EvaluatorResult::DIVISION_BY_ZERO:
+            return copy( first_, DIVISION_BY_ZERO_MSG );
+        case Evaluator::EvaluatorResult::RESULT_OVERFLOW:
+            return copy( first_, OVERFLOW_MSG );
+        default:
+            return copy( first_, UNHANDLED_MSG );
+    }
+}
+
+/// Acrescenta a linha de saída de `result_` ao fim de `out_`.
+void append_result( std::string & out_, const LineResult & result_ )
+{
+    StageTimer timer( Stats::OUTPUT );
+    char line[ MAX_RESULT_LENGTH ];
+    out_.append( line, format_result( line, result_ ) );
+}
+
+/*!
+ * \param fd_ Descritor da saída (por exemplo, `STDOUT_FILENO`).
+ * \param mode_ Quando o buffer deve ser escrito no descritor.
+ */
+ResultWriter::ResultWriter( int fd_, flush_t mode_ )
+    : m_fd( fd_ )
+    , m_mode( mode_ )
+    , m_buffer( BUFFER_SIZE )
+{ /* empty */ }
+
+/// Formata o resultado direto no buffer (esvaziando o buffer antes, se não houver espaço).
+void ResultWriter::put( const LineResult & result_ )
+{
+    StageTimer timer( Stats::OUTPUT );
+    if ( m_buffer.size() - m_size < MAX_RESULT_LENGTH )
+        flush();
+    m_size = format_result( m_buffer.data() + m_size, result_ ) - m_buffer.data();
+    if ( m_mode == LINE )
+        flush();
+}
+
+/*!
+ * \brief Acrescenta texto já formatado ao buffer.
+ * Um texto maior que o espaço livre esvazia o buffer; um texto maior que o
+ * buffer inteiro é escrito direto no descritor, sem cópia.
+ */
+void ResultWriter::write( std::string_view text_ )
+{
+    if ( m_buffer.size() - m_size < text_.size() )
+    {
+        flush();
+        if ( text_.size() >= m_buffer.size() )
+        {
+            m_good = write_all( text_.data(), text_.size() ) and m_good;
+            return;
+        }
+    }
+    std::memcpy( m_buffer.data() + m_size, text_.data(), text_.size() );
+    m_size += text_.size();
+    if ( m_mode == LINE )
+        flush();
+}
+
+/// Escreve o buffer no descritor e o esvazia.
+bool ResultWriter::flush( void )
+{
+    if ( m_size > 0 )
+    {
+        m_good = write_all( m_buffer.data(), m_size ) and m_good;
+        m_size = 0;
+    }
+    return m_good;
+}
+
+/// Escreve tudo, repetindo `write()` enquanto a escrita for parcial ou interrompida.
+bool ResultWriter::write_all( const char * data_, std::size_t size_ )
+{
+    while ( size_ > 0 )
+    {
+        ssize_t n = ::write( m_fd, data_, size_ );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            return false;
+        }
+        data_ += n;
+        size_ -= n;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <cstddef>     // std::size_t
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include "parser.h"         // Parser::ParserResult
+#include "evaluator.h"      // Evaluator::EvaluatorResult
+#include "line_evaluator.h" // LineResult
+
+/// Maior tamanho possível de uma linha de saída (mensagem mais longa + coluna de 20 dígitos).
+const std::size_t MAX_RESULT_LENGTH = 128;
+
+/*!
+ * \brief Escreve a linha de saída de `result_` (mensagem de erro ou valor, com '\n') a partir de `first_`.
+ * Deve haver espaço para pelo menos `MAX_RESULT_LENGTH` caracteres.
+ * \return O fim do que foi escrito.
+ */
+char * format_result( char * first_, const LineResult & result_ );
+/// Acrescenta a linha de saída de `result_` ao fim de `out_`.
+void append_result( std::string & out_, const LineResult & result_ );
+
+/*!
+ * Escritor da saída, sem iostreams.
+ *
+ * Os resultados são formatados direto em um buffer grande, reaproveitado
+ * durante toda a execução, e o buffer é escrito no descritor com `write()`.
+ *
+ * No modo `THROUGHPUT` o buffer só é escrito quando enche (ou em `flush()`),
+ * o que minimiza as chamadas ao sistema. No modo `LINE` cada linha é escrita
+ * assim que fica pronta, para que um usuário (ou programa) do outro lado de um
+ * pipe interativo veja cada resultado sem esperar pelos próximos.
+ */
+class ResultWriter
+{
+    public:
+        /// Quando o buffer é escrito no descritor.
+        enum flush_t
+        {
+            THROUGHPUT, //<! Só quando o buffer enche.
+            LINE        //<! Ao fim de cada linha.
+        };
+
+        /// Escreve em `fd_` (que não é fechado pelo escritor).
+        explicit ResultWriter( int fd_, flush_t mode_ = THROUGHPUT );
+        /// Escreve o que restou no buffer.
+        ~ResultWriter() { flush(); }
+        /// Desligar cópia e atribuição.
+        ResultWriter( const ResultWriter & ) = delete;
+        ResultWriter & operator=( const ResultWriter & ) = delete;
+
+        /// Escreve o resultado de uma linha: a mensagem de erro ou o valor.
+        void put( const LineResult & result_ );
+        /// Escreve linhas já formatadas (terminadas em '\n').
+        void write( std::string_view text_ );
+        /// Escreve o buffer no descritor. Retorna `false` se houve um erro de escrita.
+        bool flush( void );
+
+        /// Não houve nenhum erro de escrita até agora?
+        bool good( void ) const { return m_good; }
+
+    private:
+        int m_fd;                     //<! Descritor da saída.
+        flush_t m_mode;               //<! Modo de escrita.
+        std::vector< char > m_buffer; //<! Buffer da saída.
+        std::size_t m_size = 0;       //<! Quantidade de bytes no buffer.
+        bool m_good = true;           //<! Alguma escrita falhou?
+
+        /// Escreve `size_` bytes a partir de `data_` no descritor.
+        bool write_all( const char * data_, std::size_t size_ );
+};
+
+#endif
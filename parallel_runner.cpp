@@ -0,0 +1,233 @@
+#include "parallel_runner.h"
+#include "stats.h"
+
+namespace {
+    /// Número máximo de linhas em um bloco.
+    const std::size_t CHUNK_LINES = 1024;
+    /// Tamanho máximo (aproximado) de um bloco, em bytes.
+    const std::size_t CHUNK_BYTES = 256 * 1024;
+    /// Blocos em andamento por worker (limita a memória usada).
+    const std::size_t CHUNKS_PER_WORKER = 4;
+}
+
+/*!
+ * \param n_workers_ Número de threads (pelo menos uma).
+ * \param mode_ Modo de avaliação dos workers.
+ * \param cache_size_ Tamanho do cache de cada worker (zero: sem cache).
+ */
+ParallelRunner::ParallelRunner( std::size_t n_workers_, LineEvaluator::mode_t mode_, std::size_t cache_size_ )
+{
+    if ( n_workers_ == 0 ) n_workers_ = 1;
+
+    for ( std::size_t i( 0 ); i < n_workers_; ++i )
+    {
+        m_workers.emplace_back( new Worker( mode_ ) );
+        if ( cache_size_ > 0 ) m_workers.back()->cache.reset( new ResultCache( cache_size_ ) );
+    }
+    // Os workers só começam depois que todos existem, pois podem roubar uns dos outros.
+    for ( std::size_t i( 0 ); i < n_workers_; ++i )
+        m_workers[i]->thread = std::thread( &ParallelRunner::work, this, i );
+}
+
+ParallelRunner::~ParallelRunner()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_work_mtx );
+        m_stop = true;
+    }
+    m_work_cv.notify_all();
+    for ( auto & w : m_workers )
+        w->thread.join();
+}
+
+/*!
+ * \brief Lê a entrada em blocos, entrega os blocos aos workers e escreve as saídas em ordem.
+ *
+ * No máximo `CHUNKS_PER_WORKER` blocos por worker ficam em andamento; quando
+ * esse limite é atingido, a thread espera o bloco mais antigo ficar pronto,
+ * escreve a sua saída e reaproveita o bloco para continuar a leitura.
+ *
+ * Se a entrada está mapeada em memória, os blocos apontam direto para ela;
+ * caso contrário, as linhas são copiadas para o bloco.
+ */
+void ParallelRunner::run( LineReader & in_, ResultWriter & out_ )
+{
+    const std::size_t max_in_flight = CHUNKS_PER_WORKER * m_workers.size();
+    std::vector< std::unique_ptr< Chunk > > storage; // Todos os blocos (reaproveitados).
+    std::deque< Chunk * > in_flight;                 // Blocos em andamento, na ordem da entrada.
+    std::vector< Chunk * > free_chunks;              // Blocos prontos para serem reaproveitados.
+    std::size_t next_worker = 0;
+
+    // Espera o bloco mais antigo ficar pronto e escreve a sua saída.
+    auto write_oldest = [&]()
+    {
+        Chunk * chunk = in_flight.front();
+        {
+            std::unique_lock< std::mutex > lock( m_done_mtx );
+            m_done_cv.wait( lock, [chunk]{ return chunk->done; } );
+        }
+        out_.write( chunk->output );
+        in_flight.pop_front();
+        free_chunks.push_back( chunk );
+    };
+
+    std::string_view line;
+    bool eof = false;
+    while ( not eof )
+    {
+        if ( in_flight.size() == max_in_flight )
+            write_oldest();
+
+        Chunk * chunk;
+        if ( free_chunks.empty() )
+        {
+            storage.emplace_back( new Chunk );
+            chunk = storage.back().get();
+        }
+        else
+        {
+            chunk = free_chunks.back();
+            free_chunks.pop_back();
+        }
+        chunk->lines.clear();
+        chunk->input.clear();
+        chunk->ends.clear();
+        chunk->output.clear();
+        chunk->done = false;
+
+        // Preenche o bloco com linhas da entrada.
+        std::size_t bytes = 0;
+        while ( chunk->lines.size() < CHUNK_LINES and bytes < CHUNK_BYTES )
+        {
+            if ( not in_.next( line ) )
+            {
+                eof = true;
+                break;
+            }
+            bytes += line.size();
+            chunk->lines.push_back( line );
+            if ( not in_.stable() )
+            {
+                // A linha só vale até a próxima leitura: copiamos para o bloco.
+                chunk->input.append( line );
+                chunk->ends.push_back( chunk->input.size() );
+            }
+        }
+        if ( not in_.stable() )
+        {
+            // Agora que o bloco não cresce mais, as linhas apontam para a cópia.
+            std::size_t begin = 0;
+            for ( std::size_t i( 0 ); i < chunk->ends.size(); ++i )
+            {
+                chunk->lines[i] = std::string_view( chunk->input.data() + begin, chunk->ends[i] - begin );
+                begin = chunk->ends[i];
+            }
+        }
+
+        if ( chunk->lines.empty() )
+        {
+            free_chunks.push_back( chunk );
+            break;
+        }
+        in_flight.push_back( chunk );
+        dispatch( chunk, next_worker );
+        next_worker = ( next_worker + 1 ) % m_workers.size();
+    }
+
+    while ( not in_flight.empty() )
+        write_oldest();
+}
+
+/// Soma os contadores dos caches de todos os workers.
+ResultCache::Stats ParallelRunner::cache_stats( void ) const
+{
+    ResultCache::Stats total;
+    for ( const auto & w : m_workers )
+    {
+        if ( not w->cache ) continue;
+        total.hits += w->cache->stats().hits;
+        total.misses += w->cache->stats().misses;
+        total.evictions += w->cache->stats().evictions;
+    }
+    return total;
+}
+
+/// Coloca o bloco no fim da fila do worker `id_` e acorda um worker.
+void ParallelRunner::dispatch( Chunk * chunk_, std::size_t id_ )
+{
+    {
+        // Contado antes de entrar na fila, para que `m_pending` nunca fique negativo.
+        std::lock_guard< std::mutex > lock( m_work_mtx );
+        ++m_pending;
+    }
+    {
+        std::lock_guard< std::mutex > lock( m_workers[ id_ ]->mtx );
+        m_workers[ id_ ]->queue.push_back( chunk_ );
+    }
+    m_work_cv.notify_one();
+}
+
+/*!
+ * \brief Pega o próximo bloco para o worker `id_`.
+ * Primeiro tenta o início da própria fila (o bloco mais antigo); se ela
+ * estiver vazia, rouba do fim da fila de outro worker.
+ * \return O bloco, ou `nullptr` se todas as filas estiverem vazias.
+ */
+ParallelRunner::Chunk * ParallelRunner::take( std::size_t id_ )
+{
+    const std::size_t n = m_workers.size();
+    for ( std::size_t k( 0 ); k < n; ++k )
+    {
+        Worker & victim = *m_workers[ ( id_ + k ) % n ];
+        std::lock_guard< std::mutex > lock( victim.mtx );
+        if ( victim.queue.empty() ) continue;
+
+        Chunk * chunk;
+        if ( k == 0 ) { chunk = victim.queue.front(); victim.queue.pop_front(); }
+        else          { chunk = victim.queue.back();  victim.queue.pop_back(); }
+        --m_pending;
+        return chunk;
+    }
+    return nullptr;
+}
+
+/// Laço de um worker: pega blocos (próprios ou roubados) até o runner ser encerrado.
+void ParallelRunner::work( std::size_t id_ )
+{
+    Worker & self = *m_workers[ id_ ];
+    for ( ;; )
+    {
+        Chunk * chunk = take( id_ );
+        if ( chunk == nullptr )
+        {
+            std::unique_lock< std::mutex > lock( m_work_mtx );
+            m_work_cv.wait( lock, [this]{ return m_stop or m_pending > 0; } );
+            if ( m_stop and m_pending == 0 ) return;
+            continue;
+        }
+
+        process( self, *chunk );
+        {
+            std::lock_guard< std::mutex > lock( m_done_mtx );
+            chunk->done = true;
+        }
+        m_done_cv.notify_one();
+    }
+}
+
+/// Avalia cada linha do bloco, acumulando a saída formatada em `chunk_.output`.
+void ParallelRunner::process( Worker & worker_, Chunk & chunk_ )
+{
+    LineResult result;
+    for ( auto line : chunk_.lines )
+    {
+        StageTimer timer( Stats::LINE );
+        if ( not worker_.cache or not worker_.cache->lookup( line, result ) )
+        {
+            result = worker_.evaluator.evaluate( line );
+            if ( worker_.cache ) worker_.cache->insert( result );
+        }
+        append_result( chunk_.output, result );
+        if ( Stats::enabled() ) Stats::local().add_result( result.parser_result.type, result.eval_result.type );
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef _PARALLEL_RUNNER_H_
+#define _PARALLEL_RUNNER_H_
+
+#include <cstddef>            // std::size_t
+#include <string>             // std::string
+#include <string_view>        // std::string_view
+#include <vector>             // std::vector
+#include <deque>              // std::deque
+#include <memory>             // std::unique_ptr
+#include <thread>             // std::thread
+#include <mutex>              // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <atomic>             // std::atomic
+
+#include "line_evaluator.h"
+#include "result_cache.h"
+#include "line_reader.h"
+#include "output.h"
+
+/*!
+ * Avalia as linhas da entrada em paralelo, preservando a ordem da saída.
+ *
+ * A entrada é lida em blocos (*chunks*) de linhas. Cada bloco é entregue à
+ * fila de um dos *workers*, que tem o seu próprio `LineEvaluator` (e cache,
+ * se houver). Um worker sem trabalho rouba blocos das filas dos outros
+ * (*work stealing*), então uma linha muito longa não segura os blocos que
+ * estão na fila atrás dela.
+ *
+ * A thread que chama `run()` lê a entrada e escreve a saída: os blocos são
+ * escritos na ordem em que foram lidos, assim que ficam prontos, então a saída
+ * é idêntica byte a byte à do modo serial. O número de blocos em andamento é
+ * limitado, o que limita também a memória usada.
+ */
+class ParallelRunner
+{
+    public:
+        /// Cria `n_workers_` workers, cada um com um avaliador no modo `mode_` e um cache de `cache_size_` entradas (zero: sem cache).
+        ParallelRunner( std::size_t n_workers_, LineEvaluator::mode_t mode_, std::size_t cache_size_ );
+        /// Encerra os workers.
+        ~ParallelRunner();
+        /// Desligar cópia e atribuição.
+        ParallelRunner( const ParallelRunner & ) = delete;
+        ParallelRunner & operator=( const ParallelRunner & ) = delete;
+
+        /// Avalia todas as linhas de `in_`, escrevendo os resultados em `out_`, na ordem da entrada.
+        void run( LineReader & in_, ResultWriter & out_ );
+
+        /// Soma dos contadores dos caches dos workers.
+        ResultCache::Stats cache_stats( void ) const;
+
+    private:
+        /// Um bloco de linhas da entrada e a saída correspondente.
+        struct Chunk
+        {
+            std::vector< std::string_view > lines; //<! Linhas do bloco (sem os '\n').
+            std::string input;                 //<! Cópia das linhas, se a entrada não for mapeada em memória.
+            std::vector< std::size_t > ends;   //<! Posição do fim de cada linha em `input`.
+            std::string output;                //<! Saída do bloco, já formatada.
+            bool done = false;                 //<! O bloco já foi avaliado? (protegido por `m_done_mtx`)
+        };
+
+        /// Um worker: a thread, a sua fila de blocos e o seu avaliador.
+        struct Worker
+        {
+            std::thread thread;                  //<! Thread do worker.
+            std::mutex mtx;                      //<! Protege `queue`.
+            std::deque< Chunk * > queue;         //<! Blocos entregues a este worker.
+            LineEvaluator evaluator;             //<! Avaliador próprio do worker.
+            std::unique_ptr< ResultCache > cache; //<! Cache próprio do worker (opcional).
+
+            Worker( LineEvaluator::mode_t mode_ ) : evaluator( mode_ ) { /* empty */ }
+        };
+
+        std::vector< std::unique_ptr< Worker > > m_workers; //<! Os workers.
+
+        std::mutex m_work_mtx;              //<! Protege a espera por trabalho.
+        std::condition_variable m_work_cv;  //<! Acorda os workers quando chega um bloco (ou no fim).
+        std::atomic< std::size_t > m_pending{ 0 }; //<! Blocos nas filas, ainda não pegos por nenhum worker.
+        bool m_stop = false;                //<! Os workers devem terminar? (protegido por `m_work_mtx`)
+
+        std::mutex m_done_mtx;              //<! Protege `Chunk::done`.
+        std::condition_variable m_done_cv;  //<! Avisa que um bloco ficou pronto.
+
+        /// Laço de um worker.
+        void work( std::size_t id_ );
+        /// Pega um bloco da própria fila ou rouba de outro worker.
+        Chunk * take( std::size_t id_ );
+        /// Avalia todas as linhas de um bloco.
+        void process( Worker &, Chunk & );
+        /// Entrega um bloco à fila de um worker.
+        void dispatch( Chunk *, std::size_t id_ );
+};
+
+#endif
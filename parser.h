@@ -1,15 +1,20 @@
 #ifndef _PARSER_H_
 #define _PARSER_H_
 
-#include <iostream> // cout, cin
-#include <iterator> // std::distance()
-#include <vector>   // std::vector
-#include <sstream>  // std::istringstream
+#include <iostream>    // cout, cin
+#include <iterator>    // std::distance()
+#include <vector>      // std::vector
+#include <string_view> // std::string_view
+#include <algorithm>   // std::max, std::fill
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <type_traits> // std::is_constant_evaluated()
 
-#include "token.h"  // struct Token.
+#include "token.h"  // struct BasicToken.
+#include "structural_index.h" // class StructuralIndex.
+#include "stats.h"  // class StageTimer.
 
 /*!
- * Implements a recursive descendent parser for a EBNF grammar.
+ * Implements a descendent parser for a EBNF grammar.
  *   First Version
  *
  *   <expr>            := <term>,{ ("+"|"-"),<term> };
@@ -29,12 +34,28 @@
  *   <digit_excl_zero> := "1"|"2"|"3"|"4"|"5"|"6"|"7"|"8"|"9";
  *   <digit> := "0"| <digit_excl_zero>;
  *
- *   This version is using the full grammar without treating parenthesis.
+ *   Formulas (with `Context::variables` set) also accept named variables:
+ *
+ *   <term> := "(",<expr>,")" | <integer> | <variable>;
+ *   <variable> := <letter>,{ <letter> | <digit> };
+ *   <letter> := "a"-"z" | "A"-"Z" | "_";
+ *
+ *   This version is using the full grammar. The nesting of "(",<expr>,")" is
+ *   tracked with an explicit stack (a counter of open parenthesis) instead of
+ *   recursion, so the depth of the expression is not limited by the call stack.
+ *
+ *   The parser is a template over the numeric policy (numeric_policy.h), which
+ *   gives the range of the operands; `Parser` is the program's policy.
+ *   All routines are `constexpr` (and defined in this header), so the same
+ *   parser also runs at compile time (see bares.h).
  */
-
-class Parser
+template < typename Policy >
+class BasicParser
 {
     public:
+        typedef typename Policy::value_type value_type; //<! Valor de um operando.
+        typedef BasicToken< value_type > Token;         //<! Token com operandos da política.
+
         /*! Classe interna representado o resultado do parsing.
          *  Ela deve ser pública para que o 'cliente' possa acessar o resultado.
          *  Por ser uma classe muito simples, vamos deixar seus campos públicos,
@@ -61,23 +82,58 @@ class Parser
             size_type at_col; //<! Guarda a coluna do erro.
 
             // Por padrão, o resultado é positivo.
-            explicit ParserResult( code_t type_=PARSER_OK , size_type col_=0u )
+            constexpr explicit ParserResult( code_t type_=PARSER_OK , size_type col_=0u )
                     : type{ type_ }
                     , at_col{ col_ }
             { /* empty */ }
         };
 
-        /// Recebe uma expressão, realiza o parsing e retorna o resultado.
-        ParserResult parse( std::string e_ );
-        /// Retorna a lista de tokens.
-        std::vector< Token > get_tokens( void ) const;
+        /// Uma posição do índice das variáveis: vale só na geração (expressão) em que foi gravada.
+        struct VariableSlot
+        {
+            std::uint32_t generation = 0; //<! Geração em que a posição foi ocupada (0: nunca).
+            std::uint32_t number = 0;     //<! Número da variável (posição em `variable_names`).
+        };
+
+        /*! Estado de uma operação de parsing.
+         *  O contexto pertence ao cliente e deve ser reutilizado entre as expressões:
+         *  como a lista de tokens só é limpa (e não destruída), depois das primeiras
+         *  expressões o parsing não faz mais nenhuma alocação.
+         *  Cada thread deve usar o seu próprio contexto.
+         */
+        struct Context
+        {
+            std::string_view expr;                  //<! Expressão sendo analisada (não é copiada).
+            std::string_view::iterator curr_symb{}; //<! Posição atualmente processada dentro da expressão.
+            ParserResult curr_status;               //<! Guarda o estado atual da operação de parsing.
+            std::vector< Token > token_list;        //<! Lista de tokens que foram processados pelo parser.
+            value_type curr_value = 0;              //<! Valor do último inteiro aceito (decodificado durante o parsing).
+            bool curr_overflow = false;             //<! O último inteiro aceito está fora dos limites da política?
+            StructuralIndex index;                  //<! Classes dos caracteres da expressão, calculadas antes do parsing.
+            bool variables = false;                 //<! Aceitar <variable> como <term>? (Desligado, letras são símbolos inválidos.)
+            std::vector< std::string_view > variable_names; //<! Nome de cada variável, na ordem em que apareceram (visões da expressão).
+            std::vector< VariableSlot > variable_slots;     //<! Índice nome -> número (espalhamento com sondagem linear, no máximo meio cheio).
+            std::uint32_t variable_generation = 0;          //<! Geração atual do índice; posições de outras gerações estão vazias.
+        };
+
+        /// Recebe uma expressão, realiza o parsing no contexto indicado e retorna o resultado.
+        constexpr ParserResult parse( std::string_view e_, Context & ctx_ ) const;
+        /// Recebe uma expressão, realiza o parsing (no contexto interno) e retorna o resultado.
+        constexpr ParserResult parse( std::string_view e_ );
+        /// Retorna a lista de tokens do contexto interno.
+        constexpr const std::vector< Token > & get_tokens( void ) const;
+
+        /// Esquece as variáveis da expressão anterior (no começo de cada parsing).
+        static constexpr void clear_variables( Context & ctx_ );
+        /// Número da variável `name_` (uma variável nova recebe o próximo); `false` se o número não cabe no valor do token.
+        static constexpr bool variable_number( Context & ctx_, std::string_view name_, value_type & number_ );
 
         /// Constutor default.
-        Parser() = default;
-        ~Parser() = default;
+        BasicParser() = default;
+        ~BasicParser() = default;
         /// Desligar cópia e atribuição.
-        Parser( const Parser & ) = delete;  // Construtor cópia.
-        Parser & operator=( const Parser & ) = delete; // Atribuição.
+        BasicParser( const BasicParser & ) = delete;  // Construtor cópia.
+        BasicParser & operator=( const BasicParser & ) = delete; // Atribuição.
 
     private:
         // Tabela de símbolos terminais.
@@ -95,36 +151,664 @@ class Parser
             TS_NON_ZERO_DIGIT,  //<! "1"->"9"
             TS_WS,              //<! white-space
             TS_TAB,             //<! tab
+            TS_LETTER,          //<! "a"->"z", "A"->"Z", "_"
             TS_EOS,
             TS_INVALID	        //<! invalid token
         };
 
         // Membros privados do parser.
-        std::string expr;                //<! Expressão para ser avaliada.
-        std::string::iterator curr_symb; //<! Posição atualmente processada dentro da expressão.
-        ParserResult curr_status;        //<! Guarda o estado atual da operação de parsing.
-        std::vector< Token > token_list; //<! Lista de tokens que foram processados pelo parser.
+        Context own_ctx; //<! Contexto usado pela versão de conveniência de `parse()`.
 
 
         /// Converte de caractere para código do símbolo terminal.
-        terminal_symbol_t lexer( char ) const;
+        constexpr terminal_symbol_t lexer( char ) const;
 
         // Métodos de suporte
-        bool peek( terminal_symbol_t s_ ) const; // Espia o caractere atual.
-        bool accept( terminal_symbol_t s_ ); // Tenta aceita o símbolo indicado.
-        void next_symbol( void ); // Avança o iterador para o próximo símbolo.
-        bool expect( terminal_symbol_t ); // Pula ws e tenta aceitar o primeiro caractere que não seja ws.
-        void skip_ws( void ); // Pula os caracteres ws (espaço em branco ou tab).
-        bool end_input( void ) const; // Verifica se chegamos ao fim da expressão.
+        constexpr bool peek( const Context &, terminal_symbol_t s_ ) const; // Espia o caractere atual.
+        constexpr bool accept( Context &, terminal_symbol_t s_ ) const; // Tenta aceita o símbolo indicado.
+        constexpr void next_symbol( Context & ) const; // Avança o iterador para o próximo símbolo.
+        constexpr bool expect( Context &, terminal_symbol_t ) const; // Pula ws e tenta aceitar o primeiro caractere que não seja ws.
+        constexpr bool expect_operator( Context & ) const; // Pula ws e tenta aceitar um operador binário.
+        constexpr void skip_ws( Context & ) const; // Pula os caracteres ws (espaço em branco ou tab).
+        constexpr bool end_input( const Context & ) const; // Verifica se chegamos ao fim da expressão.
+        constexpr bool is_digit( const Context &, std::size_t pos_ ) const; // O caractere na posição é um dígito?
 
         // Aqui vem os métodos correspondentes às regras de produção da gramática.
-       void expression();
-       void term();
-       void integer();
-       void natural_number();
-
-       //
-       bool outside_range( std::string ) const;
+       constexpr void expression( Context & ) const;
+       constexpr void term( Context &, std::size_t & open_ ) const;
+       constexpr void integer( Context & ) const;
+       constexpr void natural_number( Context & ) const;
+       constexpr void variable( Context & ) const;
 };
 
-#endif
\ No newline at end of file
+/*!
+ * Este é o **ponto de entrada**.
+ * A partir daqui o parser tenta aceitar os símbolos não-terminais da
+ * gramática, de maneira descendente (os parênteses são tratados com uma pilha
+ * explícita, sem recursão; veja expression()).
+ *
+ * Todo o estado da operação fica no contexto `ctx_`, que pertence ao cliente.
+ * O método não altera o parser, então um mesmo `Parser` pode ser compartilhado
+ * por várias threads, desde que cada uma use o seu próprio contexto.
+ * A expressão não é copiada: os tokens guardam apenas a coluna de origem.
+ *
+ * Em `constexpr` (veja bares.h) o índice estrutural não é construído: as
+ * classes dos caracteres vêm do lexer(), um caractere por vez. O resto do
+ * parsing é o mesmo código nos dois casos.
+ *
+ * \param e_ A expressão que o cliente quer analisar sintaticamente.
+ * \param ctx_ Contexto (reutilizável) que recebe o estado e a lista de tokens.
+ * \return O resultado do parsing.
+ */
+template < typename Policy >
+constexpr typename BasicParser< Policy >::ParserResult
+BasicParser< Policy >::parse( std::string_view e_, Context & ctx_ ) const
+{
+    // Os 6 comandos abaixo são executados a cada nova string a ser analisada.
+    ctx_.expr = e_;  // Guarda (uma visão da) expressão passada.
+    ctx_.curr_symb = ctx_.expr.begin(); // Iterador aponta p/ 1o caractere da string.
+    ctx_.curr_status = ParserResult( ParserResult::PARSER_OK ); // "Resetar" a msg de status p/ OK.
+    ctx_.token_list.clear(); // Limpar a lista de tokens (mantendo a capacidade) para a próxima expressão.
+    clear_variables( ctx_ );
+    if ( not std::is_constant_evaluated() )
+    {
+        StageTimer timer( Stats::LEX );
+        ctx_.index.build( e_ ); // Classificar todos os caracteres de uma vez (SIMD), antes do parsing.
+    }
+    StageTimer timer( Stats::PARSE );
+
+    // Verificar se a string acabou sem conter uma expressão.
+    skip_ws( ctx_ );
+    if ( end_input( ctx_ ) )
+    {
+        // Recebemos uma string vazia.
+        ctx_.curr_status = ParserResult( ParserResult::UNEXPECTED_END_OF_EXPRESSION,
+                                    std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+    }
+    else
+    {
+        // Se chegou aqui, então estamos esperando uma expressão bem formada.
+        expression( ctx_ ); // Tenta aceitar uma expressão bem formada.
+        
+        // Se depois da expressão ter sido bem avaliada (sem erros), ainda existir algum
+        // caractere (que não seja ws), então existem símbolo(s) estranho(s)...
+        if ( ctx_.curr_status.type == ParserResult::PARSER_OK )
+        {
+            // Saltamos qualquer espaço em branco remanescente da string.
+            skip_ws( ctx_ );
+            if ( not end_input( ctx_ ) ) // Se não chegamos ao fim da string, é porque
+            {                      // tem símbolo não-esperado na string!
+                ctx_.curr_status = ParserResult( ParserResult::EXTRANEOUS_SYMBOL,
+                        std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+            }
+        }
+    }
+
+    if ( not std::is_constant_evaluated() and Stats::enabled() ) Stats::local().add_tokens( ctx_.token_list.size() );
+    return ctx_.curr_status; // Retorna para o cliente o resultado do parsing.
+}
+
+/*!
+ * Versão de conveniência de `parse()`, que usa um contexto interno ao parser.
+ * Não é reentrante: use `parse( e_, ctx_ )` para compartilhar o parser entre threads.
+ *
+ * \param e_ A expressão que o cliente quer analisar sintaticamente.
+ * \return O resultado do parsing.
+ * \sa get_tokens().
+ */
+template < typename Policy >
+constexpr typename BasicParser< Policy >::ParserResult
+BasicParser< Policy >::parse( std::string_view e_ )
+{
+    return parse( e_, own_ctx );
+}
+
+/// Retorna a lista de tokens produzida pela última chamada de `parse( e_ )`.
+template < typename Policy >
+constexpr const std::vector< typename BasicParser< Policy >::Token > &
+BasicParser< Policy >::get_tokens( void ) const
+{
+    return own_ctx.token_list;
+}
+
+/*!
+ *  \brief Verifica se o caractere atual (curr_symb) corresponde ao código esperado.
+ *
+ *  Porém, o método **não consome** o caractere, ou seja, o iterador `curr_symb` não avança.
+ *  Basicamente este método funciona como uma tabela:
+ *
+ *  ----------+-------
+ *  Caractere | Código
+ *  ----------+-------
+ *  "("       |  0
+ *  ")"       |  1
+ *  "+"       |  2
+ *  "-"       |  3
+ *  ...
+ *
+ *  \param c_ O caractere do símbolo que desejamos converter para o código (enum) do símbolo.
+ *  \return O código (enum) do caractere indicado por parâmetro.
+ */
+template < typename Policy >
+constexpr typename BasicParser< Policy >::terminal_symbol_t BasicParser< Policy >::lexer( char c_ ) const
+{
+    switch( c_ )
+    {
+        case '(':  return TS_L_PAREN;
+        case '+':  return TS_PLUS;
+        case '-':  return TS_MINUS;
+        case '*':  return TS_TIMES;
+        case '/':  return TS_DIVIDED;
+        case '%':  return TS_MOD;
+        case '^':  return TS_POWER;
+        case ')':  return TS_R_PAREN;
+        case ' ':  return TS_WS;
+        case   9:  return TS_TAB;
+        case '0':  return TS_ZERO;
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':  return TS_NON_ZERO_DIGIT;
+        case '_':  return TS_LETTER;
+        case   0:  return TS_EOS; // end of string: the $ terminal symbol
+        default :  // Letras só aparecem em variáveis; o resto é inválido.
+            if ( ( c_ >= 'a' and c_ <= 'z' ) or ( c_ >= 'A' and c_ <= 'Z' ) ) return TS_LETTER;
+            return TS_INVALID;
+    }
+}
+
+/*!
+ * \brief Verifica se o caractere atual (`*curr_symb`) corresponde ao símbolo passado.
+ * \param s_ Código (enum) do símbolo desejado.
+ * \return `true`, se o símbolo atual for o desejado, `false`, caso contrário.
+ * \sa accept(), expect(), next_symb(), lexer().
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::peek( const Context & ctx_, terminal_symbol_t s_ ) const
+{
+    // A classe do caractere atual vem do índice estrutural; o caractere só é
+    // examinado para distinguir os símbolos de uma mesma classe.
+    const auto pos = std::distance( ctx_.expr.begin(), ctx_.curr_symb );
+    switch ( s_ )
+    {
+        case TS_ZERO:           return is_digit( ctx_, pos ) and *ctx_.curr_symb == '0';
+        case TS_NON_ZERO_DIGIT: return is_digit( ctx_, pos ) and *ctx_.curr_symb != '0';
+        case TS_INVALID:        return std::is_constant_evaluated() ? lexer( *ctx_.curr_symb ) == s_ : ctx_.index.is_invalid( pos );
+        default:                return lexer( *ctx_.curr_symb ) == s_;
+    }
+}
+
+/*!
+ * \brief Avança o iterador que aponta para o símbolo (caractere) atual na expressão.
+ * \sa skip_ws(), accept(), expect().
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::next_symbol( Context & ctx_ ) const
+{
+    // Avançar iterador
+    ctx_.curr_symb++;
+    // poderia ser:
+    // std::advance( curr_symb, 1 );
+}
+
+
+/*!
+ * \brief Verifica se chegamos ao fim da expressão.
+ * \return `true` se chegamos ao fim da expressão, `false` caso contrário.
+ * \sa next_symb(), skip_ws().
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::end_input( const Context & ctx_ ) const
+{
+    // Verificar se o iterador chegou ao fim da string.
+    return ctx_.curr_symb == ctx_.expr.end();
+}
+
+/*!
+ * \brief Salta caracteres em branco ou tabs encontrados na expressão.
+ * O método deixa o iterador `curr_symb` apontando para o primeiro próximo
+ * caractere da expressão que não seja ws (espaço em branco ou tab).
+ *
+ * \note
+ * O método pode fazer o ponteiro chegar ao fim da expressão, se ela possuir
+ * apenas ws até o final.
+ *
+ * \sa end_input(), accept(), next_symb().
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::skip_ws( Context & ctx_ ) const
+{
+    if ( std::is_constant_evaluated() )
+    {
+        // Sem o índice: um caractere por vez.
+        while ( not end_input( ctx_ ) and ( lexer( *ctx_.curr_symb ) == TS_WS or lexer( *ctx_.curr_symb ) == TS_TAB ) )
+            next_symbol( ctx_ );
+        return;
+    }
+    // O índice acha o próximo caractere que não é ws (64 posições por vez).
+    auto pos = std::distance( ctx_.expr.begin(), ctx_.curr_symb );
+    ctx_.curr_symb = ctx_.expr.begin() + ctx_.index.skip_ws( pos );
+}
+
+/*!
+ * \brief Verifica se o caractere na posição `pos_` da expressão é um dígito.
+ * Em `constexpr`, sem o índice estrutural, a classe vem do lexer().
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::is_digit( const Context & ctx_, std::size_t pos_ ) const
+{
+    if ( std::is_constant_evaluated() )
+        return lexer( ctx_.expr[ pos_ ] ) == TS_ZERO or lexer( ctx_.expr[ pos_ ] ) == TS_NON_ZERO_DIGIT;
+    return ctx_.index.is_digit( pos_ );
+}
+
+/*!
+ * \brief Tenta "aceitar" o símbolo indicado.
+ * O método tenta verificar se o símbolo indicado bate com o símbolo atual da expressão.
+ * Se bate, o símbolo é consumido (i.e. o iterador avança) e o método retorna `true'.
+ * Se falhar, o iterador fica onde está e o método retorna `false`.
+ * \param s_ O cósigo do símbolo que desejamos aceitar.
+ * \return `true` se o código for aceito, `false` caso contrário.
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::accept( Context & ctx_, terminal_symbol_t s_ ) const
+{
+    // Tentando consumir (da expressão) o símbolo indicado (pelo processo de parsing).
+    if ( not end_input( ctx_ ) and peek( ctx_, s_ ) )
+    {
+        next_symbol( ctx_ ); // Consome caractere (símbolo) da expressão-string.
+        return true;
+    }
+    return false;
+}
+
+/*!
+ * \brief Salta ws e tenta "aceitar" o símbolo indicado.
+ * O método é muito similar ao `Parser::accept()`, com a diferença que ele tenta
+ * saltar ws que existam até chegar em um símbolo "processável".
+ * Então o método tenta aceitar tal símbolo.
+ * \param s_ O cósigo do símbolo que desejamos aceitar.
+ * \return `true` se o código for aceito, `false` caso contrário.
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::expect( Context & ctx_, terminal_symbol_t s_ ) const
+{
+    // (1) Saltar espaços em branco
+    skip_ws( ctx_ );
+    // (2) tentar aceitar o símbolo.
+    return accept( ctx_, s_ );
+}
+
+/*!
+ * \brief Salta ws e tenta "aceitar" um operador binário qualquer.
+ * Equivale a `expect( TS_PLUS ) or expect( TS_MINUS ) or ...`, mas com um único
+ * teste na máscara de operadores do índice estrutural.
+ * \return `true` se um operador foi aceito, `false` caso contrário.
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::expect_operator( Context & ctx_ ) const
+{
+    skip_ws( ctx_ );
+    if ( std::is_constant_evaluated() )
+    {
+        // Sem o índice: o operador vem do lexer() (de TS_PLUS a TS_POWER).
+        if ( end_input( ctx_ ) ) return false;
+        const auto s = lexer( *ctx_.curr_symb );
+        if ( s < TS_PLUS or s > TS_POWER ) return false;
+        next_symbol( ctx_ );
+        return true;
+    }
+    if ( ctx_.index.is_operator( std::distance( ctx_.expr.begin(), ctx_.curr_symb ) ) )
+    {
+        next_symbol( ctx_ );
+        return true;
+    }
+    return false;
+}
+
+/*! \brief Parses a NTS <expression>.
+ *
+ *  This method parses part of the input expression looking for <expression>.
+ *
+ *  The productions are:
+ *  ```
+ *  <expr> := <term>,{ ("+"|"-"|"*"|"/"|"%"|"^"),<term> };
+ *  <term> := "(",<expr>,")" | <integer>;
+ *  ```
+ *  As produções são recursivas (uma <expr> dentro de um <term>), mas o parsing
+ *  não é: um "(" não chama expression() de novo, só é empilhado, e a <expr>
+ *  interna continua neste mesmo laço. Como só existe um tipo de escopo, a pilha
+ *  se reduz ao número de parênteses abertos (`open`). Cada ")" fecha o "(" mais
+ *  recente, encerrando a <expr> interna e o <term> que a continha; depois dele
+ *  a <expr> externa continua com um operador, outro ")" ou o seu fim.
+ *  Assim a profundidade dos parênteses não é limitada pela pilha de chamadas e
+ *  o tempo é linear no tamanho da expressão.
+ *
+ *  \sa parser(), term().
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::expression( Context & ctx_ ) const
+{
+    std::size_t open = 0; // Parênteses abertos (e ainda não fechados) até aqui.
+
+    for ( ;; )
+    {
+        term( ctx_, open ); // Procura aceitar um <term>, com os "(" que o abrem.
+
+        // Verificar se já não tem erro encontrado, ou seja, o <term> anterior foi mal-formado.
+        if ( ctx_.curr_status.type != ParserResult::PARSER_OK )
+            return; // Não adiantar continuar processando, melhor voltar...
+
+        // Cada ")" fecha o "(" aberto mais recentemente.
+        while ( open > 0 and expect( ctx_, TS_R_PAREN ) )
+        {
+            // Inserir o token do ")" recém processado.
+            ctx_.token_list.emplace_back( Token::SCOPE, Token::R_PAREN, 0,
+                                     std::distance( ctx_.expr.begin(), ctx_.curr_symb ) - 1 );
+            --open;
+        }
+
+        // Se não vier um operador, a <expr> (a mais externa que ainda está aberta) terminou.
+        if ( not expect_operator( ctx_ ) )
+            break;
+
+        // ===============================================================================
+        // TOKENIZAÇÃO:
+        // Este código separa o token e o insere na lista de tokens
+        // -------------------------------------------------------------------------------
+        // Salvar o token correspondente ao operador binário recém processado.
+        std::advance( ctx_.curr_symb, -1 ); // Voltei uma posição para apontar para o operador.
+        // Inserir token completo na lista de tokens.
+        ctx_.token_list.emplace_back( Token::OPERATOR, Token::to_symbol( *ctx_.curr_symb ), 0,
+                                 std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+        // ===============================================================================
+
+        // Avançar novamente o curr_symb.
+        std::advance( ctx_.curr_symb, +1 );
+
+        skip_ws( ctx_ );
+        if ( end_input( ctx_ ) ) // Depois de saltar ws, não encontramos mais nada!! Erro!!
+        {
+            ctx_.curr_status = ParserResult( ParserResult::MISSING_TERM,
+                                        std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+            return;
+        }
+    }
+
+    // Algum "(" ficou aberto: o ")" deveria estar aqui (o ws já foi saltado).
+    if ( open > 0 )
+    {
+        ctx_.curr_status = ParserResult( ParserResult::MISSING_CLOSING_PARENTHESIS,
+                                    std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+    }
+}
+
+/*! \brief Parses a NTS <term>.
+ *
+ *  This method parses part of the input expression looking for <term>.
+ *  The production is:
+ *  ```
+ *  <term> := "(",<expr>,")" | <integer> | <variable>;
+ *  ```
+ *  Os "(" que abrem o <term> são consumidos e contados em `open_`; a <expr>
+ *  interna e o ")" são tratados pelo laço de expression(). O <integer> (ou,
+ *  numa fórmula, a <variable>) que vem depois dos "(" é validado e inserido na
+ *  lista de tokens.
+ *
+ *  \param open_ Número de parênteses abertos, incrementado a cada "(" aceito.
+ *  \sa expression(), integer().
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::term( Context & ctx_, std::size_t & open_ ) const
+{
+    // O ws antes do <term> já foi saltado (por parse(), depois de um operador ou depois de um "(").
+    while ( accept( ctx_, TS_L_PAREN ) )
+    {
+        // Inserir o token do "(" recém processado.
+        ctx_.token_list.emplace_back( Token::SCOPE, Token::L_PAREN, 0,
+                                 std::distance( ctx_.expr.begin(), ctx_.curr_symb ) - 1 );
+        ++open_;
+
+        skip_ws( ctx_ );
+        if ( end_input( ctx_ ) ) // Depois de um "(", precisamos de uma <expr>.
+        {
+            ctx_.curr_status = ParserResult( ParserResult::MISSING_TERM,
+                                        std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+            return;
+        }
+    }
+
+    // Uma variável, se a expressão é uma fórmula.
+    if ( ctx_.variables and not end_input( ctx_ ) and peek( ctx_, TS_LETTER ) )
+    {
+        variable( ctx_ );
+        return;
+    }
+
+    // Iniciando um novo token.
+    auto begin_token = ctx_.curr_symb;
+
+    integer( ctx_ );
+
+    // ===============================================================================
+    // TOKENIZAÇÃO:
+    // Este código separa o token e o insere na lista de tokens
+    // -------------------------------------------------------------------------------
+    // Se o <integer> foi mal-formado, o erro já está registrado em curr_status.
+    if ( ctx_.curr_status.type != ParserResult::PARSER_OK )
+        return;
+    // O valor do token já foi decodificado (e verificado) por natural_number() e integer().
+    if ( ctx_.curr_overflow )
+    {
+        // Gerar error de parser correspondente.
+        ctx_.curr_status = ParserResult( ParserResult::INTEGER_OUT_OF_RANGE,
+                std::distance( ctx_.expr.begin(), begin_token ) );
+    }
+    else
+    {
+        // Inserir o token bem formado na lista.
+        ctx_.token_list.emplace_back( Token::OPERAND, Token::NONE, ctx_.curr_value,
+                                 std::distance( ctx_.expr.begin(), begin_token ) );
+    }
+    // ===============================================================================
+}
+
+/*! \brief Parses a NTS <integer>.
+ *
+ *  This method parses part of the input expression looking for <integer>.
+ *
+ *  The production is:
+ *  <interget> := ["-"],<natural_number> | "0";
+ *
+ *
+ *  \sa natural_number()
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::integer( Context & ctx_ ) const
+{
+    ctx_.curr_value = 0;
+    ctx_.curr_overflow = false;
+    // Podemos receber um zero...
+    if ( expect( ctx_, TS_ZERO) )
+    {
+        return;
+    }
+    else  //... ou então um ["-"],<natural_number>
+    {
+        bool negative = accept( ctx_, TS_MINUS ); // Pode ser que venha um '-'.
+        natural_number( ctx_ );   // Aqui tentamos aceitar um <número_naural>.
+        // natural_number() acumula o valor negado; só trocamos o sinal se não houve '-'.
+        if ( not negative and not ctx_.curr_overflow )
+            ctx_.curr_overflow = not Policy::negate( ctx_.curr_value );
+    }
+}
+
+/*! \brief Parses o símbolo não-terminal <natural_number>.
+ *
+ *  This method parses part of the input expression looking for <natural_number>.
+ *  While the digits are consumed, their value is accumulated in `curr_value`.
+ *  The value is accumulated **negated**, since the negative range of an integer
+ *  is larger than the positive one. Once the value leaves the range of the
+ *  numeric policy the accumulation stops and `curr_overflow` is set (the
+ *  remaining digits are still consumed), so huge constants never overflow the
+ *  accumulator.
+ *
+ *  The production is:
+ *  ```
+ *  <natural_number> := <digit_excl_zero>,{<digit>};
+ *  ```
+ *  \sa integer(), NumericPolicy::push_digit()
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::natural_number( Context & ctx_ ) const
+{
+    // Tentando aceitar <digit_excl_zero>,
+    if ( accept( ctx_, TS_NON_ZERO_DIGIT ) )
+    {
+        ctx_.curr_value = -( *( ctx_.curr_symb - 1 ) - '0' );
+        // ... que pode ser seguido de 0 ou mais <digit>s: o índice diz onde termina a sequência de dígitos.
+        // (Em `constexpr`, sem o índice, a sequência é percorrida até o primeiro não-dígito.)
+        auto last = ctx_.curr_symb;
+        if ( std::is_constant_evaluated() )
+            while ( last != ctx_.expr.end() and is_digit( ctx_, std::distance( ctx_.expr.begin(), last ) ) ) ++last;
+        else
+            last = ctx_.expr.begin() + ctx_.index.skip_digits( std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+        for ( ; ctx_.curr_symb != last; ++ctx_.curr_symb )
+        {
+            // Acumular o dígito, se ainda estivermos dentro dos limites.
+            if ( not ctx_.curr_overflow )
+                ctx_.curr_overflow = not Policy::push_digit( ctx_.curr_value, *ctx_.curr_symb - '0' );
+        }
+    }
+    else
+    {
+        // Opa, veio "algo" que não é um 'dígito_diferente_de_zero'!
+        ctx_.curr_status = ParserResult( ParserResult::ILL_FORMED_INTEGER,
+                                    std::distance( ctx_.expr.begin(), ctx_.curr_symb ) );
+    }
+}
+
+/*! \brief Parses o símbolo não-terminal <variable>.
+ *
+ *  This method parses part of the input expression looking for <variable>
+ *  (only called by term() when `ctx_.variables` is set and a <letter> comes).
+ *  Variables are numbered in the order they first appear: the token stores the
+ *  number, and the name is `ctx_.variable_names[ number ]`. Names are looked up
+ *  in the context's hash index (variable_number()). A formula with more
+ *  variables than the token value can number is _integer out of range_ at the
+ *  first variable that does not fit.
+ *
+ *  The production is:
+ *  ```
+ *  <variable> := <letter>,{ <letter> | <digit> };
+ *  ```
+ *  \sa term()
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::variable( Context & ctx_ ) const
+{
+    const auto begin = ctx_.curr_symb;
+    const auto col = std::distance( ctx_.expr.begin(), begin );
+    next_symbol( ctx_ ); // A primeira <letter> já foi vista por term().
+    while ( not end_input( ctx_ )
+            and ( peek( ctx_, TS_LETTER ) or is_digit( ctx_, std::distance( ctx_.expr.begin(), ctx_.curr_symb ) ) ) )
+        next_symbol( ctx_ );
+
+    const std::string_view name = ctx_.expr.substr( col, std::distance( begin, ctx_.curr_symb ) );
+    value_type number = 0;
+    if ( not variable_number( ctx_, name, number ) )
+    {
+        // Variáveis demais: o número não cabe no valor do token.
+        ctx_.curr_status = ParserResult( ParserResult::INTEGER_OUT_OF_RANGE, col );
+        return;
+    }
+    ctx_.token_list.emplace_back( Token::VARIABLE, Token::NONE, number, col );
+}
+
+/*!
+ * O índice não é percorrido: basta mudar de geração, e as posições gravadas
+ * nas expressões anteriores passam a estar vazias. Só quando o contador de
+ * gerações dá a volta as posições são apagadas de fato.
+ */
+template < typename Policy >
+constexpr void BasicParser< Policy >::clear_variables( Context & ctx_ )
+{
+    ctx_.variable_names.clear();
+    if ( ++ctx_.variable_generation == 0 )
+    {
+        std::fill( ctx_.variable_slots.begin(), ctx_.variable_slots.end(), VariableSlot{} );
+        ctx_.variable_generation = 1;
+    }
+}
+
+/*!
+ * \brief Procura o nome da variável no índice do contexto, e o insere se ele for novo.
+ *
+ * O índice é uma tabela de espalhamento (FNV-1a, sondagem linear) em
+ * `ctx_.variable_slots`, mantida no máximo meio cheia: cada busca é O(1) em
+ * média, qualquer que seja o número de variáveis da fórmula. Ao crescer, a
+ * tabela dobra de tamanho e os nomes já vistos são reinseridos.
+ * (Um `std::unordered_map` não serve aqui: o contexto precisa ser usável em `constexpr`.)
+ *
+ * \param ctx_ Contexto do parsing (depois de `clear_variables()`).
+ * \param name_ Nome da variável (uma visão da expressão).
+ * \param number_ Recebe o número da variável.
+ * \return `false` se a variável é nova e o seu número não cabe no valor do token.
+ */
+template < typename Policy >
+constexpr bool BasicParser< Policy >::variable_number( Context & ctx_, std::string_view name_, value_type & number_ )
+{
+    auto & names = ctx_.variable_names;
+    auto & slots = ctx_.variable_slots;
+    const std::uint32_t generation = ctx_.variable_generation;
+
+    // Posição do nome no índice, ou a posição vazia em que ele deve entrar.
+    auto find = [&]( std::string_view n_ ) -> std::size_t
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for ( char c : n_ )
+            hash = ( hash ^ static_cast< unsigned char >( c ) ) * 1099511628211ull;
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = hash & mask;
+        while ( slots[i].generation == generation and names[ slots[i].number ] != n_ )
+            i = ( i + 1 ) & mask;
+        return i;
+    };
+
+    if ( 2 * ( names.size() + 1 ) > slots.size() )
+    {
+        slots.assign( std::max< std::size_t >( 16, 2 * slots.size() ), VariableSlot{} );
+        for ( std::size_t k( 0 ); k < names.size(); ++k )
+            slots[ find( names[k] ) ] = VariableSlot{ generation, static_cast< std::uint32_t >( k ) };
+    }
+
+    const std::size_t i = find( name_ );
+    if ( slots[i].generation == generation )
+    {
+        number_ = static_cast< value_type >( slots[i].number );
+        return true;
+    }
+    // O número da variável precisa caber no valor do token.
+    if ( names.size() > static_cast< std::size_t >( Policy::max ) )
+        return false;
+    number_ = static_cast< value_type >( names.size() );
+    slots[i] = VariableSlot{ generation, static_cast< std::uint32_t >( names.size() ) };
+    names.push_back( name_ );
+    return true;
+}
+
+// As variantes da política numérica são instanciadas uma vez só, em parser.cpp.
+extern template class BasicParser< Int16Policy >;
+extern template class BasicParser< Int32Policy >;
+extern template class BasicParser< Int64Policy >;
+extern template class BasicParser< Int128Policy >;
+
+/// Parser da política numérica do programa.
+typedef BasicParser< Numeric > Parser;
+
+#endif
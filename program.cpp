@@ -0,0 +1,170 @@
+#include "program.h"
+
+#include <cassert> // assert
+
+/*!
+ * \brief Esvazia o programa, para que ele possa receber uma nova compilação.
+ * A memória das instruções é mantida, então recompilar não aloca nada.
+ */
+void Program::clear( void )
+{
+    m_code.clear();
+    m_depth = 0;
+    m_max_depth = 0;
+    m_variables = 0;
+}
+
+/*!
+ * \brief Acrescenta a instrução correspondente a um token da expressão pósfixa.
+ * Operandos viram `OP_PUSH` com o valor imediato, variáveis viram `OP_LOAD`
+ * com o número da variável e operadores viram o *opcode* correspondente. A profundidade da pilha é acompanhada a cada instrução.
+ * \param tk_ Token pósfixo (operando ou operador).
+ */
+void Program::emit( const Token & tk_ )
+{
+    if ( tk_.type == Token::OPERAND )
+    {
+        m_code.push_back( Instruction{ OP_PUSH, tk_.value } );
+        if ( ++m_depth > m_max_depth ) m_max_depth = m_depth;
+        return;
+    }
+    if ( tk_.type == Token::VARIABLE )
+    {
+        m_code.push_back( Instruction{ OP_LOAD, tk_.value } );
+        if ( ++m_depth > m_max_depth ) m_max_depth = m_depth;
+        if ( static_cast< std::size_t >( tk_.value ) >= m_variables ) m_variables = static_cast< std::size_t >( tk_.value ) + 1;
+        return;
+    }
+
+    // Os símbolos dos operadores estão na mesma ordem dos opcodes.
+    assert( tk_.type == Token::OPERATOR );
+    assert( m_depth >= 2 );
+    m_code.push_back( Instruction{ static_cast< opcode_t >( OP_ADD + ( tk_.symbol - Token::PLUS ) ), 0 } );
+    --m_depth; // Desempilha dois operandos e empilha o resultado.
+}
+
+/// Termina o programa com `OP_HALT`.
+void Program::finish( void )
+{
+    assert( m_depth == 1 ); // Uma expressão bem formada deixa só o resultado na pilha.
+    m_code.push_back( Instruction{ OP_HALT, 0 } );
+}
+
+/*!
+ * \brief Interpretador do programa.
+ *
+ * Com GCC/Clang o despacho é feito por *computed goto*: cada instrução termina
+ * saltando diretamente para o código da próxima, por meio de uma tabela de
+ * endereços de rótulos, sem voltar a um `switch` central. Em outros
+ * compiladores o mesmo código é compilado como um `switch` dentro de um laço.
+ *
+ * As operações seguem exatamente as regras de `Evaluator::evaluate_postfix()`:
+ * a execução para no primeiro erro (divisão por zero ou overflow).
+ *
+ * \param result_ Recebe o valor da expressão (não é alterado em caso de erro).
+ * \param stack_ Pilha de trabalho, com pelo menos `max_depth()` posições.
+ * \param vars_ Valor de cada variável (pelo menos `variables()` valores).
+ * \return O resultado da avaliação.
+ */
+Evaluator::EvaluatorResult
+Program::run( result_t & result_, std::span< result_t > stack_, std::span< const Token::value_type > vars_ ) const
+{
+    assert( not m_code.empty() and m_code.back().op == OP_HALT );
+    assert( stack_.size() >= m_max_depth );
+    assert( vars_.size() >= m_variables );
+
+    Evaluator::EvaluatorResult status;
+    const Instruction * ip = m_code.data();
+    result_t * sp = stack_.data(); // Próxima posição livre da pilha.
+    result_t op1, op2, value;
+
+#if defined( __GNUC__ )
+    // A ordem da tabela deve ser a mesma de `opcode_t`.
+    static const void * const dispatch[] = {
+        &&do_OP_PUSH, &&do_OP_ADD, &&do_OP_SUB, &&do_OP_MUL,
+        &&do_OP_DIV, &&do_OP_MOD, &&do_OP_POW, &&do_OP_HALT,
+        &&do_OP_LOAD
+    };
+#   define BARES_OP( name ) do_##name
+#   define BARES_DISPATCH() goto *dispatch[ ip->op ]
+#else
+#   define BARES_OP( name ) case name
+#   define BARES_DISPATCH() continue
+#endif
+
+// Desempilha os dois operandos de um operador binário.
+#define BARES_POP2() op2 = *--sp; op1 = sp[-1]
+// Coloca o resultado no topo, se a operação verificada não transbordou, e segue para a próxima instrução.
+#define BARES_CHECKED( operation ) \
+    BARES_POP2(); \
+    if ( not Numeric::operation( op1, op2, value ) ) \
+    { \
+        status = Evaluator::EvaluatorResult( Evaluator::EvaluatorResult::RESULT_OVERFLOW ); \
+        return status; \
+    } \
+    sp[-1] = value; ++ip; BARES_DISPATCH()
+// Operadores que podem falhar por divisão por zero usam a regra do Evaluator.
+#define BARES_APPLY( symbol ) \
+    BARES_POP2(); \
+    value = Evaluator::apply_operation( op1, op2, Token( Token::OPERATOR, symbol ), status ); \
+    if ( status.type != Evaluator::EvaluatorResult::EVALUATOR_OK ) return status; \
+    sp[-1] = value; ++ip; BARES_DISPATCH()
+
+#if defined( __GNUC__ )
+    BARES_DISPATCH();
+#else
+    for ( ;; ) switch ( ip->op ) {
+#endif
+    BARES_OP( OP_PUSH ):
+        *sp++ = ip->imm;
+        ++ip;
+        BARES_DISPATCH();
+    BARES_OP( OP_LOAD ):
+        *sp++ = vars_[ ip->imm ];
+        ++ip;
+        BARES_DISPATCH();
+    BARES_OP( OP_ADD ):
+        BARES_CHECKED( add );
+    BARES_OP( OP_SUB ):
+        BARES_CHECKED( sub );
+    BARES_OP( OP_MUL ):
+        BARES_CHECKED( mul );
+    BARES_OP( OP_DIV ):
+        BARES_APPLY( Token::DIVIDED );
+    BARES_OP( OP_MOD ):
+        BARES_APPLY( Token::MOD );
+    BARES_OP( OP_POW ):
+        BARES_CHECKED( power );
+    BARES_OP( OP_HALT ):
+        result_ = sp[-1];
+        return status;
+#if not defined( __GNUC__ )
+    }
+#endif
+
+#undef BARES_APPLY
+#undef BARES_CHECKED
+#undef BARES_POP2
+#undef BARES_DISPATCH
+#undef BARES_OP
+}
+
+/*!
+ * \brief Executa o programa com uma pilha própria.
+ * Expressões comuns cabem em uma pilha local; só programas muito profundos
+ * (longas cadeias de "^") precisam de uma pilha alocada.
+ * \param result_ Recebe o valor da expressão (não é alterado em caso de erro).
+ * \return O resultado da avaliação.
+ */
+Evaluator::EvaluatorResult
+Program::run( result_t & result_ ) const
+{
+    const std::size_t LOCAL_DEPTH = 64;
+    if ( m_max_depth <= LOCAL_DEPTH )
+    {
+        result_t stack[ LOCAL_DEPTH ];
+        return run( result_, std::span< result_t >( stack, LOCAL_DEPTH ) );
+    }
+    std::vector< result_t > stack( m_max_depth );
+    return run( result_, stack );
+}
@@ -0,0 +1,80 @@
+#ifndef _PROGRAM_H_
+#define _PROGRAM_H_
+
+#include <cstdint>   // std::uint8_t
+#include <vector>    // std::vector
+#include <span>      // std::span
+
+#include "token.h"
+#include "evaluator.h" // Evaluator::result_t, Evaluator::EvaluatorResult
+
+/*!
+ * Programa compilado a partir de uma expressão pósfixa.
+ *
+ * O programa é uma sequência plana de instruções, cada uma com um *opcode* e
+ * um imediato do tipo `Token::value_type` (a largura vem da política
+ * numérica): `PUSH` (empilha um valor imediato), `LOAD` (empilha o valor de
+ * uma variável, numa fórmula) e um *opcode* para cada operador binário. A profundidade
+ * máxima da pilha é calculada durante a compilação, então a execução usa uma
+ * pilha de tamanho fixo, sem nenhuma alocação.
+ *
+ * Um programa não depende da expressão nem dos tokens que o geraram: ele pode
+ * ser guardado e executado quantas vezes for preciso (inclusive por várias
+ * threads ao mesmo tempo, já que `run()` não altera o programa).
+ *
+ * \sa Evaluator::compile()
+ */
+class Program
+{
+    public:
+        typedef Evaluator::result_t result_t;
+
+        /// Códigos das instruções.
+        enum opcode_t : std::uint8_t
+        {
+            OP_PUSH = 0, //<! Empilha o valor imediato.
+            OP_ADD,      //<! "+"
+            OP_SUB,      //<! "-"
+            OP_MUL,      //<! "*"
+            OP_DIV,      //<! "/"
+            OP_MOD,      //<! "%"
+            OP_POW,      //<! "^"
+            OP_HALT,     //<! Fim do programa: o resultado está no topo da pilha.
+            OP_LOAD      //<! Empilha o valor da variável de número `imm`.
+        };
+
+        /// Uma instrução: o código e o valor imediato (o valor de `OP_PUSH` ou o número da variável de `OP_LOAD`).
+        struct Instruction
+        {
+            opcode_t op;           //<! Código da instrução.
+            Token::value_type imm; //<! Valor imediato (ignorado pelos operadores e por `OP_HALT`).
+        };
+
+        /// Esvazia o programa, mantendo a memória já alocada.
+        void clear( void );
+        /// Acrescenta a instrução correspondente a um token pósfixo (operando, variável ou operador).
+        void emit( const Token & );
+        /// Acrescenta `OP_HALT`; depois disso o programa está pronto para ser executado.
+        void finish( void );
+
+        /// Executa o programa usando a pilha indicada (com pelo menos `max_depth()` posições) e os valores `vars_` das variáveis.
+        Evaluator::EvaluatorResult run( result_t & result_, std::span< result_t > stack_,
+                                        std::span< const Token::value_type > vars_ = {} ) const;
+        /// Executa o programa (sem variáveis) usando uma pilha própria.
+        Evaluator::EvaluatorResult run( result_t & result_ ) const;
+
+        /// Profundidade máxima que a pilha atinge durante a execução.
+        std::size_t max_depth( void ) const { return m_max_depth; }
+        /// Quantidade de variáveis (uma a mais que o maior número de variável usado).
+        std::size_t variables( void ) const { return m_variables; }
+        /// As instruções do programa.
+        const std::vector< Instruction > & code( void ) const { return m_code; }
+
+    private:
+        std::vector< Instruction > m_code; //<! Instruções, terminadas por `OP_HALT`.
+        std::size_t m_depth = 0;           //<! Profundidade da pilha depois da última instrução emitida.
+        std::size_t m_max_depth = 0;       //<! Maior profundidade atingida.
+        std::size_t m_variables = 0;       //<! Variáveis usadas pelo programa.
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "result_cache.h"
+
+#include <algorithm> // std::lower_bound
+#include <cstring>   // std::memcpy, std::memset
+
+#if defined( __SSE2__ )
+#include <emmintrin.h> // _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+namespace {
+    /// Classe de cada byte na passada canônica.
+    enum char_class_t : unsigned char { K_OTHER = 0, K_WORD, K_MINUS, K_CLOSE, K_WS };
+    /// Bits do estado: o último token (número ou nome, fim de operando, "-" de sinal) e se o byte anterior é ws.
+    enum state_bit_t : unsigned char { S_WORD = 1, S_OPERAND = 2, S_SIGN = 4, S_WS = 8 };
+    /// Bits de cada transição, acima dos 4 bits do novo estado.
+    enum step_bit_t : unsigned char { T_SEP = 16, T_TOKEN = 32, T_WS_BEGIN = 64 };
+
+    /// Classes dos bytes e a tabela de transições [estado * 8 + classe], montadas das regras da forma canônica.
+    struct ScanTable
+    {
+        unsigned char cls[ 256 ] = {};
+        unsigned char step[ 16 * 8 ] = {};
+        constexpr ScanTable()
+        {
+            for ( char c = '0'; c <= '9'; ++c ) cls[ static_cast< unsigned char >( c ) ] = K_WORD;
+            for ( char c = 'a'; c <= 'z'; ++c ) cls[ static_cast< unsigned char >( c ) ] = K_WORD;
+            for ( char c = 'A'; c <= 'Z'; ++c ) cls[ static_cast< unsigned char >( c ) ] = K_WORD;
+            cls[ static_cast< unsigned char >( '_' ) ] = K_WORD;
+            cls[ static_cast< unsigned char >( '-' ) ] = K_MINUS;
+            cls[ static_cast< unsigned char >( ')' ) ] = K_CLOSE;
+            cls[ static_cast< unsigned char >( ' ' ) ] = K_WS;
+            cls[ static_cast< unsigned char >( '\t' ) ] = K_WS;
+
+            for ( unsigned s( 0 ); s < 16; ++s )
+                for ( unsigned k( K_OTHER ); k <= K_WS; ++k )
+                {
+                    unsigned t;
+                    if ( k == K_WS )
+                        // Os ws não mudam o último token.
+                        t = s | S_WS | ( s & S_WS ? 0 : T_WS_BEGIN );
+                    else
+                    {
+                        // Os ws só ficam se, sem eles, os dois tokens seriam lidos de outra forma.
+                        const bool word = k == K_WORD;
+                        const bool sep = ( s & S_WS ) and ( ( ( s & S_WORD ) and word ) or ( s & S_SIGN ) );
+                        t = T_TOKEN | ( sep ? T_SEP : 0 ) | ( word ? S_WORD : 0 )
+                          | ( word or k == K_CLOSE ? S_OPERAND : 0 )
+                          | ( k == K_MINUS and not ( s & S_OPERAND ) ? S_SIGN : 0 );
+                    }
+                    step[ s * 8 + k ] = static_cast< unsigned char >( t );
+                }
+        }
+    };
+    constexpr ScanTable SCAN_TABLE;
+
+    /*!
+     * \brief Passada léxica que produz a forma canônica (a chave) de uma linha longa.
+     *
+     * O laço não tem desvios: cada byte dá um passo na tabela de transições
+     * (estado e classe do byte), é escrito em `out_[n]`, e `n` só avança se o
+     * byte fica (o mesmo para o separador). Com `COLUMNS`, `cols_[k]` recebe a
+     * coluna original da posição canônica `k` (no caso de um separador, a
+     * coluna do primeiro ws da sequência). `out_` e `cols_` precisam de
+     * `line_.size() + 1` posições.
+     *
+     * \return O tamanho da forma canônica.
+     */
+    template < bool COLUMNS >
+    std::size_t scan_long( std::string_view line_, char * out_, std::uint32_t * cols_ )
+    {
+        std::size_t n = 0;
+        unsigned state = 0;
+        std::size_t ws_begin = 0; // Coluna do primeiro ws da sequência atual.
+        for ( std::size_t i( 0 ); i < line_.size(); ++i )
+        {
+            const char c = line_[i];
+            const unsigned t = SCAN_TABLE.step[ state * 8 + SCAN_TABLE.cls[ static_cast< unsigned char >( c ) ] ];
+            if constexpr ( COLUMNS )
+                ws_begin = ( t & T_WS_BEGIN ) ? i : ws_begin;
+            out_[ n ] = ' ';
+            if constexpr ( COLUMNS ) cols_[ n ] = static_cast< std::uint32_t >( ws_begin );
+            n += ( t / T_SEP ) & 1;
+            out_[ n ] = c;
+            if constexpr ( COLUMNS ) cols_[ n ] = static_cast< std::uint32_t >( i );
+            n += ( t / T_TOKEN ) & 1;
+            state = t & 15;
+        }
+        // Depois de um sinal, o erro aponta para o que vem a seguir, mesmo que sejam só ws.
+        if ( ( state & ( S_WS | S_SIGN ) ) == ( S_WS | S_SIGN ) )
+        {
+            out_[ n ] = ' ';
+            if constexpr ( COLUMNS ) cols_[ n ] = static_cast< std::uint32_t >( ws_begin );
+            ++n;
+        }
+        return n;
+    }
+
+    /// Linhas com até `SHORT_LINE` bytes são classificadas em máscaras de 64 bits; as mais longas usam a tabela de transições.
+    const std::size_t SHORT_LINE = 63;
+
+    /// Máscaras de uma linha curta (um bit por byte).
+    struct LineMasks
+    {
+        std::uint64_t ws = 0;    //<! Espaços e tabs.
+        std::uint64_t word = 0;  //<! Dígitos, letras e '_'.
+        std::uint64_t minus = 0; //<! '-'.
+        std::uint64_t close = 0; //<! ')'.
+    };
+
+    /// Classifica os bytes de `block_` (uma linha curta, completada com zeros) e troca os tabs por espaços.
+    LineMasks classify( char * block_ )
+    {
+        LineMasks m;
+#if defined( __SSE2__ )
+        for ( unsigned i( 0 ); i < 64; i += 16 )
+        {
+            const __m128i x = _mm_loadu_si128( reinterpret_cast< const __m128i * >( block_ + i ) );
+            // Os bytes >= 0x80 são negativos na comparação com sinal, então não passam pelos intervalos.
+            const __m128i lower = _mm_or_si128( x, _mm_set1_epi8( 0x20 ) );
+            const __m128i word = _mm_or_si128(
+                    _mm_or_si128( _mm_and_si128( _mm_cmpgt_epi8( x, _mm_set1_epi8( '0' - 1 ) ), _mm_cmplt_epi8( x, _mm_set1_epi8( '9' + 1 ) ) ),
+                                  _mm_and_si128( _mm_cmpgt_epi8( lower, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmplt_epi8( lower, _mm_set1_epi8( 'z' + 1 ) ) ) ),
+                    _mm_cmpeq_epi8( x, _mm_set1_epi8( '_' ) ) );
+            const __m128i tab = _mm_cmpeq_epi8( x, _mm_set1_epi8( '\t' ) );
+            const __m128i ws = _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( ' ' ) ), tab );
+            // Os tabs viram espaços: um ws que fica é sempre um ' '.
+            _mm_storeu_si128( reinterpret_cast< __m128i * >( block_ + i ), _mm_xor_si128( x, _mm_and_si128( tab, _mm_set1_epi8( '\t' ^ ' ' ) ) ) );
+
+            m.ws |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( ws ) ) ) << i;
+            m.word |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( word ) ) ) << i;
+            m.minus |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( _mm_cmpeq_epi8( x, _mm_set1_epi8( '-' ) ) ) ) ) << i;
+            m.close |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( _mm_cmpeq_epi8( x, _mm_set1_epi8( ')' ) ) ) ) ) << i;
+        }
+#else
+        for ( unsigned i( 0 ); i < 64; ++i )
+        {
+            const unsigned k = SCAN_TABLE.cls[ static_cast< unsigned char >( block_[i] ) ];
+            if ( k == K_WS ) block_[i] = ' '; // Os tabs viram espaços: um ws que fica é sempre um ' '.
+            m.ws |= std::uint64_t( k == K_WS ) << i;
+            m.word |= std::uint64_t( k == K_WORD ) << i;
+            m.minus |= std::uint64_t( k == K_MINUS ) << i;
+            m.close |= std::uint64_t( k == K_CLOSE ) << i;
+        }
+#endif
+        return m;
+    }
+
+    /// Para cada sequência de ws que começa num bit de `starts_`, o bit logo depois dela (o vai-um atravessa a sequência).
+    std::uint64_t after_runs( std::uint64_t ws_, std::uint64_t starts_ )
+    {
+        return ( ws_ + starts_ ) & ~ws_;
+    }
+
+    /// Coluna original do byte `j_` de uma linha curta: um separador fica na coluna do primeiro ws da sequência.
+    std::size_t short_column( std::uint64_t keep_, std::uint64_t sep_, unsigned j_ )
+    {
+        if ( not ( ( sep_ >> j_ ) & 1 ) ) return j_;
+        // Antes de um separador sempre há um token.
+        return 64 - __builtin_clzll( keep_ & ~sep_ & ( ( std::uint64_t( 1 ) << j_ ) - 1 ) );
+    }
+
+    /*!
+     * \brief A mesma passada de `scan_long()`, para uma linha curta, com as máscaras de bits.
+     *
+     * O token anterior a cada byte, pulando os ws, vem das máscaras deslocadas
+     * de um bit e levadas até o fim de cada sequência de ws por `after_runs()`.
+     * Com isso saem os "-" de sinal (os que não vêm depois de um fim de
+     * operando) e as sequências de ws que viram um separador. O separador
+     * toma o lugar do último ws da sequência, então a forma canônica é só a
+     * linha sem os outros ws: os bytes que ficam são copiados um a um,
+     * percorrendo os bits. As máscaras desses bytes (`keep_`) e dos
+     * separadores (`sep_`) bastam para achar depois a coluna de uma posição
+     * canônica (`short_column()`).
+     */
+    template < bool COLUMNS >
+    std::size_t scan_short( std::string_view line_, char * out_, std::uint32_t * cols_, std::uint64_t & keep_, std::uint64_t & sep_ )
+    {
+        char block[ 64 ] = {};
+        std::memcpy( block, line_.data(), line_.size() );
+        const LineMasks m = classify( block );
+
+        const std::uint64_t operand = m.word | m.close;
+        const std::uint64_t after_operand = ( operand << 1 ) | after_runs( m.ws, ( operand << 1 ) & m.ws );
+        const std::uint64_t sign = m.minus & ~after_operand;
+        // Os ws só ficam se, sem eles, os dois tokens seriam lidos de outra forma. O
+        // separador fica no lugar do último ws da sequência (o bit seguinte pode ser o fim da linha).
+        const std::uint64_t sep = ( ( after_runs( m.ws, ( m.word << 1 ) & m.ws ) & m.word )
+                                  | after_runs( m.ws, ( sign << 1 ) & m.ws ) ) >> 1;
+        const std::uint64_t keep = ( ~m.ws & ( ( std::uint64_t( 1 ) << line_.size() ) - 1 ) ) | sep;
+        keep_ = keep;
+        sep_ = sep;
+
+        std::size_t n = 0;
+        for ( std::uint64_t bits = keep; bits != 0; bits &= bits - 1 )
+        {
+            const unsigned j = __builtin_ctzll( bits );
+            out_[ n ] = block[ j ];
+            if constexpr ( COLUMNS ) cols_[ n ] = static_cast< std::uint32_t >( short_column( keep, sep, j ) );
+            ++n;
+        }
+        return n;
+    }
+
+    /*!
+     * \brief Coluna original da posição canônica `pos_` de uma linha curta de `size_` bytes.
+     * `keep_` e `sep_` são as máscaras de `scan_short()`; a posição depois da última é o fim da linha.
+     */
+    std::size_t short_position_column( std::uint64_t keep_, std::uint64_t sep_, std::size_t pos_, std::size_t size_ )
+    {
+        std::uint64_t rest = keep_;
+        for ( ; pos_ > 0 and rest != 0; --pos_ ) rest &= rest - 1;
+        return rest != 0 ? short_column( keep_, sep_, __builtin_ctzll( rest ) ) : size_;
+    }
+
+    /*!
+     * \brief Passada léxica que produz a forma canônica (a chave) da linha.
+     *
+     * A linha é lida como uma sequência de tokens: números e nomes (sequências
+     * de dígitos, letras e '_') e símbolos de um caractere. Os ws entre os
+     * tokens são descartados, exceto onde separam dois tokens que, juntos,
+     * seriam lidos de outra forma: dois números ou nomes (`1 2` não é `12`) e
+     * um "-" de sinal e o que vem depois dele (`- 3` é um erro, `-3` é um
+     * literal). Nesses casos a sequência de ws vira um único ' '. Assim
+     * `12 +  3` e `12+3` têm a mesma chave.
+     *
+     * Uma linha de até `SHORT_LINE` bytes vai para `scan_short()`; as demais,
+     * para `scan_long()`. Com `COLUMNS`, `cols_[k]` recebe a coluna original da
+     * posição canônica `k` (no caso de um separador, a coluna do primeiro ws da
+     * sequência). `out_` e `cols_` precisam de `line_.size() + 1` posições.
+     * Só para as linhas curtas, `keep_` e `sep_` recebem as máscaras de `scan_short()`.
+     *
+     * \return O tamanho da forma canônica.
+     */
+    template < bool COLUMNS >
+    std::size_t canonical_scan( std::string_view line_, char * out_, std::uint32_t * cols_, std::uint64_t & keep_, std::uint64_t & sep_ )
+    {
+        return line_.size() <= SHORT_LINE ? scan_short< COLUMNS >( line_, out_, cols_, keep_, sep_ )
+                                          : scan_long< COLUMNS >( line_, out_, cols_ );
+    }
+
+    /// Mistura os bits de `x_` (multiplicação e *xorshift*).
+    std::uint64_t mix( std::uint64_t x_ )
+    {
+        x_ *= 0x9E3779B97F4A7C15ull;
+        return x_ ^ ( x_ >> 32 );
+    }
+
+    /// Hash de `n_` bytes, 8 por vez; `p_` precisa de 8 bytes zerados depois do fim.
+    std::uint64_t hash_bytes( const char * p_, std::size_t n_ )
+    {
+        std::uint64_t h = n_;
+        for ( std::size_t i( 0 ); i < n_; i += 8 )
+        {
+            std::uint64_t word;
+            std::memcpy( &word, p_ + i, 8 );
+            h = mix( h ^ word );
+        }
+        return mix( h );
+    }
+}
+
+/*!
+ * \param capacity_ Número máximo de entradas (pelo menos uma).
+ */
+ResultCache::ResultCache( std::size_t capacity_ )
+    : m_capacity( capacity_ > 0 ? capacity_ : 1 )
+{
+    m_index.reserve( m_capacity );
+}
+
+/*!
+ * \brief Monta a forma canônica de `m_line` em `m_canonical` e, com `columns_`, as colunas originais em `m_offsets`.
+ * Os buffers só crescem: depois das primeiras linhas, nada é alocado.
+ */
+void ResultCache::canonicalize( bool columns_ )
+{
+    // Mais 8 bytes zerados depois da forma canônica, para o hash.
+    const std::size_t room = m_line.size() + 1;
+    if ( m_canonical.size() < room + 8 ) m_canonical.resize( room + 8 );
+    if ( not columns_ )
+        m_length = canonical_scan< false >( m_line, m_canonical.data(), nullptr, m_keep, m_sep );
+    else
+    {
+        // Mais uma posição para o fim da linha.
+        if ( m_offsets.size() < room + 1 ) m_offsets.resize( room + 1 );
+        m_length = canonical_scan< true >( m_line, m_canonical.data(), m_offsets.data(), m_keep, m_sep );
+        m_offsets[ m_length ] = static_cast< std::uint32_t >( m_line.size() );
+    }
+    std::memset( m_canonical.data() + m_length, 0, 8 );
+}
+
+/*!
+ * \brief Procura a linha no cache.
+ *
+ * Uma passada sem desvios monta a forma canônica num buffer reaproveitado, e
+ * o hash é calculado sobre ela, 8 bytes por vez. Só quando o hash é
+ * encontrado a forma canônica é comparada com a guardada; a coluna da linha
+ * só é calculada se o resultado guardado é um erro de parsing (numa linha
+ * curta, direto das máscaras da passada).
+ *
+ * Em caso de acerto, a entrada passa a ser a mais recente, e a coluna do erro
+ * de parsing (se houver) é convertida para a coluna correspondente na linha.
+ *
+ * \param line_ A expressão (sem o '\n').
+ * \param result_ Recebe o resultado, em caso de acerto.
+ * \return `true` se a linha estava no cache.
+ */
+bool ResultCache::lookup( std::string_view line_, LineResult & result_ )
+{
+    m_line = line_;
+    canonicalize( false );
+    m_hash = hash_bytes( m_canonical.data(), m_length );
+
+    auto it = m_index.find( m_hash );
+    if ( it == m_index.end() or it->second->canonical != std::string_view( m_canonical.data(), m_length ) )
+    {
+        ++m_stats.misses;
+        return false;
+    }
+
+    // Move a entrada para o início da lista (mais recente).
+    m_lru.splice( m_lru.begin(), m_lru, it->second );
+    ++m_stats.hits;
+
+    result_ = it->second->result;
+    if ( result_.parser_result.type != Parser::ParserResult::PARSER_OK )
+    {
+        if ( line_.size() <= SHORT_LINE )
+            result_.parser_result.at_col = short_position_column( m_keep, m_sep, result_.parser_result.at_col, line_.size() );
+        else
+        {
+            canonicalize( true );
+            result_.parser_result.at_col = m_offsets[ result_.parser_result.at_col ];
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Guarda o resultado da linha procurada pela última chamada de `lookup()`.
+ *
+ * A linha passada a `lookup()` ainda deve ser válida. Se o cache estiver
+ * cheio, a entrada usada há mais tempo é descartada. Um hash já existente
+ * (colisão entre formas canônicas diferentes) é substituído pela linha atual.
+ *
+ * \param result_ O resultado da linha, com as colunas da linha original.
+ */
+void ResultCache::insert( const LineResult & result_ )
+{
+    Entry entry{ m_hash, std::string( m_canonical.data(), m_length ), result_ };
+
+    if ( result_.parser_result.type != Parser::ParserResult::PARSER_OK )
+    {
+        // Converte a coluna original para a posição canônica correspondente.
+        canonicalize( true );
+        const auto end = m_offsets.begin() + m_length + 1;
+        auto col = static_cast< std::uint32_t >( result_.parser_result.at_col );
+        auto pos = std::lower_bound( m_offsets.begin(), end, col );
+        if ( pos == end or *pos != col )
+            return; // Coluna que não corresponde a um símbolo: não dá para remapear.
+        entry.result.parser_result.at_col = std::distance( m_offsets.begin(), pos );
+    }
+
+    auto it = m_index.find( m_hash );
+    if ( it != m_index.end() )
+    {
+        *it->second = std::move( entry );
+        m_lru.splice( m_lru.begin(), m_lru, it->second );
+        return;
+    }
+
+    if ( m_index.size() == m_capacity )
+    {
+        // Descarta a entrada menos recente, reaproveitando o nó da lista.
+        auto last = std::prev( m_lru.end() );
+        m_index.erase( last->hash );
+        *last = std::move( entry );
+        m_lru.splice( m_lru.begin(), m_lru, last );
+        ++m_stats.evictions;
+    }
+    else
+    {
+        m_lru.push_front( std::move( entry ) );
+    }
+    m_index.emplace( m_hash, m_lru.begin() );
+}
@@ -0,0 +1,90 @@
+#ifndef _RESULT_CACHE_H_
+#define _RESULT_CACHE_H_
+
+#include <cstdint>       // std::uint64_t, std::uint32_t
+#include <string>        // std::string
+#include <string_view>   // std::string_view
+#include <vector>        // std::vector
+#include <list>          // std::list
+#include <unordered_map> // std::unordered_map
+
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Cache LRU (limitado) de resultados de linhas.
+ *
+ * A chave é a forma **canônica** da linha, montada a partir dos tokens: os ws
+ * (espaços ou tabs) entre os tokens são descartados, exceto onde separam dois
+ * tokens que, juntos, seriam lidos de outra forma (dois números ou nomes, ou
+ * um "-" de sinal e o que vem depois dele), e aí viram um único separador.
+ * Como a gramática só depende dos tokens, duas linhas com a mesma forma
+ * canônica (por exemplo, `"12 +  3"` e `"12+3"`) têm o mesmo resultado, a
+ * menos da coluna dos erros. Por isso a coluna de um erro de parsing é
+ * guardada como uma posição na forma canônica e é reconvertida para a coluna
+ * da linha atual em cada acerto.
+ *
+ * A forma canônica vem de uma passada própria do cache, mais simples que o
+ * parser (só separa números e nomes dos símbolos): `lookup()` a monta num
+ * buffer reaproveitado, sem alocar, com máscaras SSE2 nas linhas de até 63
+ * bytes, e calcula o hash sobre ela. A forma canônica só é comparada com a
+ * guardada quando o hash é encontrado, e a coluna da linha só é calculada
+ * para converter a coluna de um erro. `lookup()` deve sempre preceder
+ * `insert()` para a mesma linha, que deve continuar válida até lá.
+ */
+class ResultCache
+{
+    public:
+        /// Contadores de uso, para dimensionar o cache.
+        struct Stats
+        {
+            std::uint64_t hits = 0;      //<! Linhas encontradas no cache.
+            std::uint64_t misses = 0;    //<! Linhas que precisaram ser avaliadas.
+            std::uint64_t evictions = 0; //<! Entradas descartadas por falta de espaço.
+        };
+
+        /// Procura a linha no cache; se encontrar, preenche `result_` com as colunas da linha.
+        bool lookup( std::string_view line_, LineResult & result_ );
+        /// Guarda o resultado da última linha procurada com `lookup()`.
+        void insert( const LineResult & result_ );
+
+        /// Contadores de uso.
+        const Stats & stats( void ) const { return m_stats; }
+        /// Número de entradas no cache.
+        std::size_t size( void ) const { return m_index.size(); }
+
+        /// Cria um cache com, no máximo, `capacity_` entradas.
+        explicit ResultCache( std::size_t capacity_ );
+        ~ResultCache() = default;
+        /// Desligar cópia e atribuição.
+        ResultCache( const ResultCache & ) = delete;
+        ResultCache & operator=( const ResultCache & ) = delete;
+
+    private:
+        /// Uma entrada do cache: a forma canônica (para confirmar o hash) e o resultado.
+        struct Entry
+        {
+            std::uint64_t hash;     //<! Hash da forma canônica.
+            std::string canonical;  //<! Forma canônica da linha.
+            LineResult result;      //<! Resultado, com a coluna de erro na forma canônica.
+        };
+        typedef std::list< Entry > lru_list_t; // Da entrada usada mais recentemente para a menos recente.
+
+        std::size_t m_capacity;                                          //<! Número máximo de entradas.
+        lru_list_t m_lru;                                                //<! Entradas, em ordem de uso.
+        std::unordered_map< std::uint64_t, lru_list_t::iterator > m_index; //<! Hash -> entrada.
+        Stats m_stats;                                                   //<! Contadores de uso.
+
+        // Última linha procurada e a sua forma canônica (buffers que só crescem).
+        std::string_view m_line;                 //<! Última linha procurada.
+        std::uint64_t m_hash = 0;                //<! Hash da forma canônica.
+        std::string m_canonical;                 //<! Forma canônica (os primeiros `m_length` bytes).
+        std::size_t m_length = 0;                //<! Tamanho da forma canônica.
+        std::vector< std::uint32_t > m_offsets;  //<! Coluna original de cada posição canônica (e do fim), quando calculadas.
+        std::uint64_t m_keep = 0;                //<! Linha curta: bits dos bytes que ficam na forma canônica.
+        std::uint64_t m_sep = 0;                 //<! Linha curta: bits dos ws que viram separador.
+
+        /// Monta a forma canônica de `m_line` (e, com `columns_`, as colunas originais).
+        void canonicalize( bool columns_ );
+};
+
+#endif
@@ -0,0 +1,523 @@
+#include <algorithm>    // std::find
+#include <cerrno>       // errno
+#include <cstring>      // std::memchr, std::strlen, std::strcpy
+#include <iostream>     // std::cerr
+
+#include <unistd.h>     // ::read, ::write, ::close, ::unlink
+#include <sys/socket.h> // ::socket, ::bind, ::accept4, ::send
+#include <sys/un.h>     // sockaddr_un
+#include <sys/epoll.h>  // ::epoll_create1, ::epoll_ctl, ::epoll_wait
+#include <sys/eventfd.h> // ::eventfd
+
+#include "server.h"
+#include "output.h"
+#include "stats.h"
+
+namespace {
+    /// Número máximo de linhas em um bloco.
+    const std::size_t JOB_LINES = 1024;
+    /// Tamanho máximo (aproximado) de um bloco, em bytes.
+    const std::size_t JOB_BYTES = 256 * 1024;
+    /// Blocos em andamento por conexão.
+    const std::size_t JOBS_PER_CONNECTION = 4;
+    /// Blocos na fila (ou sendo avaliados) por worker.
+    const std::size_t JOBS_PER_WORKER = 4;
+    /// Respostas não enviadas a partir das quais a conexão deixa de ser lida.
+    const std::size_t OUTPUT_BYTES = 1024 * 1024;
+    /// Tamanho de cada leitura do socket.
+    const std::size_t READ_BYTES = 64 * 1024;
+    /// Leituras por evento (para que um cliente não monopolize o laço).
+    const int READS_PER_EVENT = 4;
+    /// Tamanho máximo de uma linha; um cliente que passa disso é desconectado.
+    const std::size_t MAX_LINE_BYTES = 64 * 1024 * 1024;
+    /// Eventos tratados por chamada de `epoll_wait()`.
+    const int MAX_EVENTS = 64;
+
+    /// Registra (ou altera) os eventos de `fd_` no `epoll`, com `ptr_` como identificação.
+    bool watch( int epoll_fd_, int op_, int fd_, std::uint32_t events_, void * ptr_ )
+    {
+        epoll_event ev{};
+        ev.events = events_;
+        ev.data.ptr = ptr_;
+        return ::epoll_ctl( epoll_fd_, op_, fd_, &ev ) == 0;
+    }
+}
+
+/*!
+ * \param n_workers_ Número de workers (pelo menos um).
+ * \param mode_ Modo de avaliação dos workers.
+ * \param cache_size_ Tamanho do cache de cada worker (zero: sem cache).
+ */
+Server::Server( std::size_t n_workers_, LineEvaluator::mode_t mode_, std::size_t cache_size_ )
+{
+    if ( n_workers_ == 0 ) n_workers_ = 1;
+    m_max_queued = JOBS_PER_WORKER * n_workers_;
+
+    for ( std::size_t i( 0 ); i < n_workers_; ++i )
+    {
+        m_workers.emplace_back( new Worker( mode_ ) );
+        if ( cache_size_ > 0 ) m_workers.back()->cache.reset( new ResultCache( cache_size_ ) );
+    }
+    for ( std::size_t i( 0 ); i < n_workers_; ++i )
+        m_workers[i]->thread = std::thread( &Server::work, this, i );
+}
+
+Server::~Server()
+{
+    {
+        // Os blocos que ainda estão na fila não serão respondidos.
+        std::lock_guard< std::mutex > lock( m_work_mtx );
+        m_queue.clear();
+        m_stop_workers = true;
+    }
+    m_work_cv.notify_all();
+    for ( auto & w : m_workers )
+        w->thread.join();
+
+    for ( auto & entry : m_connections )
+        if ( entry.second->fd >= 0 ) ::close( entry.second->fd );
+    if ( m_listen_fd >= 0 ) ::close( m_listen_fd );
+    if ( m_epoll_fd >= 0 ) ::close( m_epoll_fd );
+    if ( m_wake_fd >= 0 ) ::close( m_wake_fd );
+}
+
+/*!
+ * \brief Cria o socket, o `epoll` e o `eventfd` do laço de eventos.
+ * Se já existe um socket em `path_` e ninguém o atende (sobra de um servidor
+ * que terminou sem removê-lo), ele é substituído; se outro servidor está
+ * usando o caminho, o erro é `EADDRINUSE`.
+ * \param path_ Caminho do socket no sistema de arquivos.
+ * \return `true` se o servidor está pronto para `run()`; caso contrário, `errno` indica o erro.
+ */
+bool Server::listen( const char * path_ )
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if ( std::strlen( path_ ) >= sizeof( addr.sun_path ) )
+    {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    std::strcpy( addr.sun_path, path_ );
+    const auto addr_ptr = reinterpret_cast< const sockaddr * >( &addr );
+
+    m_epoll_fd = ::epoll_create1( EPOLL_CLOEXEC );
+    m_wake_fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    m_listen_fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if ( m_epoll_fd < 0 or m_wake_fd < 0 or m_listen_fd < 0 )
+        return false;
+
+    if ( ::bind( m_listen_fd, addr_ptr, sizeof( addr ) ) != 0 )
+    {
+        if ( errno != EADDRINUSE ) return false;
+        // Alguém atende nesse caminho?
+        const int probe = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        const bool stale = probe >= 0 and ::connect( probe, addr_ptr, sizeof( addr ) ) != 0 and errno == ECONNREFUSED;
+        if ( probe >= 0 ) ::close( probe );
+        if ( not stale )
+        {
+            errno = EADDRINUSE;
+            return false;
+        }
+        if ( ::unlink( path_ ) != 0 or ::bind( m_listen_fd, addr_ptr, sizeof( addr ) ) != 0 )
+            return false;
+    }
+    m_path = path_;
+
+    if ( ::listen( m_listen_fd, SOMAXCONN ) != 0
+         or not watch( m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, EPOLLIN, &m_listen_fd )
+         or not watch( m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, EPOLLIN, &m_wake_fd ) )
+        return false;
+    return true;
+}
+
+/// Pede o fim de `run()`: só usa operações seguras em um tratador de sinal.
+void Server::stop( void )
+{
+    m_stopping = true;
+    if ( m_wake_fd >= 0 )
+    {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write( m_wake_fd, &one, sizeof( one ) );
+    }
+}
+
+/*!
+ * \brief Laço de eventos: aceita conexões, lê pedidos, recolhe os blocos prontos e envia as respostas.
+ *
+ * Cada evento identifica o descritor pelo ponteiro guardado no `epoll`: o
+ * endereço de `m_listen_fd`, o de `m_wake_fd` ou a `Connection`. Conexões
+ * fechadas durante uma rodada de eventos só são liberadas ao fim da rodada,
+ * pois ainda podem aparecer nos eventos seguintes.
+ */
+void Server::run( void )
+{
+    epoll_event events[ MAX_EVENTS ];
+    while ( not m_stopping )
+    {
+        const int n = ::epoll_wait( m_epoll_fd, events, MAX_EVENTS, -1 );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            std::cerr << "epoll_wait: " << std::strerror( errno ) << "\n";
+            break;
+        }
+        for ( int i( 0 ); i < n; ++i )
+        {
+            void * ptr = events[i].data.ptr;
+            if ( ptr == &m_listen_fd )
+                accept_all();
+            else if ( ptr == &m_wake_fd )
+            {
+                std::uint64_t count;
+                [[maybe_unused]] auto r = ::read( m_wake_fd, &count, sizeof( count ) );
+                collect();
+            }
+            else
+            {
+                Connection & conn = *static_cast< Connection * >( ptr );
+                if ( conn.fd < 0 ) continue; // Fechada nesta mesma rodada.
+                // O cliente fechou a conexão inteira (ou ela falhou): ninguém vai ler as respostas.
+                if ( events[i].events & ( EPOLLHUP | EPOLLERR ) and not ( events[i].events & EPOLLIN ) )
+                {
+                    close( conn );
+                    continue;
+                }
+                if ( events[i].events & EPOLLIN ) receive( conn );
+                if ( conn.fd >= 0 and events[i].events & EPOLLOUT ) flush( conn );
+                if ( conn.fd >= 0 ) update( conn );
+            }
+        }
+        for ( auto conn : m_dead )
+            m_connections.erase( conn );
+        m_dead.clear();
+    }
+
+    // Não aceita mais conexões; as abertas são fechadas pelo destrutor.
+    if ( m_listen_fd >= 0 ) ::close( m_listen_fd );
+    m_listen_fd = -1;
+    if ( not m_path.empty() ) ::unlink( m_path.c_str() );
+}
+
+/// Soma os contadores dos caches de todos os workers.
+ResultCache::Stats Server::cache_stats( void ) const
+{
+    ResultCache::Stats total;
+    for ( const auto & w : m_workers )
+    {
+        if ( not w->cache ) continue;
+        total.hits += w->cache->stats().hits;
+        total.misses += w->cache->stats().misses;
+        total.evictions += w->cache->stats().evictions;
+    }
+    return total;
+}
+
+/// Laço de um worker: avalia os blocos da fila e os devolve ao laço de eventos, até o servidor ser encerrado.
+void Server::work( std::size_t id_ )
+{
+    Worker & self = *m_workers[ id_ ];
+    const std::uint64_t one = 1;
+    for ( ;; )
+    {
+        Job * job;
+        {
+            std::unique_lock< std::mutex > lock( m_work_mtx );
+            m_work_cv.wait( lock, [this]{ return m_stop_workers or not m_queue.empty(); } );
+            if ( m_stop_workers ) return;
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        process( self, *job );
+        {
+            std::lock_guard< std::mutex > lock( m_done_mtx );
+            m_done.push_back( job );
+        }
+        [[maybe_unused]] auto n = ::write( m_wake_fd, &one, sizeof( one ) );
+    }
+}
+
+/// Avalia cada linha do bloco, acumulando a saída formatada em `job_.output`.
+void Server::process( Worker & worker_, Job & job_ )
+{
+    LineResult result;
+    std::uint32_t begin = 0;
+    for ( auto end : job_.ends )
+    {
+        const std::string_view line( job_.input.data() + begin, end - begin );
+        begin = end;
+        StageTimer timer( Stats::LINE );
+        if ( not worker_.cache or not worker_.cache->lookup( line, result ) )
+        {
+            result = worker_.evaluator.evaluate( line );
+            if ( worker_.cache ) worker_.cache->insert( result );
+        }
+        append_result( job_.output, result );
+        if ( Stats::enabled() ) Stats::local().add_result( result.parser_result.type, result.eval_result.type );
+    }
+}
+
+/// Aceita todas as conexões pendentes (o socket de escuta não bloqueia).
+void Server::accept_all( void )
+{
+    for ( ;; )
+    {
+        const int fd = ::accept4( m_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+        if ( fd < 0 )
+        {
+            if ( errno == EINTR or errno == ECONNABORTED ) continue;
+            if ( errno != EAGAIN and errno != EWOULDBLOCK )
+                std::cerr << "accept: " << std::strerror( errno ) << "\n";
+            return;
+        }
+        std::unique_ptr< Connection > conn( new Connection );
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        if ( not watch( m_epoll_fd, EPOLL_CTL_ADD, fd, conn->events, conn.get() ) )
+        {
+            ::close( fd );
+            continue;
+        }
+        Connection * ptr = conn.get();
+        m_connections.emplace( ptr, std::move( conn ) );
+    }
+}
+
+/*!
+ * \brief Lê o que o cliente enviou (no máximo `READS_PER_EVENT` leituras) e entrega as linhas completas aos workers.
+ * Uma leitura que retorna zero é o fim dos pedidos do cliente: a última linha,
+ * mesmo sem '\n', é entregue, e a conexão é fechada depois das respostas.
+ */
+void Server::receive( Connection & conn_ )
+{
+    for ( int r( 0 ); r < READS_PER_EVENT; )
+    {
+        const std::size_t old = conn_.input.size();
+        conn_.input.resize( old + READ_BYTES );
+        const ssize_t n = ::read( conn_.fd, conn_.input.data() + old, READ_BYTES );
+        conn_.input.resize( old + ( n > 0 ? n : 0 ) );
+        if ( n > 0 )
+        {
+            if ( static_cast< std::size_t >( n ) < READ_BYTES ) break; // Não há mais nada no socket.
+            ++r;
+            continue;
+        }
+        if ( n == 0 )
+        {
+            conn_.eof = true;
+            break;
+        }
+        if ( errno == EINTR ) continue;
+        if ( errno == EAGAIN or errno == EWOULDBLOCK ) break;
+        close( conn_ );
+        return;
+    }
+    submit( conn_ );
+}
+
+/*!
+ * \brief Corta as linhas completas de `conn_.input` em blocos e os coloca na fila dos workers.
+ *
+ * Para quando a conexão atinge `JOBS_PER_CONNECTION` blocos em andamento (ela
+ * continua quando um deles voltar) ou quando a fila dos workers está cheia
+ * (então a conexão entra em `m_waiting`). As linhas que ficam para depois
+ * marcam a conexão como `stalled`, e ela deixa de ser lida até elas saírem.
+ */
+void Server::submit( Connection & conn_ )
+{
+    const char * data = conn_.input.data();
+    const std::size_t size = conn_.input.size();
+    std::size_t pos = 0;
+    // Ainda há uma linha para entregar? (no fim dos pedidos, a última não precisa de '\n')
+    auto has_line = [&]{ return std::memchr( data + pos, '\n', size - pos ) != nullptr or ( conn_.eof and pos < size ); };
+
+    while ( conn_.in_flight.size() < JOBS_PER_CONNECTION and has_line() )
+    {
+        if ( m_queued == m_max_queued )
+        {
+            if ( not conn_.waiting )
+            {
+                conn_.waiting = true;
+                m_waiting.push_back( &conn_ );
+            }
+            break;
+        }
+
+        Job * job;
+        if ( m_free_jobs.empty() )
+        {
+            m_jobs.emplace_back( new Job );
+            job = m_jobs.back().get();
+        }
+        else
+        {
+            job = m_free_jobs.back();
+            m_free_jobs.pop_back();
+        }
+        job->connection = &conn_;
+        job->input.clear();
+        job->ends.clear();
+        job->output.clear();
+        job->done = false;
+
+        while ( job->ends.size() < JOB_LINES and job->input.size() < JOB_BYTES and pos < size )
+        {
+            auto nl = static_cast< const char * >( std::memchr( data + pos, '\n', size - pos ) );
+            if ( nl == nullptr and not conn_.eof ) break;
+            const std::size_t end = nl != nullptr ? nl - data : size;
+            job->input.append( data + pos, end - pos );
+            job->ends.push_back( static_cast< std::uint32_t >( job->input.size() ) );
+            pos = nl != nullptr ? end + 1 : size;
+        }
+
+        conn_.in_flight.push_back( job );
+        ++m_queued;
+        {
+            std::lock_guard< std::mutex > lock( m_work_mtx );
+            m_queue.push_back( job );
+        }
+        m_work_cv.notify_one();
+    }
+
+    conn_.stalled = has_line();
+    conn_.input.erase( 0, pos );
+    if ( not conn_.stalled and conn_.input.size() > MAX_LINE_BYTES )
+    {
+        std::cerr << "Conexão fechada: linha com mais de " << MAX_LINE_BYTES << " bytes.\n";
+        close( conn_ );
+    }
+}
+
+/*!
+ * \brief Junta à saída da conexão as respostas dos blocos prontos, na ordem dos pedidos, e envia o que puder.
+ * Um bloco pronto atrás de um que ainda está em andamento espera a sua vez.
+ */
+void Server::flush( Connection & conn_ )
+{
+    while ( not conn_.in_flight.empty() and conn_.in_flight.front()->done )
+    {
+        Job * job = conn_.in_flight.front();
+        conn_.in_flight.pop_front();
+        if ( conn_.sent == conn_.output.size() )
+        {
+            // Nada pendente: a resposta do bloco vira a saída, sem cópia.
+            conn_.output.swap( job->output );
+            conn_.sent = 0;
+        }
+        else conn_.output.append( job->output );
+        m_free_jobs.push_back( job );
+    }
+
+    while ( conn_.sent < conn_.output.size() )
+    {
+        const ssize_t n = ::send( conn_.fd, conn_.output.data() + conn_.sent, conn_.output.size() - conn_.sent, MSG_NOSIGNAL );
+        if ( n >= 0 )
+        {
+            conn_.sent += n;
+            continue;
+        }
+        if ( errno == EINTR ) continue;
+        if ( errno == EAGAIN or errno == EWOULDBLOCK ) break; // O `update()` pede `EPOLLOUT`.
+        close( conn_ ); // O cliente foi embora.
+        return;
+    }
+    if ( conn_.sent == conn_.output.size() )
+    {
+        conn_.output.clear();
+        conn_.sent = 0;
+    }
+    else if ( conn_.sent > conn_.output.size() / 2 )
+    {
+        conn_.output.erase( 0, conn_.sent );
+        conn_.sent = 0;
+    }
+}
+
+/*!
+ * \brief Recolhe os blocos que os workers terminaram, envia as respostas e retoma as conexões que esperavam.
+ * Os blocos de uma conexão já fechada são só descartados.
+ */
+void Server::collect( void )
+{
+    std::vector< Job * > done;
+    {
+        std::lock_guard< std::mutex > lock( m_done_mtx );
+        done.swap( m_done );
+    }
+    for ( auto job : done )
+    {
+        --m_queued;
+        job->done = true;
+        Connection & conn = *job->connection;
+        if ( conn.fd < 0 )
+        {
+            conn.in_flight.erase( std::find( conn.in_flight.begin(), conn.in_flight.end(), job ) );
+            m_free_jobs.push_back( job );
+            if ( conn.in_flight.empty() ) m_dead.push_back( &conn );
+            continue;
+        }
+        flush( conn );
+        if ( conn.fd >= 0 ) submit( conn );
+        if ( conn.fd >= 0 ) update( conn );
+    }
+
+    // Com espaço na fila, as conexões que esperavam entregam as suas linhas, na ordem de chegada.
+    while ( m_queued < m_max_queued and not m_waiting.empty() )
+    {
+        Connection & conn = *m_waiting.front();
+        m_waiting.pop_front();
+        conn.waiting = false;
+        submit( conn );
+        if ( conn.fd >= 0 ) update( conn );
+    }
+}
+
+/*!
+ * \brief Ajusta os eventos da conexão no `epoll`, ou a fecha se não há mais nada a fazer.
+ *
+ * A conexão é lida enquanto não tem linhas esperando a vez e as respostas não
+ * enviadas estão abaixo de `OUTPUT_BYTES` (é a contrapressão por conexão); e
+ * espera `EPOLLOUT` enquanto tem respostas não enviadas. Depois do fim dos
+ * pedidos, quando a última resposta sai, a conexão é fechada.
+ */
+void Server::update( Connection & conn_ )
+{
+    const bool pending_output = conn_.sent < conn_.output.size();
+    if ( conn_.eof and not conn_.stalled and conn_.input.empty() and conn_.in_flight.empty() and not pending_output )
+    {
+        close( conn_ );
+        return;
+    }
+
+    std::uint32_t events = 0;
+    if ( not conn_.eof and not conn_.stalled and conn_.output.size() - conn_.sent < OUTPUT_BYTES ) events |= EPOLLIN;
+    if ( pending_output ) events |= EPOLLOUT;
+    if ( events != conn_.events )
+    {
+        watch( m_epoll_fd, EPOLL_CTL_MOD, conn_.fd, events, &conn_ );
+        conn_.events = events;
+    }
+}
+
+/// Fecha o socket da conexão. Ela continua existindo até os seus blocos em andamento voltarem dos workers.
+void Server::close( Connection & conn_ )
+{
+    ::epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, conn_.fd, nullptr );
+    ::close( conn_.fd );
+    conn_.fd = -1;
+    if ( conn_.waiting )
+    {
+        m_waiting.erase( std::find( m_waiting.begin(), m_waiting.end(), &conn_ ) );
+        conn_.waiting = false;
+    }
+
+    // Os blocos já avaliados são descartados; os demais, quando voltarem (veja `collect()`).
+    std::erase_if( conn_.in_flight, [this]( Job * job_ )
+    {
+        if ( not job_->done ) return false;
+        m_free_jobs.push_back( job_ );
+        return true;
+    } );
+    if ( conn_.in_flight.empty() ) m_dead.push_back( &conn_ );
+}
@@ -0,0 +1,148 @@
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <cstdint>            // std::uint32_t
+#include <string>             // std::string
+#include <vector>             // std::vector
+#include <deque>              // std::deque
+#include <memory>             // std::unique_ptr
+#include <unordered_map>      // std::unordered_map
+#include <thread>             // std::thread
+#include <mutex>              // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <atomic>             // std::atomic
+
+#include "line_evaluator.h"
+#include "result_cache.h"
+
+/*!
+ * Servidor de avaliação: um processo que fica no ar e atende muitos clientes
+ * por um socket Unix (`AF_UNIX`, `SOCK_STREAM`).
+ *
+ * Cada cliente envia expressões separadas por '\n' e recebe, na mesma
+ * conexão, uma linha de resultado por expressão, no formato da saída do
+ * programa (output.h) e na ordem em que as expressões chegaram. O cliente não
+ * precisa esperar uma resposta para mandar a próxima expressão (*pipelining*).
+ * Quando o cliente fecha o seu lado da conexão (`shutdown( SHUT_WR )`), uma
+ * última linha sem '\n' também é avaliada; depois das respostas, o servidor
+ * fecha a conexão.
+ *
+ * A thread que chama `run()` é um laço de eventos (`epoll`): aceita as
+ * conexões, lê os pedidos, corta as linhas completas em blocos (*jobs*) e
+ * escreve as respostas. Os blocos são avaliados por um número fixo de
+ * workers, cada um com o seu `LineEvaluator` (e cache, se houver), que ficam
+ * quentes de um cliente para o outro. Um worker avisa o laço de eventos de
+ * que terminou um bloco por um `eventfd`.
+ *
+ * A memória é limitada em dois níveis:
+ *  - por conexão: no máximo alguns blocos em andamento e uma quantidade
+ *    limitada de respostas ainda não enviadas. Passado o limite, o servidor
+ *    para de ler a conexão (o cliente que não lê as respostas acaba bloqueado
+ *    no `write()`) até as respostas saírem;
+ *  - no servidor: a fila dos workers tem tamanho máximo. Com a fila cheia, as
+ *    conexões esperam a sua vez (em ordem de chegada) sem ler mais nada.
+ */
+class Server
+{
+    public:
+        /// Cria `n_workers_` workers, cada um com um avaliador no modo `mode_` e um cache de `cache_size_` entradas (zero: sem cache).
+        Server( std::size_t n_workers_, LineEvaluator::mode_t mode_, std::size_t cache_size_ );
+        /// Encerra os workers e fecha as conexões que ainda estiverem abertas.
+        ~Server();
+        /// Desligar cópia e atribuição.
+        Server( const Server & ) = delete;
+        Server & operator=( const Server & ) = delete;
+
+        /// Cria o socket em `path_` e passa a aceitar conexões. Em caso de erro retorna `false` (com `errno`).
+        bool listen( const char * path_ );
+        /// Atende os clientes até `stop()` ser chamado; então remove o socket e retorna.
+        void run( void );
+        /// Pede o fim de `run()`. Pode ser chamado de outra thread ou de um tratador de sinal.
+        void stop( void );
+
+        /// Soma dos contadores dos caches dos workers.
+        ResultCache::Stats cache_stats( void ) const;
+
+    private:
+        struct Connection;
+
+        /// Um bloco de linhas de uma conexão e a resposta correspondente.
+        struct Job
+        {
+            Connection * connection = nullptr; //<! Conexão de onde vieram as linhas.
+            std::string input;                 //<! Cópia das linhas (sem os '\n').
+            std::vector< std::uint32_t > ends; //<! Posição do fim de cada linha em `input`.
+            std::string output;                //<! Resposta do bloco, já formatada.
+            bool done = false;                 //<! O bloco já foi avaliado? (só o laço de eventos usa)
+        };
+
+        /// Estado de uma conexão (só o laço de eventos usa).
+        struct Connection
+        {
+            int fd = -1;                 //<! Socket do cliente (-1 depois de fechado).
+            std::string input;           //<! Bytes recebidos que ainda não foram entregues aos workers.
+            std::deque< Job * > in_flight; //<! Blocos em andamento, na ordem dos pedidos.
+            std::string output;          //<! Respostas prontas, ainda não enviadas.
+            std::size_t sent = 0;        //<! Bytes de `output` já enviados.
+            std::uint32_t events = 0;    //<! Eventos registrados no `epoll`.
+            bool eof = false;            //<! O cliente fechou o seu lado da conexão?
+            bool stalled = false;        //<! Há linhas completas em `input` esperando a vez?
+            bool waiting = false;        //<! A conexão está em `m_waiting`?
+        };
+
+        /// Um worker: a thread e o seu avaliador.
+        struct Worker
+        {
+            std::thread thread;                   //<! Thread do worker.
+            LineEvaluator evaluator;              //<! Avaliador próprio do worker.
+            std::unique_ptr< ResultCache > cache; //<! Cache próprio do worker (opcional).
+
+            Worker( LineEvaluator::mode_t mode_ ) : evaluator( mode_ ) { /* empty */ }
+        };
+
+        std::vector< std::unique_ptr< Worker > > m_workers; //<! Os workers.
+
+        std::mutex m_work_mtx;              //<! Protege `m_queue` e `m_stop_workers`.
+        std::condition_variable m_work_cv;  //<! Acorda os workers quando chega um bloco (ou no fim).
+        std::deque< Job * > m_queue;        //<! Blocos esperando um worker.
+        bool m_stop_workers = false;        //<! Os workers devem terminar?
+
+        std::mutex m_done_mtx;              //<! Protege `m_done`.
+        std::vector< Job * > m_done;        //<! Blocos avaliados, ainda não recolhidos pelo laço de eventos.
+
+        int m_listen_fd = -1;               //<! Socket que aceita as conexões.
+        int m_epoll_fd = -1;                //<! Descritor do `epoll`.
+        int m_wake_fd = -1;                 //<! `eventfd` que acorda o laço de eventos (blocos prontos ou `stop()`).
+        std::string m_path;                 //<! Caminho do socket (removido no fim de `run()`).
+        std::atomic< bool > m_stopping{ false }; //<! `stop()` foi chamado?
+
+        std::size_t m_max_queued;           //<! Máximo de blocos entregues aos workers e ainda não recolhidos.
+        std::size_t m_queued = 0;           //<! Blocos entregues aos workers e ainda não recolhidos.
+        std::unordered_map< Connection *, std::unique_ptr< Connection > > m_connections; //<! Conexões (abertas ou com blocos em andamento).
+        std::deque< Connection * > m_waiting; //<! Conexões esperando espaço na fila dos workers, em ordem de chegada.
+        std::vector< Connection * > m_dead;   //<! Conexões fechadas e sem blocos, liberadas ao fim de cada rodada de eventos.
+        std::vector< std::unique_ptr< Job > > m_jobs; //<! Todos os blocos (reaproveitados).
+        std::vector< Job * > m_free_jobs;     //<! Blocos prontos para serem reaproveitados.
+
+        /// Laço de um worker.
+        void work( std::size_t id_ );
+        /// Avalia todas as linhas de um bloco.
+        void process( Worker &, Job & );
+
+        /// Aceita as conexões pendentes.
+        void accept_all( void );
+        /// Lê o que o cliente enviou.
+        void receive( Connection & );
+        /// Entrega aos workers as linhas completas da conexão, respeitando os limites.
+        void submit( Connection & );
+        /// Junta as respostas prontas (em ordem) e envia o que o socket aceitar.
+        void flush( Connection & );
+        /// Recolhe os blocos avaliados pelos workers.
+        void collect( void );
+        /// Ajusta os eventos da conexão no `epoll` (ler, escrever) e a fecha se tudo terminou.
+        void update( Connection & );
+        /// Fecha o socket da conexão; a conexão é liberada quando não tiver mais blocos em andamento.
+        void close( Connection & );
+};
+
+#endif
@@ -0,0 +1,283 @@
+#include "stats.h"
+
+#include <algorithm>          // std::max, std::min
+#include <chrono>             // std::chrono::steady_clock
+#include <cstdio>             // std::rename
+#include <fstream>            // std::ofstream
+#include <iomanip>            // std::setw
+#include <memory>             // std::unique_ptr
+#include <mutex>              // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <thread>             // std::thread
+
+namespace {
+    /// Nomes das etapas, na ordem de `Stats::stage_t`.
+    const char * const STAGE_NAMES[ Stats::N_STAGES ] =
+        { "read", "lex", "parse", "convert", "evaluate", "fused", "output", "line" };
+    /// Nomes dos códigos de erro, na ordem de `Parser::ParserResult::code_t` e `Evaluator::EvaluatorResult::code_t`.
+    const char * const PARSER_CODE_NAMES[ Stats::N_PARSER_CODES ] =
+        { "ok", "unexpected_end_of_expression", "ill_formed_integer", "missing_term",
+          "extraneous_symbol", "missing_closing_parenthesis", "integer_out_of_range" };
+    const char * const EVAL_CODE_NAMES[ Stats::N_EVAL_CODES ] =
+        { "ok", "division_by_zero", "result_overflow" };
+
+    /// `Stats` de todas as threads (nunca são destruídos, para que as threads que já terminaram continuem no relatório).
+    std::mutex g_registry_mtx;
+    std::vector< std::unique_ptr< Stats > > g_registry;
+
+    /// Referências de tempo tomadas em `enable()`, para converter ticks em nanossegundos.
+    std::uint64_t g_start_ticks = 0;
+    std::chrono::steady_clock::time_point g_start_time;
+
+    /// Nanossegundos por tick, medidos entre `enable()` e agora.
+    double ns_per_tick( void )
+    {
+#if defined( __x86_64__ ) or defined( __i386__ )
+        double ticks = static_cast< double >( Stats::now() - g_start_ticks );
+        double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - g_start_time ).count();
+        return ticks > 0 ? ns / ticks : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    /// Escrita periódica das métricas.
+    struct Periodic
+    {
+        std::string path;
+        unsigned interval_s = 0;
+        std::thread thread;
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool stop = false;
+    };
+    Periodic g_periodic;
+
+    /// Escreve as métricas em um arquivo temporário e o renomeia, para que o leitor nunca veja um arquivo pela metade.
+    void write_file( const std::string & path_ )
+    {
+        const std::string tmp = path_ + ".tmp";
+        {
+            std::ofstream out( tmp );
+            Stats::write_prometheus( out );
+            if ( not out ) return;
+        }
+        std::rename( tmp.c_str(), path_.c_str() );
+    }
+}
+
+/// Faixa de um valor: os valores pequenos têm uma faixa cada; os demais, 64 faixas por potência de dois.
+std::size_t Stats::Histogram::bucket( std::uint64_t value_ )
+{
+    if ( value_ > MAX_VALUE ) value_ = MAX_VALUE;
+    if ( value_ < ( std::uint64_t( 2 ) << SUB_BITS ) ) return value_;
+    const unsigned shift = 63 - __builtin_clzll( value_ ) - SUB_BITS;
+    return ( std::size_t( shift ) << SUB_BITS ) + ( value_ >> shift );
+}
+
+/// Valor representativo de uma faixa: o meio do intervalo que ela cobre.
+std::uint64_t Stats::Histogram::value( std::size_t bucket_ )
+{
+    if ( bucket_ < ( std::size_t( 2 ) << SUB_BITS ) ) return bucket_;
+    const unsigned shift = ( bucket_ >> SUB_BITS ) - 1;
+    const std::uint64_t mantissa = bucket_ - ( std::size_t( shift ) << SUB_BITS );
+    return ( mantissa << shift ) + ( ( std::uint64_t( 1 ) << shift ) >> 1 );
+}
+
+void Stats::Histogram::record( std::uint64_t value_ )
+{
+    bump( m_buckets[ bucket( value_ ) ] );
+    bump( m_count );
+    bump( m_sum, value_ );
+    if ( value_ > m_max.load( std::memory_order_relaxed ) )
+        m_max.store( value_, std::memory_order_relaxed );
+}
+
+void Stats::Histogram::add_to( Snapshot & snap_ ) const
+{
+    for ( std::size_t i( 0 ); i < N_BUCKETS; ++i )
+        snap_.buckets[i] += m_buckets[i].load( std::memory_order_relaxed );
+    snap_.count += m_count.load( std::memory_order_relaxed );
+    snap_.sum += m_sum.load( std::memory_order_relaxed );
+    snap_.max = std::max( snap_.max, m_max.load( std::memory_order_relaxed ) );
+}
+
+/*!
+ * \param q_ Fração, entre 0 e 1 (por exemplo, 0.99 para o p99).
+ * \return O valor representativo da faixa que contém o registro de posição `ceil( q_ * count )`.
+ */
+std::uint64_t Stats::Histogram::Snapshot::percentile( double q_ ) const
+{
+    if ( count == 0 ) return 0;
+    std::uint64_t rank = static_cast< std::uint64_t >( q_ * count + 0.999999 );
+    if ( rank == 0 ) rank = 1;
+    std::uint64_t seen = 0;
+    for ( std::size_t i( 0 ); i < buckets.size(); ++i )
+    {
+        seen += buckets[i];
+        if ( seen >= rank ) return std::min( value( i ), max );
+    }
+    return max;
+}
+
+/// Liga a instrumentação e toma as referências de tempo.
+void Stats::enable( void )
+{
+#ifndef BARES_NO_STATS
+    g_start_time = std::chrono::steady_clock::now();
+    g_start_ticks = now();
+    s_enabled = true;
+#endif
+}
+
+/// `Stats` da thread atual, criado e registrado no primeiro uso.
+Stats & Stats::local( void )
+{
+    thread_local Stats * mine = nullptr;
+    if ( mine == nullptr )
+    {
+        std::lock_guard< std::mutex > lock( g_registry_mtx );
+        g_registry.emplace_back( new Stats );
+        mine = g_registry.back().get();
+    }
+    return *mine;
+}
+
+/// Conta uma linha e os seus códigos de erro (`PARSER_OK`/`EVALUATOR_OK` também são contados).
+void Stats::add_result( int parser_code_, int eval_code_ )
+{
+    bump( m_lines );
+    if ( parser_code_ >= 0 and static_cast< std::size_t >( parser_code_ ) < N_PARSER_CODES )
+        bump( m_parser_errors[ parser_code_ ] );
+    // Só há avaliação se o parsing foi OK.
+    if ( parser_code_ == 0 and eval_code_ >= 0 and static_cast< std::size_t >( eval_code_ ) < N_EVAL_CODES )
+        bump( m_eval_errors[ eval_code_ ] );
+}
+
+/// Soma de todas as threads.
+struct Stats::Totals
+{
+    std::uint64_t tokens = 0;
+    std::uint64_t lines = 0;
+    std::uint64_t parser_codes[ N_PARSER_CODES ] = {};
+    std::uint64_t eval_codes[ N_EVAL_CODES ] = {};
+    Histogram::Snapshot stages[ N_STAGES ];
+};
+
+/// Soma os contadores e histogramas de todas as threads (que podem continuar registrando enquanto isso).
+void Stats::collect( Totals & t_ )
+{
+    std::lock_guard< std::mutex > lock( g_registry_mtx );
+    for ( const auto & s : g_registry )
+    {
+        t_.tokens += s->m_tokens.load( std::memory_order_relaxed );
+        t_.lines += s->m_lines.load( std::memory_order_relaxed );
+        for ( std::size_t c( 0 ); c < N_PARSER_CODES; ++c ) t_.parser_codes[c] += s->m_parser_errors[c].load( std::memory_order_relaxed );
+        for ( std::size_t c( 0 ); c < N_EVAL_CODES; ++c ) t_.eval_codes[c] += s->m_eval_errors[c].load( std::memory_order_relaxed );
+        for ( std::size_t st( 0 ); st < N_STAGES; ++st ) s->m_stages[st].add_to( t_.stages[st] );
+    }
+}
+
+/// Escreve o relatório de todas as threads, com os percentis de cada etapa em nanossegundos.
+void Stats::print( std::ostream & os_ )
+{
+    Totals t;
+    collect( t );
+    const double k = ns_per_tick();
+
+    os_ << "stats: " << t.lines << " linhas, " << t.tokens << " tokens\n";
+    os_ << "  parsing:";
+    for ( std::size_t c( 0 ); c < N_PARSER_CODES; ++c )
+        if ( t.parser_codes[c] > 0 ) os_ << ' ' << PARSER_CODE_NAMES[c] << '=' << t.parser_codes[c];
+    os_ << "\n  avaliação:";
+    for ( std::size_t c( 0 ); c < N_EVAL_CODES; ++c )
+        if ( t.eval_codes[c] > 0 ) os_ << ' ' << EVAL_CODE_NAMES[c] << '=' << t.eval_codes[c];
+    os_ << "\n";
+
+    os_ << "  " << std::left << std::setw( 10 ) << "etapa" << std::right << std::setw( 12 ) << "chamadas"
+        << std::setw( 12 ) << "total (ms)" << std::setw( 10 ) << "p50 (ns)" << std::setw( 10 ) << "p99 (ns)"
+        << std::setw( 12 ) << "p99.9 (ns)" << std::setw( 12 ) << "max (ns)" << "\n";
+    for ( std::size_t st( 0 ); st < N_STAGES; ++st )
+    {
+        const auto & h = t.stages[st];
+        if ( h.count == 0 ) continue;
+        os_ << "  " << std::left << std::setw( 10 ) << STAGE_NAMES[st] << std::right << std::setw( 12 ) << h.count
+            << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << h.sum * k / 1e6
+            << std::setprecision( 0 )
+            << std::setw( 10 ) << h.percentile( 0.5 ) * k << std::setw( 10 ) << h.percentile( 0.99 ) * k
+            << std::setw( 12 ) << h.percentile( 0.999 ) * k << std::setw( 12 ) << h.max * k << "\n";
+    }
+}
+
+/*!
+ * \brief Escreve as métricas no formato texto do Prometheus.
+ * Os contadores viram `counter`s; as durações das etapas viram `summary`s, em
+ * segundos, com os quantis 0.5, 0.99 e 0.999.
+ */
+void Stats::write_prometheus( std::ostream & os_ )
+{
+    Totals t;
+    collect( t );
+    const double s_per_tick = ns_per_tick() / 1e9;
+
+    os_ << "# HELP bares_lines_total Linhas avaliadas.\n"
+        << "# TYPE bares_lines_total counter\n"
+        << "bares_lines_total " << t.lines << "\n"
+        << "# HELP bares_tokens_total Tokens produzidos pelo parser.\n"
+        << "# TYPE bares_tokens_total counter\n"
+        << "bares_tokens_total " << t.tokens << "\n"
+        << "# HELP bares_parser_results_total Linhas por resultado do parsing.\n"
+        << "# TYPE bares_parser_results_total counter\n";
+    for ( std::size_t c( 0 ); c < N_PARSER_CODES; ++c )
+        os_ << "bares_parser_results_total{code=\"" << PARSER_CODE_NAMES[c] << "\"} " << t.parser_codes[c] << "\n";
+    os_ << "# HELP bares_eval_results_total Linhas por resultado da avaliação.\n"
+        << "# TYPE bares_eval_results_total counter\n";
+    for ( std::size_t c( 0 ); c < N_EVAL_CODES; ++c )
+        os_ << "bares_eval_results_total{code=\"" << EVAL_CODE_NAMES[c] << "\"} " << t.eval_codes[c] << "\n";
+
+    os_ << "# HELP bares_stage_seconds Duração de cada etapa, por chamada.\n"
+        << "# TYPE bares_stage_seconds summary\n";
+    for ( std::size_t st( 0 ); st < N_STAGES; ++st )
+    {
+        const auto & h = t.stages[st];
+        for ( const char * q : { "0.5", "0.99", "0.999" } )
+            os_ << "bares_stage_seconds{stage=\"" << STAGE_NAMES[st] << "\",quantile=\"" << q << "\"} "
+                << std::scientific << std::setprecision( 6 ) << h.percentile( std::stod( q ) ) * s_per_tick << "\n";
+        os_ << "bares_stage_seconds_sum{stage=\"" << STAGE_NAMES[st] << "\"} " << h.sum * s_per_tick << "\n"
+            << "bares_stage_seconds_count{stage=\"" << STAGE_NAMES[st] << "\"} " << h.count << "\n";
+    }
+    os_ << std::defaultfloat;
+}
+
+/*!
+ * \param path_ Arquivo que recebe as métricas (substituído a cada escrita).
+ * \param interval_s_ Intervalo entre as escritas, em segundos (pelo menos 1).
+ * \return `false` se a escrita periódica já estava ativa.
+ */
+bool Stats::start_periodic( const std::string & path_, unsigned interval_s_ )
+{
+    if ( g_periodic.thread.joinable() ) return false;
+    g_periodic.path = path_;
+    g_periodic.interval_s = interval_s_ > 0 ? interval_s_ : 1;
+    g_periodic.stop = false;
+    g_periodic.thread = std::thread( []
+    {
+        std::unique_lock< std::mutex > lock( g_periodic.mtx );
+        while ( not g_periodic.cv.wait_for( lock, std::chrono::seconds( g_periodic.interval_s ),
+                                            []{ return g_periodic.stop; } ) )
+            write_file( g_periodic.path );
+    } );
+    return true;
+}
+
+void Stats::stop_periodic( void )
+{
+    if ( not g_periodic.thread.joinable() ) return;
+    {
+        std::lock_guard< std::mutex > lock( g_periodic.mtx );
+        g_periodic.stop = true;
+    }
+    g_periodic.cv.notify_one();
+    g_periodic.thread.join();
+    write_file( g_periodic.path );
+}
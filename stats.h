@@ -0,0 +1,183 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <atomic>  // std::atomic
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <ostream> // std::ostream
+#include <string>  // std::string
+#include <vector>  // std::vector
+#include <chrono>  // std::chrono::steady_clock
+#include <type_traits> // std::is_constant_evaluated()
+
+#if defined( __x86_64__ ) or defined( __i386__ )
+#include <x86intrin.h> // __rdtsc
+#endif
+
+/*!
+ * Instrumentação das etapas do BARES (opção `--stats`).
+ *
+ * Cada thread tem o seu próprio `Stats`, com contadores e um histograma de
+ * latência por etapa; só a própria thread escreve nele, então o registro não
+ * usa travas nem instruções atômicas de leitura-modificação-escrita. As
+ * leituras (o relatório final ou a escrita periódica) somam os `Stats` de
+ * todas as threads.
+ *
+ * Os tempos são medidos em *ticks* do contador de ciclos da CPU (`rdtsc`),
+ * que são convertidos para nanossegundos só na hora do relatório.
+ *
+ * Enquanto a instrumentação não é ligada com `enable()`, cada ponto de medida
+ * custa apenas o teste de um `bool`. Compilando com `-DBARES_NO_STATS`,
+ * `enabled()` é uma constante `false` e todos os pontos de medida desaparecem.
+ */
+class Stats
+{
+    public:
+        /// Etapas medidas.
+        enum stage_t
+        {
+            READ = 0, //<! Leitura de uma linha (`LineReader::next()`).
+            LEX,      //<! Índice estrutural da linha.
+            PARSE,    //<! Parsing (a partir do índice).
+            CONVERT,  //<! Conversão para pósfixa (ou compilação para bytecode).
+            EVALUATE, //<! Avaliação da expressão pósfixa (ou execução do bytecode).
+            FUSED,    //<! Parsing e avaliação em uma passada (`--fused`).
+            OUTPUT,   //<! Formatação e escrita do resultado.
+            LINE,     //<! Linha completa: do início da avaliação até a saída (inclusive o cache).
+            N_STAGES
+        };
+
+        /// Quantidade de códigos de `Parser::ParserResult` e de `Evaluator::EvaluatorResult`.
+        static const std::size_t N_PARSER_CODES = 7;
+        static const std::size_t N_EVAL_CODES = 3;
+
+        /*!
+         * Histograma com erro relativo limitado (no estilo do HdrHistogram).
+         * Cada potência de dois é dividida em 64 faixas iguais, então o valor
+         * reportado para qualquer percentil tem erro relativo abaixo de 1,6%.
+         */
+        class Histogram
+        {
+            public:
+                static const unsigned SUB_BITS = 6;                      //<! 2^6 faixas por potência de dois.
+                static const std::uint64_t MAX_VALUE = ( std::uint64_t( 1 ) << 40 ) - 1; //<! Valores maiores são truncados.
+                static const std::size_t N_BUCKETS = ( 40 - SUB_BITS + 1 ) << SUB_BITS;
+
+                /// Registra um valor (só a thread dona do histograma pode chamar).
+                void record( std::uint64_t value_ );
+
+                /// Cópia (não atômica) de um ou mais histogramas, usada nos relatórios.
+                struct Snapshot
+                {
+                    std::vector< std::uint64_t > buckets = std::vector< std::uint64_t >( N_BUCKETS );
+                    std::uint64_t count = 0;
+                    std::uint64_t sum = 0;
+                    std::uint64_t max = 0;
+
+                    /// Valor abaixo do qual está a fração `q_` dos registros.
+                    std::uint64_t percentile( double q_ ) const;
+                };
+                /// Soma este histograma a `snap_` (pode ser chamado por qualquer thread).
+                void add_to( Snapshot & snap_ ) const;
+
+                /// Faixa de um valor.
+                static std::size_t bucket( std::uint64_t value_ );
+                /// Valor representativo (o meio) de uma faixa.
+                static std::uint64_t value( std::size_t bucket_ );
+
+            private:
+                std::atomic< std::uint64_t > m_buckets[ N_BUCKETS ] = {};
+                std::atomic< std::uint64_t > m_count{ 0 };
+                std::atomic< std::uint64_t > m_sum{ 0 };
+                std::atomic< std::uint64_t > m_max{ 0 };
+        };
+
+#ifndef BARES_NO_STATS
+        /// A instrumentação está ligada?
+        static bool enabled( void ) { return s_enabled; }
+#else
+        static constexpr bool enabled( void ) { return false; }
+#endif
+        /// Liga a instrumentação (antes de criar as threads de trabalho).
+        static void enable( void );
+
+        /// Instante atual, em ticks: o contador de ciclos, em x86; nanossegundos do relógio monotônico, nas demais arquiteturas.
+        static std::uint64_t now( void )
+        {
+#if defined( __x86_64__ ) or defined( __i386__ )
+            return __rdtsc();
+#else
+            return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+        }
+        /// `Stats` da thread atual (criado no primeiro uso).
+        static Stats & local( void );
+
+        /// Registra a duração (em ticks) de uma etapa.
+        void record( stage_t stage_, std::uint64_t ticks_ ) { m_stages[ stage_ ].record( ticks_ ); }
+        /// Conta os tokens de uma expressão.
+        void add_tokens( std::size_t n_ ) { bump( m_tokens, n_ ); }
+        /// Conta uma linha e o seu resultado (`Parser::ParserResult::code_t`, `Evaluator::EvaluatorResult::code_t`).
+        void add_result( int parser_code_, int eval_code_ );
+
+        /// Escreve o relatório (legível) de todas as threads.
+        static void print( std::ostream & os_ );
+        /// Escreve as métricas de todas as threads no formato texto do Prometheus.
+        static void write_prometheus( std::ostream & os_ );
+
+        /// Escreve as métricas em `path_` a cada `interval_s_` segundos (em uma thread própria).
+        static bool start_periodic( const std::string & path_, unsigned interval_s_ );
+        /// Encerra a escrita periódica, escrevendo as métricas uma última vez.
+        static void stop_periodic( void );
+
+    private:
+        Histogram m_stages[ N_STAGES ];                               //<! Duração de cada etapa.
+        std::atomic< std::uint64_t > m_tokens{ 0 };                   //<! Tokens produzidos pelo parser.
+        std::atomic< std::uint64_t > m_lines{ 0 };                    //<! Linhas com resultado.
+        std::atomic< std::uint64_t > m_parser_errors[ N_PARSER_CODES ] = {}; //<! Linhas por código de erro de parsing.
+        std::atomic< std::uint64_t > m_eval_errors[ N_EVAL_CODES ] = {};     //<! Linhas por código de erro de avaliação.
+
+        /// Soma a um contador que só a thread dona escreve (sem instrução atômica de leitura-modificação-escrita).
+        static void bump( std::atomic< std::uint64_t > & c_, std::uint64_t n_ = 1 )
+        {
+            c_.store( c_.load( std::memory_order_relaxed ) + n_, std::memory_order_relaxed );
+        }
+
+        /// Soma dos `Stats` de todas as threads.
+        struct Totals;
+        static void collect( Totals & );
+
+        inline static bool s_enabled = false; //<! Ligada por `enable()`.
+};
+
+/*!
+ * Mede a duração de uma etapa: do construtor ao destrutor.
+ * Com a instrumentação desligada (ou compilada fora), não faz nada; em
+ * `constexpr` (parsing em tempo de compilação) também não.
+ */
+class StageTimer
+{
+    public:
+#ifndef BARES_NO_STATS
+        constexpr explicit StageTimer( Stats::stage_t stage_ )
+            : m_stage( stage_ )
+            , m_start( not std::is_constant_evaluated() and Stats::enabled() ? Stats::now() : 0 )
+        { /* empty */ }
+        constexpr ~StageTimer()
+        {
+            if ( m_start != 0 ) Stats::local().record( m_stage, Stats::now() - m_start );
+        }
+#else
+        constexpr explicit StageTimer( Stats::stage_t ) { /* empty */ }
+#endif
+        StageTimer( const StageTimer & ) = delete;
+        StageTimer & operator=( const StageTimer & ) = delete;
+
+#ifndef BARES_NO_STATS
+    private:
+        Stats::stage_t m_stage; //<! Etapa medida.
+        std::uint64_t m_start;  //<! Início da medida (zero: não está medindo).
+#endif
+};
+
+#endif
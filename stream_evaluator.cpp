@@ -0,0 +1,233 @@
+#include "stream_evaluator.h"
+
+#include <algorithm> // std::max
+
+/*!
+ * \brief Consome o próximo pedaço da expressão.
+ *
+ * A máquina de estados segue as mesmas regras do `Parser` (e do laço de
+ * `FusedEvaluator::expression()`):
+ * ```
+ * <expr> := <term>,{ ("+"|"-"|"*"|"/"|"%"|"^"),<term> };
+ * <term> := "(",<expr>,")" | <integer>;
+ * <integer> := 0 | ["-"],<natural_number>;
+ * ```
+ * Cada caso do `switch` consome um ou mais caracteres do pedaço e pode mudar
+ * de estado; um pedaço pode terminar em qualquer estado, e o próximo continua
+ * de onde este parou.
+ *
+ * \param chunk_ O próximo pedaço (não é guardado depois da chamada).
+ */
+void StreamEvaluator::feed( std::string_view chunk_ )
+{
+    const char * const first = chunk_.data();
+    const char * const last = first + chunk_.size();
+    const char * p = first;
+    // Coluna (na expressão inteira) do caractere apontado por `p`.
+    auto col = [&]( void ) { return m_pos + ( p - first ); };
+
+    while ( p != last )
+    {
+        switch ( m_state )
+        {
+            case TERM:
+                while ( p != last and ( *p == ' ' or *p == '\t' ) ) ++p;
+                if ( p == last ) break;
+                m_started = true;
+                if ( *p == '(' )
+                {
+                    push_op( Token::L_PAREN );
+                    ++m_open;
+                    ++p;
+                    break;
+                }
+                // Iniciando um novo <integer>.
+                m_begin = col();
+                m_value = 0;
+                m_negative = false;
+                m_overflow = false;
+                if ( *p == '0' )
+                {
+                    ++p;
+                    if ( end_integer() ) m_state = AFTER;
+                }
+                else if ( *p == '-' )
+                {
+                    m_negative = true;
+                    m_state = MINUS;
+                    ++p;
+                }
+                else if ( *p >= '1' and *p <= '9' )
+                    m_state = DIGITS;
+                else
+                    fail( Parser::ParserResult::ILL_FORMED_INTEGER, col() );
+                break;
+
+            case MINUS:
+                // O "-" precisa vir colado a um <natural_number>.
+                if ( *p >= '1' and *p <= '9' )
+                    m_state = DIGITS;
+                else
+                    fail( Parser::ParserResult::ILL_FORMED_INTEGER, col() );
+                break;
+
+            case DIGITS:
+                while ( p != last and *p >= '0' and *p <= '9' )
+                {
+                    if ( not m_overflow )
+                        m_overflow = not Numeric::push_digit( m_value, *p - '0' );
+                    ++p;
+                }
+                // Se o pedaço acabou, o número pode continuar no próximo.
+                if ( p != last and end_integer() )
+                    m_state = AFTER;
+                break;
+
+            case AFTER:
+                while ( p != last and ( *p == ' ' or *p == '\t' ) ) ++p;
+                if ( p == last ) break;
+                if ( *p == ')' and m_open > 0 )
+                {
+                    // O ")" aplica os operadores pendentes até o "(" correspondente.
+                    while ( m_ops.back() != Token::L_PAREN )
+                        reduce();
+                    m_ops.pop_back();
+                    --m_open;
+                    ++p;
+                    break;
+                }
+                if ( auto s = Token::to_symbol( *p ); s != Token::NONE and s != Token::L_PAREN and s != Token::R_PAREN )
+                {
+                    // Aplica os operadores pendentes que têm precedência sobre o novo.
+                    const Token op( Token::OPERATOR, s, 0, 0 );
+                    const auto prec = Evaluator::get_operator_precedence( op );
+                    while ( not m_ops.empty() and m_ops.back() != Token::L_PAREN )
+                    {
+                        const auto top_prec = Evaluator::get_operator_precedence( Token( Token::OPERATOR, m_ops.back(), 0, 0 ) );
+                        if ( top_prec < prec or ( top_prec == prec and Evaluator::right_association( op ) ) )
+                            break;
+                        reduce();
+                    }
+                    push_op( s );
+                    m_state = TERM;
+                    ++p;
+                    break;
+                }
+                // Nem ")" nem operador: a expressão deveria ter terminado (ou faltou fechar um "(").
+                fail( m_open > 0 ? Parser::ParserResult::MISSING_CLOSING_PARENTHESIS
+                                 : Parser::ParserResult::EXTRANEOUS_SYMBOL, col() );
+                break;
+
+            case DONE:
+                p = last;
+                break;
+        }
+    }
+    m_pos += chunk_.size();
+}
+
+/*!
+ * \brief Encerra a expressão.
+ * O fim da entrada é tratado como mais um símbolo: dependendo do estado, ele
+ * completa o <integer> atual, encerra a expressão ou é um erro (na coluna do fim).
+ * \return O erro de parsing, o erro de avaliação ou o valor da expressão.
+ */
+LineResult StreamEvaluator::finish( void )
+{
+    switch ( m_state )
+    {
+        case TERM:
+            // Só ws: a expressão está vazia; senão faltou o <term> depois de um operador ou de um "(".
+            fail( m_started ? Parser::ParserResult::MISSING_TERM
+                            : Parser::ParserResult::UNEXPECTED_END_OF_EXPRESSION, m_pos );
+            break;
+        case MINUS:
+            fail( Parser::ParserResult::ILL_FORMED_INTEGER, m_pos );
+            break;
+        case DIGITS:
+            if ( not end_integer() ) break;
+            [[fallthrough]];
+        case AFTER:
+            if ( m_open > 0 )
+                fail( Parser::ParserResult::MISSING_CLOSING_PARENTHESIS, m_pos );
+            break;
+        case DONE:
+            break;
+    }
+
+    LineResult result;
+    result.parser_result = m_parser_status;
+    if ( m_parser_status.type == Parser::ParserResult::PARSER_OK )
+    {
+        // Aplicar os operadores pendentes.
+        while ( not m_ops.empty() )
+            reduce();
+        result.eval_result = m_eval_status;
+        result.value = m_eval_status.type == Evaluator::EvaluatorResult::EVALUATOR_OK ? m_values.back() : 0;
+    }
+    reset();
+    return result;
+}
+
+/// Descarta a expressão atual (as pilhas mantêm a capacidade).
+void StreamEvaluator::reset( void )
+{
+    m_state = TERM;
+    m_started = false;
+    m_pos = 0;
+    m_open = 0;
+    m_values.clear();
+    m_ops.clear();
+    m_max_depth = 0;
+    m_parser_status = Parser::ParserResult();
+    m_eval_status = Evaluator::EvaluatorResult();
+}
+
+/// Registra o erro de parsing na coluna `col_`.
+void StreamEvaluator::fail( Parser::ParserResult::code_t code_, std::size_t col_ )
+{
+    m_parser_status = Parser::ParserResult( code_, col_ );
+    m_state = DONE;
+}
+
+/*!
+ * \brief Encerra o <integer> atual, com as mesmas regras de `Parser::integer()`.
+ * \return `false` se o valor está fora dos limites (o erro é registrado).
+ */
+bool StreamEvaluator::end_integer( void )
+{
+    // O valor foi acumulado negado; só trocamos o sinal se não houve '-'.
+    if ( not m_negative and not m_overflow )
+        m_overflow = not Numeric::negate( m_value );
+    if ( m_overflow )
+    {
+        fail( Parser::ParserResult::INTEGER_OUT_OF_RANGE, m_begin );
+        return false;
+    }
+    m_values.push_back( m_value );
+    m_max_depth = std::max( m_max_depth, m_values.size() + m_ops.size() );
+    return true;
+}
+
+/// Empilha o operador (ou "(") `s_`.
+void StreamEvaluator::push_op( Token::symbol_t s_ )
+{
+    m_ops.push_back( s_ );
+    m_max_depth = std::max( m_max_depth, m_values.size() + m_ops.size() );
+}
+
+/*!
+ * \brief Desempilha um operador e os seus dois operandos, e empilha o resultado.
+ * Depois do primeiro erro de avaliação nada mais é calculado; o erro fica
+ * guardado até sabermos se a expressão inteira está bem formada.
+ */
+void StreamEvaluator::reduce( void )
+{
+    const Token op( Token::OPERATOR, m_ops.back(), 0, 0 );
+    m_ops.pop_back();
+    const auto op2 = m_values.back(); m_values.pop_back();
+    const auto op1 = m_values.back();
+    m_values.back() = m_eval_status.type == Evaluator::EvaluatorResult::EVALUATOR_OK
+                    ? Evaluator::apply_operation( op1, op2, op, m_eval_status )
+                    : 0;
+}
@@ -0,0 +1,93 @@
+#ifndef _STREAM_EVALUATOR_H_
+#define _STREAM_EVALUATOR_H_
+
+#include <cstddef>     // std::size_t
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include "token.h"
+#include "parser.h"         // Parser::ParserResult
+#include "evaluator.h"      // Evaluator::EvaluatorResult e regras de avaliação.
+#include "line_evaluator.h" // LineResult
+
+/*!
+ * Avaliador *push* de uma expressão recebida em pedaços.
+ *
+ * O cliente entrega a expressão em pedaços de qualquer tamanho (`feed()`),
+ * cortados em qualquer posição, inclusive no meio de um número, e pede o
+ * resultado no fim da expressão (`finish()`). Nenhum pedaço é guardado: cada
+ * caractere é consumido por uma máquina de estados que continua de onde o
+ * pedaço anterior parou. O único estado é o do token parcial (o valor
+ * acumulado de um número e a coluna onde ele começa) e as pilhas de operandos
+ * e de operadores do `FusedEvaluator`, cujo tamanho depende da profundidade
+ * dos parênteses e dos operadores pendentes, e não do tamanho da linha.
+ *
+ * Os resultados e erros (inclusive as colunas) são os mesmos do pipeline
+ * `Parser` + `Evaluator`. Depois do primeiro erro de parsing o resto da
+ * expressão é ignorado.
+ *
+ * As pilhas são reaproveitadas de uma expressão para a outra. Cada thread
+ * deve usar o seu próprio objeto.
+ */
+class StreamEvaluator
+{
+    public:
+        typedef Evaluator::result_t result_t;
+
+        /// Acrescenta o próximo pedaço da expressão.
+        void feed( std::string_view chunk_ );
+        /// Encerra a expressão e retorna o seu resultado; o avaliador fica pronto para a próxima.
+        LineResult finish( void );
+        /// Descarta a expressão atual.
+        void reset( void );
+
+        /// Quantidade de caracteres recebidos na expressão atual.
+        std::size_t consumed( void ) const { return m_pos; }
+        /// Maior profundidade (operandos mais operadores pendentes) das pilhas até agora.
+        std::size_t max_depth( void ) const { return m_max_depth; }
+
+        /// Constutor default.
+        StreamEvaluator() = default;
+        ~StreamEvaluator() = default;
+        /// Desligar cópia e atribuição.
+        StreamEvaluator( const StreamEvaluator & ) = delete;
+        StreamEvaluator & operator=( const StreamEvaluator & ) = delete;
+
+    private:
+        typedef Token::value_type value_type;
+
+        /// Em que ponto da gramática a máquina parou.
+        enum state_t
+        {
+            TERM = 0, //<! Esperando um <term> (ws, "(" ou o início de um <integer>).
+            MINUS,    //<! Depois do "-" de um <integer>: esperando o primeiro dígito.
+            DIGITS,   //<! Dentro dos dígitos de um <natural_number>.
+            AFTER,    //<! Depois de um <term>: esperando ws, ")", um operador ou o fim.
+            DONE      //<! Já houve um erro de parsing; o resto é ignorado.
+        };
+
+        state_t m_state = TERM;                    //<! Estado atual.
+        bool m_started = false;                    //<! Já apareceu algo além de ws?
+        std::size_t m_pos = 0;                     //<! Coluna do primeiro caractere do próximo pedaço.
+        std::size_t m_begin = 0;                   //<! Coluna onde começa o <integer> atual.
+        value_type m_value = 0;                    //<! Valor (negado) acumulado do <integer> atual.
+        bool m_negative = false;                   //<! O <integer> atual tem "-"?
+        bool m_overflow = false;                   //<! O <integer> atual saiu dos limites?
+        std::size_t m_open = 0;                    //<! Parênteses abertos e ainda não fechados.
+        std::vector< result_t > m_values;          //<! Operandos (e resultados parciais) ainda não consumidos.
+        std::vector< Token::symbol_t > m_ops;      //<! Operadores pendentes e "(" ainda abertos.
+        std::size_t m_max_depth = 0;               //<! Maior `m_values.size() + m_ops.size()` visto.
+        Parser::ParserResult m_parser_status;      //<! Primeiro erro de parsing encontrado.
+        Evaluator::EvaluatorResult m_eval_status;  //<! Primeiro erro de avaliação encontrado.
+
+        /// Registra um erro de parsing; o resto da expressão é ignorado.
+        void fail( Parser::ParserResult::code_t code_, std::size_t col_ );
+        /// Encerra o <integer> atual: valida e empilha o valor. Retorna `false` em caso de erro.
+        bool end_integer( void );
+        /// Empilha um operador ou um "(".
+        void push_op( Token::symbol_t s_ );
+        /// Aplica o operador do topo da pilha aos dois operandos do topo.
+        void reduce( void );
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include "structural_index.h"
+
+#include <cstring> // std::memcpy
+
+#if defined( __x86_64__ ) or defined( __i386__ )
+#include <immintrin.h> // SSE2, AVX2
+#endif
+
+namespace {
+    typedef StructuralIndex::Block Block;
+    /// Classifica `n_` blocos completos de 64 bytes a partir de `data_`.
+    typedef void (*classify_fn)( const char * data_, std::size_t n_, Block * out_ );
+
+    /// Classe de cada byte, usada pela versão escalar.
+    enum char_class_t : unsigned char { C_INVALID = 0, C_DIGIT, C_OP, C_PAREN, C_WS };
+
+    struct ClassTable
+    {
+        unsigned char cls[ 256 ] = {};
+        constexpr ClassTable()
+        {
+            for ( char c = '0'; c <= '9'; ++c ) cls[ static_cast< unsigned char >( c ) ] = C_DIGIT;
+            for ( char c : { '+', '-', '*', '/', '%', '^' } ) cls[ static_cast< unsigned char >( c ) ] = C_OP;
+            cls[ static_cast< unsigned char >( '(' ) ] = C_PAREN;
+            cls[ static_cast< unsigned char >( ')' ) ] = C_PAREN;
+            cls[ static_cast< unsigned char >( ' ' ) ] = C_WS;
+            cls[ static_cast< unsigned char >( '\t' ) ] = C_WS;
+        }
+    };
+    constexpr ClassTable CLASS_TABLE;
+
+    /// Versão escalar: um byte por vez.
+    void classify_scalar( const char * data_, std::size_t n_, Block * out_ )
+    {
+        for ( std::size_t b( 0 ); b < n_; ++b, data_ += 64 )
+        {
+            // Uma máscara por classe, indexada pela própria classe (a de inválidos é a 0).
+            std::uint64_t masks[ 5 ] = {};
+            for ( unsigned i( 0 ); i < 64; ++i )
+                masks[ CLASS_TABLE.cls[ static_cast< unsigned char >( data_[i] ) ] ] |= std::uint64_t( 1 ) << i;
+            out_[b].digit = masks[ C_DIGIT ];
+            out_[b].op = masks[ C_OP ];
+            out_[b].paren = masks[ C_PAREN ];
+            out_[b].ws = masks[ C_WS ];
+            out_[b].invalid = masks[ C_INVALID ];
+        }
+    }
+
+#if defined( __SSE2__ )
+    /// Versão SSE2: 16 bytes por comparação.
+    void classify_sse2( const char * data_, std::size_t n_, Block * out_ )
+    {
+        for ( std::size_t b( 0 ); b < n_; ++b, data_ += 64 )
+        {
+            Block & blk = out_[b];
+            blk = Block{};
+            for ( unsigned i( 0 ); i < 64; i += 16 )
+            {
+                const __m128i x = _mm_loadu_si128( reinterpret_cast< const __m128i * >( data_ + i ) );
+                // Os bytes >= 0x80 são negativos na comparação com sinal, então não passam por dígitos.
+                const __m128i digit = _mm_and_si128( _mm_cmpgt_epi8( x, _mm_set1_epi8( '0' - 1 ) ),
+                                                     _mm_cmplt_epi8( x, _mm_set1_epi8( '9' + 1 ) ) );
+                const __m128i op = _mm_or_si128(
+                        _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( '+' ) ), _mm_cmpeq_epi8( x, _mm_set1_epi8( '-' ) ) ),
+                                      _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( '*' ) ), _mm_cmpeq_epi8( x, _mm_set1_epi8( '/' ) ) ) ),
+                        _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( '%' ) ), _mm_cmpeq_epi8( x, _mm_set1_epi8( '^' ) ) ) );
+                const __m128i paren = _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( '(' ) ), _mm_cmpeq_epi8( x, _mm_set1_epi8( ')' ) ) );
+                const __m128i ws = _mm_or_si128( _mm_cmpeq_epi8( x, _mm_set1_epi8( ' ' ) ), _mm_cmpeq_epi8( x, _mm_set1_epi8( '\t' ) ) );
+
+                blk.digit |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( digit ) ) ) << i;
+                blk.op |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( op ) ) ) << i;
+                blk.paren |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( paren ) ) ) << i;
+                blk.ws |= std::uint64_t( static_cast< unsigned >( _mm_movemask_epi8( ws ) ) ) << i;
+            }
+            blk.invalid = ~( blk.digit | blk.op | blk.paren | blk.ws );
+        }
+    }
+#endif
+
+#if defined( __x86_64__ ) or defined( __i386__ )
+    /// Versão AVX2: 32 bytes por comparação. Compilada para AVX2 mesmo sem `-mavx2`; só é chamada se a CPU suporta.
+    __attribute__(( target( "avx2" ) ))
+    void classify_avx2( const char * data_, std::size_t n_, Block * out_ )
+    {
+        for ( std::size_t b( 0 ); b < n_; ++b, data_ += 64 )
+        {
+            Block & blk = out_[b];
+            blk = Block{};
+            for ( unsigned i( 0 ); i < 64; i += 32 )
+            {
+                const __m256i x = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( data_ + i ) );
+                const __m256i digit = _mm256_and_si256( _mm256_cmpgt_epi8( x, _mm256_set1_epi8( '0' - 1 ) ),
+                                                        _mm256_cmpgt_epi8( _mm256_set1_epi8( '9' + 1 ), x ) );
+                const __m256i op = _mm256_or_si256(
+                        _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '+' ) ), _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '-' ) ) ),
+                                         _mm256_or_si256( _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '*' ) ), _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '/' ) ) ) ),
+                        _mm256_or_si256( _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '%' ) ), _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '^' ) ) ) );
+                const __m256i paren = _mm256_or_si256( _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '(' ) ), _mm256_cmpeq_epi8( x, _mm256_set1_epi8( ')' ) ) );
+                const __m256i ws = _mm256_or_si256( _mm256_cmpeq_epi8( x, _mm256_set1_epi8( ' ' ) ), _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '\t' ) ) );
+
+                blk.digit |= std::uint64_t( static_cast< unsigned >( _mm256_movemask_epi8( digit ) ) ) << i;
+                blk.op |= std::uint64_t( static_cast< unsigned >( _mm256_movemask_epi8( op ) ) ) << i;
+                blk.paren |= std::uint64_t( static_cast< unsigned >( _mm256_movemask_epi8( paren ) ) ) << i;
+                blk.ws |= std::uint64_t( static_cast< unsigned >( _mm256_movemask_epi8( ws ) ) ) << i;
+            }
+            blk.invalid = ~( blk.digit | blk.op | blk.paren | blk.ws );
+        }
+    }
+#endif
+
+    /// A CPU suporta a implementação indicada?
+    bool supported( StructuralIndex::kernel_t k_ )
+    {
+        switch ( k_ )
+        {
+            case StructuralIndex::SCALAR: return true;
+#if defined( __SSE2__ )
+            case StructuralIndex::SSE2: return true;
+#endif
+#if defined( __x86_64__ ) or defined( __i386__ )
+            case StructuralIndex::AVX2:
+                __builtin_cpu_init(); // Pode ser chamada durante a inicialização de objetos estáticos.
+                return __builtin_cpu_supports( "avx2" );
+#endif
+            default: return false;
+        }
+    }
+
+    classify_fn function( StructuralIndex::kernel_t k_ )
+    {
+        switch ( k_ )
+        {
+#if defined( __SSE2__ )
+            case StructuralIndex::SSE2: return classify_sse2;
+#endif
+#if defined( __x86_64__ ) or defined( __i386__ )
+            case StructuralIndex::AVX2: return classify_avx2;
+#endif
+            default: return classify_scalar;
+        }
+    }
+
+    /// A melhor implementação suportada pela CPU.
+    StructuralIndex::kernel_t best_kernel( void )
+    {
+        if ( supported( StructuralIndex::AVX2 ) ) return StructuralIndex::AVX2;
+        if ( supported( StructuralIndex::SSE2 ) ) return StructuralIndex::SSE2;
+        return StructuralIndex::SCALAR;
+    }
+
+    /// Implementação em uso (escolhida no primeiro uso, e não na inicialização estática).
+    struct Dispatch
+    {
+        StructuralIndex::kernel_t kernel;
+        classify_fn classify;
+    };
+    Dispatch & dispatch( void )
+    {
+        static Dispatch d{ best_kernel(), function( best_kernel() ) };
+        return d;
+    }
+}
+
+/*!
+ * \brief Classifica a linha.
+ *
+ * Os blocos completos são classificados direto na memória da linha; o último
+ * bloco (incompleto) é copiado para um bloco completado com zeros, e os bits
+ * além do fim da linha são apagados.
+ */
+void StructuralIndex::build( std::string_view line_ )
+{
+    m_size = line_.size();
+    const std::size_t full = m_size / 64;
+    const std::size_t tail = m_size % 64;
+    m_blocks.resize( full + ( tail > 0 ) );
+
+    const classify_fn classify = dispatch().classify;
+    classify( line_.data(), full, m_blocks.data() );
+    if ( tail > 0 )
+    {
+        char last[ 64 ] = {};
+        std::memcpy( last, line_.data() + 64 * full, tail );
+        classify( last, 1, &m_blocks[ full ] );
+
+        const std::uint64_t valid = ( std::uint64_t( 1 ) << tail ) - 1;
+        Block & blk = m_blocks[ full ];
+        blk.digit &= valid;
+        blk.op &= valid;
+        blk.paren &= valid;
+        blk.ws &= valid;
+        blk.invalid &= valid;
+    }
+}
+
+/*!
+ * \brief Busca pelo primeiro bit zerado da máscara a partir de `pos_`.
+ * Percorre 64 posições por vez: dentro de cada bloco, basta contar os zeros à
+ * direita da máscara invertida.
+ */
+std::size_t StructuralIndex::find_clear( std::uint64_t Block::* mask_, std::size_t pos_ ) const
+{
+    if ( pos_ >= m_size ) return m_size;
+
+    std::size_t b = pos_ >> 6;
+    // Bits antes de `pos_` contam como "marcados", para serem ignorados.
+    std::uint64_t clear = ~( m_blocks[ b ].*mask_ | ( ( std::uint64_t( 1 ) << ( pos_ & 63 ) ) - 1 ) );
+    while ( clear == 0 )
+    {
+        if ( ++b == m_blocks.size() ) return m_size;
+        clear = ~( m_blocks[ b ].*mask_ );
+    }
+    const std::size_t pos = ( b << 6 ) + __builtin_ctzll( clear );
+    return pos < m_size ? pos : m_size;
+}
+
+/// Implementação em uso.
+StructuralIndex::kernel_t StructuralIndex::kernel( void )
+{
+    return dispatch().kernel;
+}
+
+/*!
+ * \brief Troca a implementação usada por todos os índices.
+ * Deve ser chamada antes de haver threads fazendo parsing.
+ * \return `false` (e nada muda) se a CPU não suporta a implementação.
+ */
+bool StructuralIndex::set_kernel( kernel_t k_ )
+{
+    if ( not supported( k_ ) ) return false;
+    dispatch() = Dispatch{ k_, function( k_ ) };
+    return true;
+}
+
+/// Nome da implementação.
+const char * StructuralIndex::kernel_name( kernel_t k_ )
+{
+    switch ( k_ )
+    {
+        case SCALAR: return "scalar";
+        case SSE2:   return "sse2";
+        case AVX2:   return "avx2";
+        default:     return "?";
+    }
+}
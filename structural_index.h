@@ -0,0 +1,87 @@
+#ifndef _STRUCTURAL_INDEX_H_
+#define _STRUCTURAL_INDEX_H_
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+/*!
+ * Índice estrutural de uma expressão (no estilo do *structural index* do simdjson).
+ *
+ * A linha inteira é classificada de uma vez, em blocos de 64 bytes: para cada
+ * bloco guardamos uma máscara de bits por classe de caractere (dígitos,
+ * operadores, parênteses, ws e caracteres inválidos), onde o bit `i` se refere
+ * ao byte `i` do bloco. O parser consulta as máscaras em vez de classificar
+ * cada caractere de novo a cada `peek()`: pular ws ou achar o fim de um número
+ * viram buscas pelo primeiro bit zerado.
+ *
+ * A classificação é vetorizada (AVX2, 32 bytes por instrução, ou SSE2, 16
+ * bytes). A implementação é escolhida em tempo de execução, de acordo com a
+ * CPU; em máquinas sem SIMD é usada uma versão escalar, com o mesmo resultado.
+ */
+class StructuralIndex
+{
+    public:
+        /// Máscaras de um bloco de 64 bytes. Bits além do fim da linha são sempre zero.
+        struct Block
+        {
+            std::uint64_t digit = 0;   //<! '0'-'9'.
+            std::uint64_t op = 0;      //<! '+', '-', '*', '/', '%', '^'.
+            std::uint64_t paren = 0;   //<! '(', ')'.
+            std::uint64_t ws = 0;      //<! ' ', '\t'.
+            std::uint64_t invalid = 0; //<! Qualquer outro caractere.
+        };
+
+        /// Implementações da classificação.
+        enum kernel_t
+        {
+            SCALAR = 0, //<! Um caractere por vez, com uma tabela.
+            SSE2,       //<! 16 bytes por vez.
+            AVX2        //<! 32 bytes por vez.
+        };
+
+        /// Classifica a linha `line_` (a memória do índice é reaproveitada entre as linhas).
+        void build( std::string_view line_ );
+        /// Tamanho da linha indexada.
+        std::size_t size( void ) const { return m_size; }
+        /// Máscaras do bloco `b_`.
+        const Block & block( std::size_t b_ ) const { return m_blocks[ b_ ]; }
+
+        /// O caractere na posição `pos_` é um dígito?
+        bool is_digit( std::size_t pos_ ) const { return test( &Block::digit, pos_ ); }
+        /// O caractere na posição `pos_` é um operador binário?
+        bool is_operator( std::size_t pos_ ) const { return test( &Block::op, pos_ ); }
+        /// O caractere na posição `pos_` é um parêntese?
+        bool is_paren( std::size_t pos_ ) const { return test( &Block::paren, pos_ ); }
+        /// O caractere na posição `pos_` é ws?
+        bool is_ws( std::size_t pos_ ) const { return test( &Block::ws, pos_ ); }
+        /// O caractere na posição `pos_` é inválido?
+        bool is_invalid( std::size_t pos_ ) const { return test( &Block::invalid, pos_ ); }
+
+        /// Primeira posição a partir de `pos_` que não é ws (ou `size()`).
+        std::size_t skip_ws( std::size_t pos_ ) const { return find_clear( &Block::ws, pos_ ); }
+        /// Primeira posição a partir de `pos_` que não é dígito (ou `size()`).
+        std::size_t skip_digits( std::size_t pos_ ) const { return find_clear( &Block::digit, pos_ ); }
+
+        /// Implementação em uso.
+        static kernel_t kernel( void );
+        /// Troca a implementação (para testes e benchmarks); retorna `false` se a CPU não a suporta. Não é thread-safe.
+        static bool set_kernel( kernel_t );
+        /// Nome da implementação.
+        static const char * kernel_name( kernel_t );
+
+    private:
+        std::vector< Block > m_blocks; //<! Máscaras de cada bloco de 64 bytes.
+        std::size_t m_size = 0;        //<! Tamanho da linha.
+
+        /// Testa o bit da posição `pos_` na máscara `mask_`.
+        bool test( std::uint64_t Block::* mask_, std::size_t pos_ ) const
+        {
+            return pos_ < m_size and ( m_blocks[ pos_ >> 6 ].*mask_ >> ( pos_ & 63 ) & 1 );
+        }
+        /// Primeira posição a partir de `pos_` cujo bit em `mask_` é zero (ou `size()`).
+        std::size_t find_clear( std::uint64_t Block::* mask_, std::size_t pos_ ) const;
+};
+
+#endif
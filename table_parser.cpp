@@ -0,0 +1,104 @@
+#include "table_parser.h"
+#include "stats.h"
+
+#include <cassert>   // assert
+
+/*!
+ * \brief Faz o parsing de uma expressão com a tabela LL(1) gerada a partir de `TableGrammar`.
+ *
+ * O laço é o de `LL1Table::run()`; aqui ficam só as ações da gramática, que
+ * geram os tokens (com as mesmas colunas do `Parser`) e decodificam os
+ * inteiros com a política numérica, e a tradução do símbolo em que o
+ * parsing parou para o erro da descrição da gramática.
+ *
+ * \param e_ A expressão que o cliente quer analisar sintaticamente.
+ * \param ctx_ Contexto (reutilizável) que recebe o estado e a lista de tokens.
+ * \return O resultado do parsing (o mesmo de `Parser::parse()`).
+ */
+TableParser::ParserResult TableParser::parse( std::string_view e_, Context & ctx_ ) const
+{
+    typedef TableGrammar G;
+    typedef Parser::Token Token;
+
+    ctx_.expr = e_;
+    ctx_.curr_status = ParserResult( ParserResult::PARSER_OK );
+    ctx_.token_list.clear();
+    Parser::clear_variables( ctx_ );
+    StageTimer timer( Stats::PARSE );
+
+    auto actions = [&]( std::uint8_t action_, std::size_t pos_ ) -> bool
+    {
+        switch ( action_ )
+        {
+            case G::A_OPEN:
+                ctx_.token_list.emplace_back( Token::SCOPE, Token::L_PAREN, 0, pos_ );
+                return true;
+            case G::A_CLOSE: // Depois do ")".
+                ctx_.token_list.emplace_back( Token::SCOPE, Token::R_PAREN, 0, pos_ - 1 );
+                return true;
+            case G::A_OPERATOR:
+                ctx_.token_list.emplace_back( Token::OPERATOR, Token::to_symbol( e_[ pos_ ] ), 0, pos_ );
+                return true;
+            case G::A_INTEGER:
+                ctx_.begin = pos_;
+                ctx_.curr_value = 0;
+                ctx_.curr_overflow = false;
+                ctx_.negative = false;
+                return true;
+            case G::A_NEGATIVE:
+                ctx_.negative = true;
+                return true;
+            case G::A_DIGIT: // Como em Parser::natural_number(): o valor é acumulado negado, até sair dos limites.
+                if ( not ctx_.curr_overflow )
+                    ctx_.curr_overflow = not Numeric::push_digit( ctx_.curr_value, e_[ pos_ ] - '0' );
+                return true;
+            case G::A_END_INTEGER:
+                if ( not ctx_.negative and not ctx_.curr_overflow )
+                    ctx_.curr_overflow = not Numeric::negate( ctx_.curr_value );
+                if ( ctx_.curr_overflow )
+                {
+                    ctx_.curr_status = ParserResult( ParserResult::INTEGER_OUT_OF_RANGE, ctx_.begin );
+                    return false;
+                }
+                ctx_.token_list.emplace_back( Token::OPERAND, Token::NONE, ctx_.curr_value, ctx_.begin );
+                return true;
+            case G::A_VARIABLE: // Sem variáveis, a letra é só um <integer> mal formado.
+                if ( not ctx_.variables )
+                {
+                    ctx_.curr_status = ParserResult( ParserResult::ILL_FORMED_INTEGER, pos_ );
+                    return false;
+                }
+                ctx_.begin = pos_;
+                return true;
+            case G::A_END_VARIABLE:
+            {
+                const std::string_view name = e_.substr( ctx_.begin, pos_ - ctx_.begin );
+                Token::value_type number = 0;
+                if ( not Parser::variable_number( ctx_, name, number ) )
+                {
+                    // Variáveis demais: o número não cabe no valor do token.
+                    ctx_.curr_status = ParserResult( ParserResult::INTEGER_OUT_OF_RANGE, ctx_.begin );
+                    return false;
+                }
+                ctx_.token_list.emplace_back( Token::VARIABLE, Token::NONE, number, ctx_.begin );
+                return true;
+            }
+            default:
+                assert( false );
+                return false;
+        }
+    };
+
+    std::size_t pos = 0;
+    const LL1Symbol stop = Table::run( e_, ctx_.stack, actions, pos );
+    ctx_.curr_symb = e_.begin() + pos;
+    // Uma ação que falha já registrou o seu erro; os demais vêm da descrição da gramática.
+    if ( stop.kind == LL1Symbol::NONTERMINAL )
+        ctx_.curr_status = ParserResult( pos == e_.size() ? G::errors_at_end[ stop.id ] : G::errors[ stop.id ], pos );
+    else if ( stop.kind == LL1Symbol::TERMINAL )
+        ctx_.curr_status = ParserResult( G::terminal_errors[ stop.id ], pos );
+    assert( ( stop.kind == LL1Symbol::NONE ) == ( ctx_.curr_status.type == ParserResult::PARSER_OK ) );
+
+    if ( Stats::enabled() ) Stats::local().add_tokens( ctx_.token_list.size() );
+    return ctx_.curr_status;
+}
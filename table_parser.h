@@ -0,0 +1,187 @@
+#ifndef _TABLE_PARSER_H_
+#define _TABLE_PARSER_H_
+
+#include <cstdint>     // std::uint8_t
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include "parser.h" // Parser::Context, Parser::ParserResult
+#include "ll1.h"    // LL1Table
+
+/*!
+ * Descrição da gramática do BARES para o gerador LL(1) (ll1.h).
+ *
+ * É a mesma linguagem do `Parser` (parser.h), reescrita caractere a
+ * caractere e fatorada para LL(1): os ws são aceitos logo depois de cada
+ * <term> e de cada operador, e o resto da <expr> (`TAIL`) é um operador
+ * seguido de outro <term>, ou nada.
+ *
+ *   LINE     := SPACES EXPR $
+ *   EXPR     := TERM TAIL                  (a expressão inteira)
+ *   INNER    := TERM TAIL                  (entre parênteses)
+ *   TERM     := @open "(" SPACES INNER ")" @close SPACES
+ *             | @integer INTEGER @end_integer SPACES
+ *             | @variable LETTER NAME @end_variable SPACES
+ *   TAIL     := @operator OPERATOR SPACES TERM TAIL | ε
+ *   OPERATOR := "+" | "-" | "*" | "/" | "%" | "^"
+ *   INTEGER  := "0" | "-" @negative NATURAL | NATURAL
+ *   NATURAL  := @digit NON_ZERO DIGITS
+ *   DIGITS   := @digit "0" DIGITS | @digit NON_ZERO DIGITS | ε
+ *   NAME     := LETTER NAME | "0" NAME | NON_ZERO NAME | ε
+ *   SPACES   := WS SPACES | ε
+ *
+ * As ações (`@`) geram os tokens e decodificam os inteiros (veja
+ * table_parser.cpp). Os códigos de erro também fazem parte da descrição:
+ * quando um não-terminal não tem produção para o caractere atual, o erro é
+ * `errors_at_end` (no fim da linha) ou `errors` (antes do fim); quando um
+ * terminal esperado não vem, o erro é `terminal_errors`. Com eles o
+ * `TableParser` dá os mesmos erros, nas mesmas colunas, que o `Parser`.
+ *
+ * Um novo operador ou escopo é uma linha em `lexemes` e uma produção a mais
+ * (e a ação que gera o seu token), sem mudar o laço do parser.
+ */
+struct TableGrammar
+{
+    typedef Parser::ParserResult ParserResult;
+
+    /// Terminais (classes de caracteres).
+    enum terminal_t : std::uint8_t
+    {
+        L_PAREN = 0, R_PAREN, PLUS, MINUS, TIMES, DIVIDED, MOD, POWER,
+        ZERO, NON_ZERO, WS, LETTER,
+        END,   //<! Fim da linha.
+        OTHER, //<! Qualquer outro caractere (inválido).
+        N_TERMINALS_
+    };
+
+    /// Não-terminais.
+    enum nonterminal_t : std::uint8_t
+    {
+        LINE = 0, EXPR, INNER, TERM, TAIL, OPERATOR, INTEGER, NATURAL, DIGITS, NAME, SPACES,
+        N_NONTERMINALS_
+    };
+
+    /// Ações semânticas (table_parser.cpp).
+    enum action_t : std::uint8_t
+    {
+        A_OPEN = 0,     //<! Token do "(".
+        A_CLOSE,        //<! Token do ")".
+        A_OPERATOR,     //<! Token do operador binário.
+        A_INTEGER,      //<! Começo de um <integer>.
+        A_NEGATIVE,     //<! O <integer> tem "-".
+        A_DIGIT,        //<! Acumula um dígito.
+        A_END_INTEGER,  //<! Verifica os limites e gera o token do <integer>.
+        A_VARIABLE,     //<! Começo de uma <variable> (erro, se a linha não é uma fórmula).
+        A_END_VARIABLE  //<! Numera a <variable> e gera o seu token.
+    };
+
+    static constexpr std::size_t N_TERMINALS = N_TERMINALS_;
+    static constexpr std::size_t N_NONTERMINALS = N_NONTERMINALS_;
+    static constexpr std::uint8_t START = LINE;
+
+    /// Caracteres de cada terminal (`END` e `OTHER` não têm).
+    static constexpr std::string_view lexemes[ N_TERMINALS ] = {
+        "(", ")", "+", "-", "*", "/", "%", "^",
+        "0", "123456789", " \t", "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_",
+        "", ""
+    };
+
+    static constexpr LL1Production productions[] = {
+        { LINE,     { ll1_n( SPACES ), ll1_n( EXPR ), ll1_t( END ) } },
+        { EXPR,     { ll1_n( TERM ), ll1_n( TAIL ) } },
+        { INNER,    { ll1_n( TERM ), ll1_n( TAIL ) } },
+        { TERM,     { ll1_a( A_OPEN ), ll1_t( L_PAREN ), ll1_n( SPACES ), ll1_n( INNER ), ll1_t( R_PAREN ), ll1_a( A_CLOSE ), ll1_n( SPACES ) } },
+        { TERM,     { ll1_a( A_INTEGER ), ll1_n( INTEGER ), ll1_a( A_END_INTEGER ), ll1_n( SPACES ) } },
+        { TERM,     { ll1_a( A_VARIABLE ), ll1_t( LETTER ), ll1_n( NAME ), ll1_a( A_END_VARIABLE ), ll1_n( SPACES ) } },
+        { TAIL,     { ll1_a( A_OPERATOR ), ll1_n( OPERATOR ), ll1_n( SPACES ), ll1_n( TERM ), ll1_n( TAIL ) } },
+        { TAIL,     {} },
+        { OPERATOR, { ll1_t( PLUS ) } },
+        { OPERATOR, { ll1_t( MINUS ) } },
+        { OPERATOR, { ll1_t( TIMES ) } },
+        { OPERATOR, { ll1_t( DIVIDED ) } },
+        { OPERATOR, { ll1_t( MOD ) } },
+        { OPERATOR, { ll1_t( POWER ) } },
+        { INTEGER,  { ll1_t( ZERO ) } },
+        { INTEGER,  { ll1_t( MINUS ), ll1_a( A_NEGATIVE ), ll1_n( NATURAL ) } },
+        { INTEGER,  { ll1_n( NATURAL ) } },
+        { NATURAL,  { ll1_a( A_DIGIT ), ll1_t( NON_ZERO ), ll1_n( DIGITS ) } },
+        { DIGITS,   { ll1_a( A_DIGIT ), ll1_t( ZERO ), ll1_n( DIGITS ) } },
+        { DIGITS,   { ll1_a( A_DIGIT ), ll1_t( NON_ZERO ), ll1_n( DIGITS ) } },
+        { DIGITS,   {} },
+        { NAME,     { ll1_t( LETTER ), ll1_n( NAME ) } },
+        { NAME,     { ll1_t( ZERO ), ll1_n( NAME ) } },
+        { NAME,     { ll1_t( NON_ZERO ), ll1_n( NAME ) } },
+        { NAME,     {} },
+        { SPACES,   { ll1_t( WS ), ll1_n( SPACES ) } },
+        { SPACES,   {} },
+    };
+
+    /// Erro de cada não-terminal sem produção para o caractere atual, antes do fim da linha.
+    static constexpr ParserResult::code_t errors[ N_NONTERMINALS ] = {
+        ParserResult::ILL_FORMED_INTEGER, // LINE
+        ParserResult::ILL_FORMED_INTEGER, // EXPR
+        ParserResult::ILL_FORMED_INTEGER, // INNER
+        ParserResult::ILL_FORMED_INTEGER, // TERM
+        ParserResult::PARSER_OK,          // TAIL (anulável: nunca falha)
+        ParserResult::PARSER_OK,          // OPERATOR (só é previsto diante de um operador)
+        ParserResult::PARSER_OK,          // INTEGER (só é previsto diante de "0", "-" ou dígito)
+        ParserResult::ILL_FORMED_INTEGER, // NATURAL
+        ParserResult::PARSER_OK,          // DIGITS
+        ParserResult::PARSER_OK,          // NAME
+        ParserResult::PARSER_OK,          // SPACES
+    };
+
+    /// Erro de cada não-terminal sem produção no fim da linha.
+    static constexpr ParserResult::code_t errors_at_end[ N_NONTERMINALS ] = {
+        ParserResult::UNEXPECTED_END_OF_EXPRESSION, // LINE
+        ParserResult::UNEXPECTED_END_OF_EXPRESSION, // EXPR
+        ParserResult::MISSING_TERM,                 // INNER
+        ParserResult::MISSING_TERM,                 // TERM
+        ParserResult::PARSER_OK,                    // TAIL
+        ParserResult::PARSER_OK,                    // OPERATOR
+        ParserResult::PARSER_OK,                    // INTEGER
+        ParserResult::ILL_FORMED_INTEGER,           // NATURAL
+        ParserResult::PARSER_OK,                    // DIGITS
+        ParserResult::PARSER_OK,                    // NAME
+        ParserResult::PARSER_OK,                    // SPACES
+    };
+
+    /// Erro de cada terminal esperado que não veio (só ")" e o fim da linha podem faltar).
+    static constexpr ParserResult::code_t terminal_errors[ N_TERMINALS ] = {
+        ParserResult::PARSER_OK, ParserResult::MISSING_CLOSING_PARENTHESIS,
+        ParserResult::PARSER_OK, ParserResult::PARSER_OK, ParserResult::PARSER_OK,
+        ParserResult::PARSER_OK, ParserResult::PARSER_OK, ParserResult::PARSER_OK,
+        ParserResult::PARSER_OK, ParserResult::PARSER_OK, ParserResult::PARSER_OK, ParserResult::PARSER_OK,
+        ParserResult::EXTRANEOUS_SYMBOL, // END
+        ParserResult::PARSER_OK,
+    };
+};
+
+/*!
+ * Parser dirigido pela tabela LL(1) gerada, em tempo de compilação, a partir de `TableGrammar`.
+ *
+ * Tem a mesma interface e os mesmos resultados do `Parser`: os mesmos
+ * tokens, os mesmos erros e as mesmas colunas, no mesmo contexto (com a
+ * pilha de símbolos a mais). Em vez de um método por regra da gramática, o
+ * parsing é o laço de `LL1Table::run()`, e as ações da gramática preenchem a
+ * lista de tokens do contexto.
+ */
+class TableParser
+{
+    public:
+        typedef Parser::ParserResult ParserResult;
+        typedef LL1Table< TableGrammar > Table; //<! Tabelas geradas a partir da gramática.
+
+        /// Estado de uma operação de parsing (o mesmo do `Parser`, mais a pilha de símbolos).
+        struct Context : Parser::Context
+        {
+            std::vector< LL1Symbol > stack; //<! Pilha de símbolos (reaproveitada entre as expressões).
+            std::size_t begin = 0;          //<! Coluna do <integer> ou da <variable> atual.
+            bool negative = false;          //<! O <integer> atual tem "-"?
+        };
+
+        /// Recebe uma expressão, realiza o parsing no contexto indicado e retorna o resultado.
+        ParserResult parse( std::string_view e_, Context & ctx_ ) const;
+};
+
+#endif
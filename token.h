@@ -1,38 +1,113 @@
 #ifndef _TOKEN_H_
 #define _TOKEN_H_
 
-#include <string>
+#include <cstdint>  // std::uint8_t, std::uint32_t
 #include <iostream>
 
-/// Estrutura que representa um token, composto por seu valor (string) e seu tipo (enum).
-struct Token
+#include "numeric_policy.h" // Numeric
+
+/*!
+ * Tipos e conversões comuns aos tokens de todas as larguras (`BasicToken`).
+ */
+struct TokenBase
 {
     public:
-        enum token_t
+        typedef std::uint32_t col_type; //<! Coluna do token dentro da expressão.
+
+        enum token_t : std::uint8_t
         {
             OPERAND = 0, // Basicamente números.
             OPERATOR,    // "+", "-", "*", "/", "%", "^".
-            SCOPE        // "(" ou ")"
+            SCOPE,       // "(" ou ")"
+            VARIABLE     // Uma variável (o valor do token é o índice dela).
         };
 
-        std::string value; //<! Valor do token.
-        token_t type;      //<! Tipo de token: operando, operador, escopo.
+        /// Símbolo de um operador ou escopo. Operandos usam `NONE`.
+        enum symbol_t : std::uint8_t
+        {
+            NONE = 0,
+            PLUS,    //<! "+"
+            MINUS,   //<! "-"
+            TIMES,   //<! "*"
+            DIVIDED, //<! "/"
+            MOD,     //<! "%"
+            POWER,   //<! "^"
+            L_PAREN, //<! "("
+            R_PAREN  //<! ")"
+        };
+
+        /// Converte um caractere para o símbolo correspondente (`NONE` se não for operador ou escopo).
+        static constexpr symbol_t to_symbol( char c_ )
+        {
+            switch( c_ )
+            {
+                case '+': return PLUS;
+                case '-': return MINUS;
+                case '*': return TIMES;
+                case '/': return DIVIDED;
+                case '%': return MOD;
+                case '^': return POWER;
+                case '(': return L_PAREN;
+                case ')': return R_PAREN;
+                default : return NONE;
+            }
+        }
+
+        /// Converte um símbolo de volta para o caractere correspondente.
+        static char to_char( symbol_t s_ )
+        {
+            static const char chars[] = { '?', '+', '-', '*', '/', '%', '^', '(', ')' };
+            return chars[s_];
+        }
+};
+
+/*!
+ * Estrutura compacta que representa um token.
+ *
+ * Em vez de guardar o texto do token em uma `std::string`, guardamos apenas o
+ * tipo do token, o símbolo (no caso de operadores e escopo), o valor do operando
+ * já decodificado e a coluna onde o token começa na expressão.
+ * Com operandos de 16 bits, tudo isso ocupa 8 bytes e não exige nenhuma alocação dinâmica.
+ *
+ * \tparam Value Tipo do valor de um operando (o `value_type` da política numérica).
+ */
+template < typename Value >
+struct BasicToken : TokenBase
+{
+    public:
+        typedef Value value_type; //<! Valor de um operando.
+
+        value_type value; //<! Valor do operando, ou índice da variável (zero para operadores e escopo).
+        token_t type;     //<! Tipo de token: operando, operador, escopo.
+        symbol_t symbol;  //<! Símbolo do operador ou escopo.
+        col_type col;     //<! Coluna onde o token começa na expressão.
 
         /// Construtor default.
-        explicit Token( std::string v_="", token_t t_ = OPERAND )
+        constexpr explicit BasicToken( token_t t_ = OPERAND, symbol_t s_ = NONE, value_type v_ = 0, col_type c_ = 0 )
             : value( v_ )
             , type( t_ )
+            , symbol( s_ )
+            , col( c_ )
         {/* empty */}
 
-        friend std::ostream & operator<<( std::ostream& os_, const Token & t_ )
+        friend std::ostream & operator<<( std::ostream& os_, const BasicToken & t_ )
         {
-            std::string types[] = { "OPERAND", "OPERATOR", "SCOPE" };
+            static const char * types[] = { "OPERAND", "OPERATOR", "SCOPE", "VARIABLE" };
 
-            os_ << "<" << t_.value << "," << types[t_.type] << ">";
+            os_ << "<";
+            if ( t_.type == OPERAND ) os_ << t_.value;
+            else if ( t_.type == VARIABLE ) os_ << "$" << t_.value;
+            else os_ << to_char( t_.symbol );
+            os_ << "," << types[t_.type] << ">";
 
             return os_;
         }
 
 };
 
+/// Token da política numérica do programa.
+typedef BasicToken< Numeric::value_type > Token;
+
+static_assert( sizeof( BasicToken< Int16Policy::value_type > ) == 8, "Token deve ocupar apenas 8 bytes." );
+
 #endif